@@ -0,0 +1,481 @@
+// The MIT License( MIT )
+//
+// Copyright( c ) 2020 Scott Aron Bloom
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sub-license, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+// Micro and macro benchmarks of the calculators hot paths, with JSON baselines
+//
+// Usage: narcissistic-bench [-filter <substring>] [-repeat <n>] [-no_macro] [-list]
+//                           [-save <baseline.json>] [-compare <baseline.json>] [-threshold <percent>]
+//
+// Every benchmark reports the median time per operation over its repeats (macro workloads
+// report seconds per run).  -save writes the results as a baseline, -compare reads a baseline
+// and flags every benchmark that is slower than the baseline by more than the threshold
+// (10% by default), the exit code is 2 when there is a regression.  When the RAPL energy counters
+// are readable the macro workloads also report "<name>/joules", compared the same way.
+
+#include "NarcissisticNumCalculator.h"
+#include "NarcissisticEngine.h"
+#include "NarcissisticThreadPool.h"
+#include "NarcissisticEnergy.h"
+#include "SABUtils/utils.h"
+
+#include <QCoreApplication>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <list>
+#include <map>
+#include <regex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// friend of CNarcissisticNumCalculator, so the partition queue and result list can be measured directly
+class CNarcissisticBench
+{
+public:
+    bool parse( int argc, char** argv )
+    {
+        for ( int ii = 1; ii < argc; ++ii )
+        {
+            auto hasValue = ( ii + 1 ) < argc;
+            if ( hasValue && ( strcmp( argv[ ii ], "-filter" ) == 0 ) )
+                fFilter = argv[ ++ii ];
+            else if ( hasValue && ( strcmp( argv[ ii ], "-repeat" ) == 0 ) )
+                fRepeat = std::max( 1, atoi( argv[ ++ii ] ) );
+            else if ( hasValue && ( strcmp( argv[ ii ], "-save" ) == 0 ) )
+                fSaveFile = argv[ ++ii ];
+            else if ( hasValue && ( strcmp( argv[ ii ], "-compare" ) == 0 ) )
+                fCompareFile = argv[ ++ii ];
+            else if ( hasValue && ( strcmp( argv[ ii ], "-threshold" ) == 0 ) )
+                fThreshold = std::max( 0.0, atof( argv[ ++ii ] ) );
+            else if ( strcmp( argv[ ii ], "-no_macro" ) == 0 )
+                fMacro = false;
+            else if ( strcmp( argv[ ii ], "-list" ) == 0 )
+                fListOnly = true;
+            else
+            {
+                std::cerr << "unknown switch: '" << argv[ ii ] << "'\n";
+                return false;
+            }
+        }
+        return true;
+    }
+
+    int run()
+    {
+        registerBenchmarks();
+        if ( fListOnly )
+        {
+            for ( auto&& ii : fBenchmarks )
+                std::cout << ii.fName << "\n";
+            return 0;
+        }
+
+        std::map< std::string, double > baseline;
+        if ( !fCompareFile.empty() && !loadBaseline( fCompareFile, baseline ) )
+            return 1;
+
+        int numRegressions = 0;
+        auto report = [ this, &baseline, &numRegressions ]( const std::string& name, double value, const char* unit )
+        {
+            fResults[ name ] = value;
+
+            std::cout << std::left << std::setw( 48 ) << name << std::right << std::setw( 14 ) << value << " " << unit;
+            auto pos = baseline.find( name );
+            if ( pos != baseline.end() && ( ( *pos ).second > 0.0 ) )
+            {
+                auto change = 100.0 * ( value - ( *pos ).second ) / ( *pos ).second;
+                std::cout << " (" << std::showpos << std::fixed << std::setprecision( 1 ) << change << "%" << std::noshowpos << std::defaultfloat << std::setprecision( 6 ) << ")";
+                if ( change > fThreshold )
+                {
+                    std::cout << " REGRESSION";
+                    numRegressions++;
+                }
+            }
+            std::cout << std::endl;
+        };
+
+        for ( auto&& ii : fBenchmarks )
+        {
+            if ( !fFilter.empty() && ( ii.fName.find( fFilter ) == std::string::npos ) )
+                continue;
+            if ( ii.fMacro && !fMacro )
+                continue;
+
+            double joules = -1.0;
+            auto value = measure( ii, joules );
+            report( ii.fName, value, ii.fMacro ? "s" : "ns/op" );
+            if ( joules >= 0 )
+                report( ii.fName + "/joules", joules, "J" );
+        }
+
+        if ( !fSaveFile.empty() && !saveBaseline( fSaveFile ) )
+            return 1;
+
+        if ( numRegressions )
+        {
+            std::cout << numRegressions << " benchmark(s) regressed by more than " << fThreshold << "%\n";
+            return 2;
+        }
+        return 0;
+    }
+private:
+    struct SBenchmark
+    {
+        std::string fName;
+        bool fMacro{ false };
+        std::function< uint64_t() > fRun; // returns the number of operations timed
+        std::function< void() > fSetup; // untimed, run before every repeat
+    };
+
+    void add( const std::string& name, const std::function< uint64_t() >& func, const std::function< void() >& setup = {} )
+    {
+        fBenchmarks.push_back( { name, false, func, setup } );
+    }
+
+    void addMacro( const std::string& name, const std::function< uint64_t() >& func )
+    {
+        fBenchmarks.push_back( { name, true, func, {} } );
+    }
+
+    // joules is only set for the macro workloads, the micro ones are too short for the RAPL resolution
+    double measure( const SBenchmark& benchmark, double& joules ) const
+    {
+        std::vector< double > values;
+        auto numRepeats = benchmark.fMacro ? 1 : fRepeat;
+        for ( int ii = 0; ii < numRepeats; ++ii )
+        {
+            if ( benchmark.fSetup )
+                benchmark.fSetup();
+            CNarcissisticEnergy energy;
+            auto start = std::chrono::steady_clock::now();
+            auto numOps = benchmark.fRun();
+            auto seconds = std::chrono::duration< double >( std::chrono::steady_clock::now() - start ).count();
+            energy.sample();
+            if ( benchmark.fMacro && energy.available() )
+                joules = energy.joules();
+            if ( benchmark.fMacro )
+                values.push_back( seconds );
+            else
+                values.push_back( 1e9 * seconds / std::max< uint64_t >( numOps, 1 ) );
+        }
+        std::sort( values.begin(), values.end() );
+        return values[ values.size() / 2 ];
+    }
+
+    // a macro run prints its own report, which is noise here
+    static std::chrono::system_clock::duration runQuietly( CNarcissisticNumCalculator& calculator )
+    {
+        std::ostringstream discard;
+        auto prev = std::cout.rdbuf( discard.rdbuf() );
+        auto retVal = calculator.run();
+        std::cout.rdbuf( prev );
+        return retVal;
+    }
+
+    static void setupCalculator( CNarcissisticNumCalculator& calculator, int base )
+    {
+        calculator.setBase( base );
+        calculator.setUseIndex( false );
+        calculator.setUseKnownTable( false );
+        calculator.setNumThreads( std::max( 1U, std::thread::hardware_concurrency() ) );
+    }
+
+    void registerBenchmarks()
+    {
+        const uint64_t kNumValues = 200000;
+        for ( int base : { 2, 10, 16, 36 } )
+        {
+            auto maxDigits = CNarcissisticEngine::computeNumDigits( std::numeric_limits< uint64_t >::max(), base );
+            auto prefix = "b" + std::to_string( base );
+            for ( int numDigits : { 3, maxDigits / 2, maxDigits - 1 } )
+            {
+                auto name = prefix + "/k" + std::to_string( numDigits );
+                auto first = CNarcissisticEngine::powerSat( base, numDigits - 1 );
+
+                add( "isNarcissistic/" + name,
+                    [ base, first, kNumValues ]()
+                    {
+                        uint64_t numFound = 0;
+                        for ( auto ii = first; ii < first + kNumValues; ++ii )
+                        {
+                            bool aOK;
+                            numFound += NUtils::isNarcissistic( ii, base, aOK ) ? 1 : 0;
+                        }
+                        fSink += numFound;
+                        return kNumValues;
+                    } );
+
+                for ( auto&& engineName : CNarcissisticEngineRegistry::instance().names() )
+                {
+                    add( "engine/" + engineName + "/" + name,
+                        [ engineName, base, numDigits, first, kNumValues ]()
+                        {
+                            auto engine = CNarcissisticEngineRegistry::instance().create( engineName, base, numDigits );
+                            engine->findInRange( first, first + kNumValues, []( uint64_t value ) { fSink += value; }, {} );
+                            return kNumValues;
+                        } );
+                }
+            }
+
+            add( "power/NUtils/" + prefix,
+                [ base ]()
+                {
+                    uint64_t numOps = 0;
+                    for ( int jj = 0; jj < 1000; ++jj )
+                    {
+                        for ( uint64_t digit = 0; digit < static_cast< uint64_t >( base ); ++digit )
+                        {
+                            for ( uint64_t exp = 1; exp <= 8; ++exp, ++numOps )
+                                fSink += NUtils::power( digit, exp );
+                        }
+                    }
+                    return numOps;
+                } );
+            add( "power/powerSat/" + prefix,
+                [ base ]()
+                {
+                    uint64_t numOps = 0;
+                    for ( int jj = 0; jj < 1000; ++jj )
+                    {
+                        for ( uint64_t digit = 0; digit < static_cast< uint64_t >( base ); ++digit )
+                        {
+                            for ( uint64_t exp = 1; exp <= 8; ++exp, ++numOps )
+                                fSink += CNarcissisticEngine::powerSat( digit, exp );
+                        }
+                    }
+                    return numOps;
+                } );
+
+            add( "digits/division/" + prefix,
+                [ base, kNumValues ]()
+                {
+                    for ( uint64_t ii = 1000000; ii < 1000000 + kNumValues; ++ii )
+                    {
+                        for ( auto curr = ii; curr; curr /= base )
+                            fSink += curr % base;
+                    }
+                    return kNumValues;
+                } );
+            add( "digits/toString/" + prefix,
+                [ base, kNumValues ]()
+                {
+                    for ( uint64_t ii = 1000000; ii < 1000000 + kNumValues; ++ii )
+                        fSink += NUtils::toString( ii, base ).length();
+                    return kNumValues;
+                } );
+        }
+
+        // per partition handed out
+        add( "partition/range",
+            []()
+            {
+                CNarcissisticNumCalculator calculator( false );
+                setupCalculator( calculator, 10 );
+                calculator.setByRange( true );
+                calculator.setRange( std::make_pair( 0ULL, 1000000000ULL ) );
+                calculator.setNumPerThread( 1000 );
+                calculator.partition( {}, false );
+
+                uint64_t numPartitions = 0;
+                CNarcissisticNumCalculator::TPartitionSet partition;
+                uint64_t index = 0;
+                std::unique_lock< std::mutex > lock( calculator.fMutex );
+                while ( calculator.takeNextPartition( partition, index ) )
+                    numPartitions++;
+                return numPartitions;
+            } );
+        // per value partitioned
+        add( "partition/list",
+            []()
+            {
+                CNarcissisticNumCalculator calculator( false );
+                setupCalculator( calculator, 10 );
+                std::list< uint64_t > values;
+                for ( uint64_t ii = 0; ii < 1000000; ++ii )
+                    values.push_back( ii * 7919 );
+                calculator.setByRange( false );
+                calculator.setNumbersList( values );
+                calculator.setNumPerThread( 100 );
+                calculator.partition( {}, false );
+                return values.size();
+            } );
+
+        for ( size_t numThreads : { 1U, 4U, 16U } )
+        {
+            auto suffix = "/" + std::to_string( numThreads ) + "threads";
+            // per partition, every partition is empty so this is purely the pool and queue overhead
+            add( "pool/contention" + suffix,
+                [ numThreads ]()
+                {
+                    const uint64_t kNumPartitions = 200000;
+                    CEmptyJob job( kNumPartitions );
+                    auto&& pool = CNarcissisticThreadPool::instance();
+                    pool.addJob( &job, 0, 1.0, numThreads );
+                    while ( job.fCompleted < kNumPartitions )
+                        std::this_thread::sleep_for( std::chrono::microseconds( 100 ) );
+                    pool.removeJob( &job );
+                    return kNumPartitions;
+                } );
+
+            add( "addNarcissisticValue" + suffix,
+                [ numThreads ]()
+                {
+                    const uint64_t kNumPerThread = 100000;
+                    CNarcissisticNumCalculator calculator( false );
+                    std::vector< std::thread > threads;
+                    for ( size_t ii = 0; ii < numThreads; ++ii )
+                    {
+                        threads.emplace_back(
+                            [ &calculator, kNumPerThread ]()
+                            {
+                                for ( uint64_t jj = 0; jj < kNumPerThread; ++jj )
+                                    calculator.addNarcissisticValue( jj );
+                            } );
+                    }
+                    for ( auto&& ii : threads )
+                        ii.join();
+                    return numThreads * kNumPerThread;
+                } );
+        }
+
+        addMacro( "macro/b10/1e9",
+            []()
+            {
+                CNarcissisticNumCalculator calculator( false );
+                setupCalculator( calculator, 10 );
+                calculator.setByRange( true );
+                calculator.setRange( std::make_pair( 0ULL, 1000000000ULL ) );
+                calculator.setNumPerThread( 1000000 );
+                runQuietly( calculator );
+                return 1;
+            } );
+        addMacro( "macro/b36/1e8",
+            []()
+            {
+                CNarcissisticNumCalculator calculator( false );
+                setupCalculator( calculator, 36 );
+                calculator.setByRange( true );
+                calculator.setRange( std::make_pair( 0ULL, 100000000ULL ) );
+                calculator.setNumPerThread( 1000000 );
+                runQuietly( calculator );
+                return 1;
+            } );
+    }
+
+    // the baseline is a flat object of benchmark name to value
+    bool saveBaseline( const std::string& fileName ) const
+    {
+        std::ofstream oss( fileName );
+        if ( !oss )
+        {
+            std::cerr << "Could not open '" << fileName << "' for writing\n";
+            return false;
+        }
+        oss << "{\n";
+        std::string sep;
+        for ( auto&& ii : fResults )
+        {
+            oss << sep << "    \"" << ii.first << "\": " << std::setprecision( 9 ) << ii.second;
+            sep = ",\n";
+        }
+        oss << "\n}\n";
+        return true;
+    }
+
+    bool loadBaseline( const std::string& fileName, std::map< std::string, double >& baseline ) const
+    {
+        std::ifstream iss( fileName );
+        if ( !iss )
+        {
+            std::cerr << "Could not open baseline '" << fileName << "'\n";
+            return false;
+        }
+        std::stringstream buffer;
+        buffer << iss.rdbuf();
+        auto text = buffer.str();
+
+        std::regex entry( "\"([^\"]+)\"\\s*:\\s*([-+0-9.eE]+)" );
+        for ( auto ii = std::sregex_iterator( text.begin(), text.end(), entry ); ii != std::sregex_iterator(); ++ii )
+            baseline[ ( *ii )[ 1 ].str() ] = std::stod( ( *ii )[ 2 ].str() );
+        return true;
+    }
+
+    class CEmptyJob : public CNarcissisticJob
+    {
+    public:
+        CEmptyJob( uint64_t numPartitions ) :
+            fRemaining( numPartitions )
+        {
+        }
+        bool hasWork() const override { return fRemaining > 0; }
+        bool runNextPartition() override
+        {
+            std::unique_lock< std::mutex > lock( fMutex );
+            if ( fRemaining == 0 )
+                return false;
+            fRemaining--;
+            fCompleted++;
+            return true;
+        }
+
+        std::mutex fMutex;
+        std::atomic< uint64_t > fRemaining;
+        std::atomic< uint64_t > fCompleted{ 0 };
+    };
+
+    static volatile uint64_t fSink; // keeps the optimizer from removing the measured work
+
+    std::string fFilter;
+    int fRepeat{ 5 };
+    bool fMacro{ true };
+    bool fListOnly{ false };
+    std::string fSaveFile;
+    std::string fCompareFile;
+    double fThreshold{ 10.0 };
+    std::list< SBenchmark > fBenchmarks;
+    std::map< std::string, double > fResults;
+};
+
+volatile uint64_t CNarcissisticBench::fSink{ 0 };
+
+int main( int argc, char** argv )
+{
+    QCoreApplication appl( argc, argv ); // the calculator reads its defaults via QSettings
+    appl.setOrganizationDomain( "http://towel42.com" );
+    appl.setOrganizationName( "Scott Aron Bloom" );
+    appl.setApplicationName( "Narcissistic Number Calculator" );
+
+    CNarcissisticBench bench;
+    if ( !bench.parse( argc, argv ) )
+        return 1;
+    return bench.run();
+}
@@ -0,0 +1,198 @@
+// The MIT License( MIT )
+//
+// Copyright( c ) 2020 Scott Aron Bloom
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sub-license, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+
+// Client for the query daemon (NarcissisticNumbers -daemon [<name>])
+//
+// Usage: narcissistic-client [-server <name>] [-base <b>] [-numbers <n> ...] [-min <n> -max <n>] [-repeat <n>] [-time]
+//
+// With neither -numbers nor -min/-max the requests are read from stdin, one per line in the daemon's
+// format without the id ("list <base> <value> ..." or "range <base> <min> <max>"), all of them are sent
+// as one batch.  The narcissistic numbers of each request are printed one per line, -time reports the
+// round trip latency of each request.
+
+#include "NarcissisticDaemon.h"
+
+#include <QCoreApplication>
+#include <QLocalSocket>
+
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace
+{
+    class CClient
+    {
+    public:
+        bool parse( int argc, char** argv )
+        {
+            for ( int ii = 1; ii < argc; ++ii )
+            {
+                auto hasValue = ( ii + 1 ) < argc;
+                if ( hasValue && ( strcmp( argv[ ii ], "-server" ) == 0 ) )
+                    fServerName = QString::fromLocal8Bit( argv[ ++ii ] );
+                else if ( hasValue && ( strcmp( argv[ ii ], "-base" ) == 0 ) )
+                    fBase = atoi( argv[ ++ii ] );
+                else if ( hasValue && ( strcmp( argv[ ii ], "-min" ) == 0 ) )
+                    fMin = argv[ ++ii ];
+                else if ( hasValue && ( strcmp( argv[ ii ], "-max" ) == 0 ) )
+                    fMax = argv[ ++ii ];
+                else if ( hasValue && ( strcmp( argv[ ii ], "-repeat" ) == 0 ) )
+                    fRepeat = std::max( 1, atoi( argv[ ++ii ] ) );
+                else if ( strcmp( argv[ ii ], "-time" ) == 0 )
+                    fTime = true;
+                else if ( strcmp( argv[ ii ], "-numbers" ) == 0 )
+                {
+                    while ( ( ( ii + 1 ) < argc ) && ( argv[ ii + 1 ][ 0 ] != '-' ) )
+                        fNumbers += std::string( " " ) + argv[ ++ii ];
+                    if ( fNumbers.empty() )
+                    {
+                        std::cerr << "-numbers requires a list of integers\n";
+                        return false;
+                    }
+                }
+                else
+                {
+                    std::cerr << "unknown switch: '" << argv[ ii ] << "'\n";
+                    return false;
+                }
+            }
+            if ( fMin.empty() != fMax.empty() )
+            {
+                std::cerr << "-min and -max must be used together\n";
+                return false;
+            }
+            return true;
+        }
+
+        int run()
+        {
+            std::vector< std::string > requests;
+            if ( !fNumbers.empty() )
+                requests.push_back( "list " + std::to_string( fBase ) + fNumbers );
+            if ( !fMin.empty() )
+                requests.push_back( "range " + std::to_string( fBase ) + " " + fMin + " " + fMax );
+            if ( requests.empty() )
+            {
+                std::string line;
+                while ( std::getline( std::cin, line ) )
+                {
+                    if ( !line.empty() )
+                        requests.push_back( line );
+                }
+            }
+            if ( requests.empty() )
+                return 0;
+
+            QLocalSocket socket;
+            socket.connectToServer( fServerName );
+            if ( !socket.waitForConnected( 1000 ) )
+            {
+                std::cerr << "Could not connect to '" << fServerName.toStdString() << "': " << socket.errorString().toStdString() << "\n";
+                return 1;
+            }
+
+            int retVal = 0;
+            for ( int rep = 0; rep < fRepeat; ++rep )
+            {
+                // one write for the whole batch, the answers are matched by id
+                std::map< int, std::chrono::steady_clock::time_point > pending;
+                QByteArray batch;
+                auto start = std::chrono::steady_clock::now();
+                for ( size_t ii = 0; ii < requests.size(); ++ii )
+                {
+                    batch += QByteArray::number( static_cast< int >( ii ) ) + " " + QByteArray::fromStdString( requests[ ii ] ) + "\n";
+                    pending[ static_cast< int >( ii ) ] = start;
+                }
+                socket.write( batch );
+                socket.flush();
+
+                while ( !pending.empty() )
+                {
+                    if ( !socket.canReadLine() && !socket.waitForReadyRead( -1 ) )
+                    {
+                        std::cerr << "Lost the connection: " << socket.errorString().toStdString() << "\n";
+                        return 1;
+                    }
+                    while ( socket.canReadLine() )
+                    {
+                        auto line = socket.readLine().trimmed();
+                        auto fields = line.split( ' ' );
+                        bool aOK = false;
+                        auto id = fields.value( 0 ).toInt( &aOK );
+                        auto kind = fields.value( 1 );
+                        // the id comes from the server, only ids that were sent are used
+                        if ( !aOK || ( id < 0 ) || ( static_cast< size_t >( id ) >= requests.size() ) )
+                        {
+                            std::cerr << "Protocol error, unexpected reply: '" << line.toStdString() << "'\n";
+                            return 1;
+                        }
+                        if ( kind == "value" )
+                        {
+                            if ( rep == 0 )
+                                std::cout << fields.value( 2 ).toStdString() << "\n";
+                            continue;
+                        }
+
+                        auto pos = pending.find( id );
+                        if ( kind == "error" )
+                        {
+                            std::cerr << requests[ id ] << ": " << fields.mid( 2 ).join( ' ' ).toStdString() << "\n";
+                            retVal = 1;
+                        }
+                        else if ( fTime && ( pos != pending.end() ) )
+                        {
+                            auto micros = std::chrono::duration_cast< std::chrono::microseconds >( std::chrono::steady_clock::now() - ( *pos ).second ).count();
+                            std::cerr << requests[ id ] << ": " << micros << "us\n";
+                        }
+                        if ( pos != pending.end() )
+                            pending.erase( pos );
+                    }
+                }
+                std::cout << std::flush;
+            }
+            return retVal;
+        }
+    private:
+        QString fServerName{ CNarcissisticDaemon::defaultServerName() };
+        int fBase{ 10 };
+        std::string fNumbers;
+        std::string fMin;
+        std::string fMax;
+        int fRepeat{ 1 };
+        bool fTime{ false };
+    };
+}
+
+int main( int argc, char** argv )
+{
+    QCoreApplication appl( argc, argv );
+    CClient client;
+    if ( !client.parse( argc, argv ) )
+        return 1;
+    return client.run();
+}
@@ -0,0 +1,276 @@
+// The MIT License( MIT )
+//
+// Copyright( c ) 2020 Scott Aron Bloom
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sub-license, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "NarcissisticDaemon.h"
+#include "NarcissisticNumCalculator.h"
+#include "NarcissisticEngine.h"
+#include "NarcissisticTable.h"
+
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QTimer>
+#include <QList>
+
+#include <algorithm>
+#include <limits>
+
+CNarcissisticDaemon::CNarcissisticDaemon( bool useKnownTable, QObject* parent ) :
+    QObject( parent ),
+    fUseKnownTable( useKnownTable )
+{
+    fServer = new QLocalServer( this );
+    connect( fServer, &QLocalServer::newConnection, this, &CNarcissisticDaemon::slotNewConnection );
+
+    fPollTimer = new QTimer( this );
+    fPollTimer->setInterval( 100 );
+    connect( fPollTimer, &QTimer::timeout, this, &CNarcissisticDaemon::slotJobProgress );
+}
+
+CNarcissisticDaemon::~CNarcissisticDaemon()
+{
+    for ( auto&& ii : fJobs )
+    {
+        ii->fCalculator->cancel();
+        while ( !ii->fCalculator->waitUntilIdle( std::chrono::milliseconds( 100 ) ) )
+            ;
+    }
+    fJobs.clear();
+}
+
+bool CNarcissisticDaemon::listen( const QString& serverName )
+{
+    QLocalServer::removeServer( serverName ); // a stale socket from a previous daemon that did not exit cleanly
+    fServer->setSocketOptions( QLocalServer::UserAccessOption );
+    return fServer->listen( serverName );
+}
+
+QString CNarcissisticDaemon::errorString() const
+{
+    return fServer->errorString();
+}
+
+void CNarcissisticDaemon::slotNewConnection()
+{
+    while ( auto socket = fServer->nextPendingConnection() )
+    {
+        connect( socket, &QLocalSocket::readyRead, this, &CNarcissisticDaemon::slotReadyRead );
+        connect( socket, &QLocalSocket::disconnected, this, &CNarcissisticDaemon::slotDisconnected );
+    }
+}
+
+void CNarcissisticDaemon::slotReadyRead()
+{
+    auto socket = qobject_cast< QLocalSocket* >( sender() );
+    if ( !socket )
+        return;
+
+    while ( socket->canReadLine() )
+    {
+        auto line = socket->readLine().trimmed();
+        if ( !line.isEmpty() )
+            handleRequest( socket, line );
+    }
+    socket->flush();
+}
+
+void CNarcissisticDaemon::slotDisconnected()
+{
+    auto socket = qobject_cast< QLocalSocket* >( sender() );
+    if ( !socket )
+        return;
+
+    // nobody is left to read the answers
+    for ( auto&& ii : fJobs )
+    {
+        if ( ii->fSocket == socket )
+            ii->fCalculator->cancel();
+    }
+    socket->deleteLater();
+}
+
+void CNarcissisticDaemon::handleRequest( QLocalSocket* socket, const QByteArray& line )
+{
+    auto fields = line.simplified().split( ' ' );
+    auto id = fields.value( 0 );
+    auto command = fields.value( 1 );
+    if ( command == "ping" )
+    {
+        writeDone( socket, id, 0 );
+        return;
+    }
+
+    bool aOK = false;
+    auto base = fields.value( 2 ).toInt( &aOK );
+    if ( !aOK || ( base < 2 ) || ( base > 36 ) )
+    {
+        writeError( socket, id, "base must be between 2 and 36" );
+        return;
+    }
+
+    if ( command == "list" )
+    {
+        std::list< uint64_t > values;
+        for ( int ii = 3; ii < fields.size(); ++ii )
+        {
+            values.push_back( fields[ ii ].toULongLong( &aOK ) );
+            if ( !aOK )
+            {
+                writeError( socket, id, QString( "invalid value '%1'" ).arg( QString::fromLatin1( fields[ ii ] ) ) );
+                return;
+            }
+        }
+        answerList( socket, id, base, values );
+    }
+    else if ( command == "range" )
+    {
+        bool minOK = false;
+        bool maxOK = false;
+        auto min = fields.value( 3 ).toULongLong( &minOK );
+        auto max = fields.value( 4 ).toULongLong( &maxOK );
+        if ( !minOK || !maxOK || ( fields.size() != 5 ) )
+        {
+            writeError( socket, id, "range requires a min and a max" );
+            return;
+        }
+        answerRange( socket, id, base, min, max );
+    }
+    else
+        writeError( socket, id, QString( "unknown request '%1'" ).arg( QString::fromLatin1( command ) ) );
+}
+
+void CNarcissisticDaemon::answerList( QLocalSocket* socket, const QByteArray& id, int base, std::list< uint64_t >& values )
+{
+    values.sort();
+    values.unique();
+
+    uint64_t numFound = 0;
+    for ( auto&& ii : values )
+    {
+        bool isNarcissistic = false;
+        if ( fUseKnownTable && NNarcissisticTable::hasTable( base ) )
+            isNarcissistic = NNarcissisticTable::isNarcissistic( ii, base );
+        else
+        {
+            // the registry caches the engines, so their tables stay warm between requests
+            bool aOK = true;
+            auto engine = CNarcissisticEngineRegistry::instance().create( "auto", base, CNarcissisticEngine::computeNumDigits( ii, base ) );
+            isNarcissistic = engine->isNarcissistic( ii, aOK ) && aOK;
+        }
+        if ( isNarcissistic )
+        {
+            writeValue( socket, id, ii );
+            numFound++;
+        }
+    }
+    writeDone( socket, id, numFound );
+}
+
+void CNarcissisticDaemon::answerRange( QLocalSocket* socket, const QByteArray& id, int base, uint64_t min, uint64_t max )
+{
+    if ( fUseKnownTable && NNarcissisticTable::hasTable( base ) )
+    {
+        uint64_t numFound = 0;
+        for ( auto pos = NNarcissisticTable::lowerBound( min, base ); ( pos != NNarcissisticTable::end( base ) ) && ( *pos < max ); ++pos, ++numFound )
+            writeValue( socket, id, *pos );
+        writeDone( socket, id, numFound );
+        return;
+    }
+
+    // never searched on the daemon thread, it would hold up every other client
+    startJob( socket, id, base, min, max );
+}
+
+void CNarcissisticDaemon::startJob( QLocalSocket* socket, const QByteArray& id, int base, uint64_t min, uint64_t max )
+{
+    SNarcissisticConfig config;
+    config.fBase = base;
+    config.fRange = std::make_pair( min, max );
+    config.fNumPerPartition = 100000;
+    config.fMaxBuffered = 0; // the daemon drains every job as its partitions complete
+    config.fUseKnownTable = fUseKnownTable;
+
+    auto job = std::make_unique< SJob >();
+    job->fSocket = socket;
+    job->fId = id;
+    job->fNextValue = min;
+    job->fCalculator.reset( new CNarcissisticNumCalculator( config ) );
+    job->fCalculator->setProgressObserver(
+        [ this ]()
+        {
+            // called on a worker with the calculator locked, the answers are written on the daemon thread
+            if ( !fProgressPending.exchange( true ) )
+                QMetaObject::invokeMethod( this, "slotJobProgress", Qt::QueuedConnection );
+        } );
+    job->fCalculator->launch( CNarcissisticNumCalculator::TReportFunctionType(), false );
+    job->fCalculator->partition( CNarcissisticNumCalculator::TReportFunctionType(), false );
+    fJobs.push_back( std::move( job ) );
+
+    // the last partition may have completed before partition() returned
+    QMetaObject::invokeMethod( this, "slotJobProgress", Qt::QueuedConnection );
+    fPollTimer->start();
+}
+
+void CNarcissisticDaemon::slotJobProgress()
+{
+    fProgressPending = false;
+    for ( auto ii = fJobs.begin(); ii != fJobs.end(); )
+    {
+        if ( drainJob( **ii ) )
+            ii = fJobs.erase( ii );
+        else
+            ++ii;
+    }
+    if ( fJobs.empty() )
+        fPollTimer->stop();
+}
+
+bool CNarcissisticDaemon::drainJob( SJob& job )
+{
+    auto finished = job.fCalculator->isFinished( nullptr );
+    if ( !job.fSocket )
+        return finished; // disconnected, the job was cancelled
+
+    auto proven = job.fCalculator->provenResults( job.fNextValue, finished );
+    for ( auto&& ii : proven )
+        writeValue( job.fSocket, job.fId, ii );
+    job.fNumFound += proven.size();
+    if ( finished )
+        writeDone( job.fSocket, job.fId, job.fNumFound );
+    job.fSocket->flush();
+    return finished;
+}
+
+void CNarcissisticDaemon::writeValue( QLocalSocket* socket, const QByteArray& id, uint64_t value )
+{
+    socket->write( id + " value " + QByteArray::number( static_cast< qulonglong >( value ) ) + "\n" );
+}
+
+void CNarcissisticDaemon::writeDone( QLocalSocket* socket, const QByteArray& id, uint64_t numFound )
+{
+    socket->write( id + " done " + QByteArray::number( static_cast< qulonglong >( numFound ) ) + "\n" );
+}
+
+void CNarcissisticDaemon::writeError( QLocalSocket* socket, const QByteArray& id, const QString& msg )
+{
+    socket->write( id + " error " + msg.toUtf8() + "\n" );
+}
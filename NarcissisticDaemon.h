@@ -0,0 +1,96 @@
+// The MIT License( MIT )
+//
+// Copyright( c ) 2020 Scott Aron Bloom
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sub-license, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#ifndef __NARCISSISTICDAEMON_H
+#define __NARCISSISTICDAEMON_H
+
+#include <QObject>
+#include <QPointer>
+#include <QByteArray>
+#include <QString>
+
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <memory>
+
+class QLocalServer;
+class QLocalSocket;
+class QTimer;
+class CNarcissisticNumCalculator;
+
+// Long running query server on a local socket (a unix domain socket, or a named pipe on windows)
+// The engines, tables and pool workers stay warm between requests
+//
+// Requests are one per line, any number may be sent in one write
+//     <id> list <base> <value> [<value> ...]
+//     <id> range <base> <min> <max>          [min:max)
+//     <id> ping
+// Each request is answered with its narcissistic numbers in ascending order, followed by done
+//     <id> value <value>
+//     <id> done <number found>
+//     <id> error <message>
+// Requests are answered from the known table, with -no_table the ranges run as jobs on the shared pool
+// (the calculator runs the smallest on the daemon thread) and stream as they are proven
+class CNarcissisticDaemon : public QObject
+{
+    Q_OBJECT
+public:
+    CNarcissisticDaemon( bool useKnownTable = true, QObject* parent = nullptr );
+    ~CNarcissisticDaemon();
+
+    static QString defaultServerName(){ return "narcissistic"; }
+    bool listen( const QString& serverName );
+    QString errorString() const;
+private Q_SLOTS:
+    void slotNewConnection();
+    void slotReadyRead();
+    void slotDisconnected();
+    void slotJobProgress();
+private:
+    struct SJob
+    {
+        QPointer< QLocalSocket > fSocket;
+        QByteArray fId;
+        std::unique_ptr< CNarcissisticNumCalculator > fCalculator;
+        uint64_t fNextValue{ 0 };
+        uint64_t fNumFound{ 0 };
+    };
+
+    void handleRequest( QLocalSocket* socket, const QByteArray& line );
+    void answerList( QLocalSocket* socket, const QByteArray& id, int base, std::list< uint64_t >& values );
+    void answerRange( QLocalSocket* socket, const QByteArray& id, int base, uint64_t min, uint64_t max );
+    void startJob( QLocalSocket* socket, const QByteArray& id, int base, uint64_t min, uint64_t max );
+    bool drainJob( SJob& job ); // returns true once the job has finished and been answered
+
+    static void writeValue( QLocalSocket* socket, const QByteArray& id, uint64_t value );
+    static void writeDone( QLocalSocket* socket, const QByteArray& id, uint64_t numFound );
+    static void writeError( QLocalSocket* socket, const QByteArray& id, const QString& msg );
+
+    bool fUseKnownTable{ true };
+    QLocalServer* fServer{ nullptr };
+    QTimer* fPollTimer{ nullptr }; // a safety net, jobs normally report through their progress observer
+    std::list< std::unique_ptr< SJob > > fJobs;
+    std::atomic< bool > fProgressPending{ false };
+};
+#endif
@@ -0,0 +1,137 @@
+// The MIT License( MIT )
+//
+// Copyright( c ) 2020 Scott Aron Bloom
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sub-license, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "NarcissisticEnergy.h"
+
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+namespace
+{
+    const int kMaxPackages = 64;
+}
+
+CNarcissisticEnergy::CNarcissisticEnergy()
+{
+#ifdef __linux__
+    // only the top level package zones, the sub zones (core, uncore, dram) are included in them
+    bool anyZone = false;
+    for ( int ii = 0; ii < kMaxPackages; ++ii )
+    {
+        auto dir = "/sys/class/powercap/intel-rapl:" + std::to_string( ii );
+        std::ifstream nameFile( dir + "/name" );
+        if ( !nameFile )
+            continue;
+        anyZone = true;
+
+        SZone zone;
+        std::getline( nameFile, zone.fName );
+        if ( zone.fName == "psys" ) // the whole platform, it would count the packages twice
+            continue;
+        zone.fEnergyFile = dir + "/energy_uj";
+        if ( !readValue( zone.fEnergyFile, zone.fLast ) )
+        {
+            if ( fErrorMsg.empty() )
+                fErrorMsg = zone.fEnergyFile + " is not readable (root only since Linux 5.10)";
+            continue;
+        }
+        if ( !readValue( dir + "/max_energy_range_uj", zone.fMaxRange ) )
+            zone.fMaxRange = 0;
+        fZones.push_back( zone );
+    }
+    if ( !anyZone )
+        fErrorMsg = "no RAPL zones in /sys/class/powercap (the intel_rapl driver is not loaded, or this is a VM)";
+#else
+    fErrorMsg = "the RAPL energy counters are only read on Linux";
+#endif
+    start();
+}
+
+bool CNarcissisticEnergy::readValue( const std::string& fileName, uint64_t& value )
+{
+    std::ifstream iss( fileName );
+    return static_cast< bool >( iss >> value );
+}
+
+std::string CNarcissisticEnergy::zoneNames() const
+{
+    std::string retVal;
+    for ( auto&& ii : fZones )
+        retVal += ( retVal.empty() ? "" : ", " ) + ii.fName;
+    return retVal;
+}
+
+void CNarcissisticEnergy::start()
+{
+    for ( auto&& ii : fZones )
+        readValue( ii.fEnergyFile, ii.fLast );
+    fJoules = 0.0;
+    fStopped = false;
+    fStart = fLastSample = std::chrono::steady_clock::now();
+}
+
+void CNarcissisticEnergy::stop()
+{
+    sample();
+    fStopped = true;
+}
+
+void CNarcissisticEnergy::sample()
+{
+    if ( fStopped )
+        return;
+    for ( auto&& ii : fZones )
+    {
+        uint64_t curr = 0;
+        if ( !readValue( ii.fEnergyFile, curr ) )
+            continue;
+        // a counter below its last value has wrapped
+        auto delta = ( curr >= ii.fLast ) ? ( curr - ii.fLast ) : ( ii.fMaxRange ? ( ii.fMaxRange - ii.fLast + curr ) : curr );
+        fJoules += delta * 1e-6;
+        ii.fLast = curr;
+    }
+    fLastSample = std::chrono::steady_clock::now();
+}
+
+double CNarcissisticEnergy::seconds() const
+{
+    return std::chrono::duration< double >( fLastSample - fStart ).count();
+}
+
+std::string CNarcissisticEnergy::report( uint64_t numCandidates ) const
+{
+    std::ostringstream oss;
+    if ( !available() )
+    {
+        oss << "Energy: not available - " << fErrorMsg << "\n";
+        return oss.str();
+    }
+    oss << "Energy: " << std::fixed << std::setprecision( 2 ) << fJoules << " J";
+    if ( numCandidates )
+        oss << " - " << std::setprecision( 4 ) << fJoules * 1e6 / numCandidates << " J/M candidates";
+    if ( seconds() > 0 )
+        oss << " - " << std::setprecision( 1 ) << fJoules / seconds() << " W average";
+    oss << " (" << zoneNames() << ")\n";
+    return oss.str();
+}
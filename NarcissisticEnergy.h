@@ -0,0 +1,73 @@
+// The MIT License( MIT )
+//
+// Copyright( c ) 2020 Scott Aron Bloom
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sub-license, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+
+#ifndef __NARCISSISTICENERGY_H
+#define __NARCISSISTICENERGY_H
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Package energy from the Linux powercap RAPL counters (/sys/class/powercap/intel-rapl:N, used for AMD too)
+// The counters are for the whole package, so anything else running is included in the measurement.
+// Since Linux 5.10 energy_uj is only readable by root, errorMsg() says why when nothing is available.
+// Not thread safe
+class CNarcissisticEnergy
+{
+public:
+    CNarcissisticEnergy(); // finds the readable package zones
+    bool available() const { return !fZones.empty(); }
+    const std::string& errorMsg() const { return fErrorMsg; }
+    std::string zoneNames() const;
+
+    void start();
+    // folds the counters into the total, must be called at least once per counter wrap (minutes at full load)
+    void sample();
+    // takes a final sample, later samples are ignored until the next start
+    void stop();
+    // as of the last sample
+    double joules() const { return fJoules; }
+    double seconds() const;
+
+    // joules, joules per million candidates and average watts, or why energy is not available
+    std::string report( uint64_t numCandidates ) const;
+private:
+    struct SZone
+    {
+        std::string fName;
+        std::string fEnergyFile;
+        uint64_t fMaxRange{ 0 }; // the counter wraps to 0 after this many micro joules
+        uint64_t fLast{ 0 };
+    };
+    static bool readValue( const std::string& fileName, uint64_t& value );
+
+    std::vector< SZone > fZones;
+    std::string fErrorMsg;
+    double fJoules{ 0.0 };
+    bool fStopped{ false };
+    std::chrono::steady_clock::time_point fStart;
+    std::chrono::steady_clock::time_point fLastSample;
+};
+#endif
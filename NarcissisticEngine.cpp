@@ -0,0 +1,667 @@
+// The MIT License( MIT )
+//
+// Copyright( c ) 2020 Scott Aron Bloom
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sub-license, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "NarcissisticEngine.h"
+#include "SABUtils/utils.h"
+
+#include <chrono>
+#include <limits>
+
+namespace
+{
+    const uint64_t kSaturated = std::numeric_limits< uint64_t >::max();
+
+    // the original implementation from SABUtils
+    class CSABUtilsEngine : public CNarcissisticEngine
+    {
+    public:
+        CSABUtilsEngine( int base, const TPowerFunction& powerFunction ) :
+            CNarcissisticEngine( base, powerFunction )
+        {
+        }
+
+        std::string name() const override { return "sabutils"; }
+
+        bool isNarcissistic( uint64_t value, bool& aOK ) const override
+        {
+            return NUtils::isNarcissistic( value, fBase, aOK );
+        }
+    };
+
+    // converts the value to a string, and uses the characters as the digits
+    class CStringEngine : public CNarcissisticEngine
+    {
+    public:
+        CStringEngine( int base, const TPowerFunction& powerFunction ) :
+            CNarcissisticEngine( base, powerFunction )
+        {
+        }
+
+        std::string name() const override { return "string"; }
+
+        bool isNarcissistic( uint64_t value, bool& aOK ) const override
+        {
+            aOK = true;
+            auto str = NUtils::toString( value, fBase );
+            auto numDigits = static_cast< uint64_t >( str.length() );
+            uint64_t sum = 0;
+            for ( auto&& ii : str )
+            {
+                uint64_t digit = 0;
+                if ( ( ii >= '0' ) && ( ii <= '9' ) )
+                    digit = ii - '0';
+                else if ( ( ii >= 'a' ) && ( ii <= 'z' ) )
+                    digit = 10 + ii - 'a';
+                else if ( ( ii >= 'A' ) && ( ii <= 'Z' ) )
+                    digit = 10 + ii - 'A';
+                else
+                {
+                    aOK = false;
+                    return false;
+                }
+
+                sum = addSat( sum, power( digit, numDigits ) );
+                if ( ( sum > value ) || ( sum == kSaturated ) )
+                    return false;
+            }
+            return sum == value;
+        }
+    };
+
+    // extracts the digits by division, and computes each power as needed
+    class CDivisionEngine : public CNarcissisticEngine
+    {
+    public:
+        CDivisionEngine( int base, const TPowerFunction& powerFunction ) :
+            CNarcissisticEngine( base, powerFunction )
+        {
+        }
+
+        std::string name() const override { return "division"; }
+
+        bool isNarcissistic( uint64_t value, bool& aOK ) const override
+        {
+            aOK = true;
+            auto k = static_cast< uint64_t >( numDigits( value ) );
+            uint64_t sum = 0;
+            for ( auto curr = value; curr; curr /= fBase )
+            {
+                sum = addSat( sum, power( curr % fBase, k ) );
+                if ( ( sum > value ) || ( sum == kSaturated ) )
+                    return false;
+            }
+            return sum == value;
+        }
+    };
+
+    // extracts the digits by division, the powers come from a table per digit length
+    class CTableEngine : public CNarcissisticEngine
+    {
+    public:
+        CTableEngine( int base, const TPowerFunction& powerFunction ) :
+            CNarcissisticEngine( base, powerFunction )
+        {
+            auto maxDigits = fBasePowers.size();
+            fPowers.resize( ( maxDigits + 1 ) * fBase );
+            for ( size_t k = 1; k <= maxDigits; ++k )
+            {
+                for ( int digit = 0; digit < fBase; ++digit )
+                    fPowers[ k * fBase + digit ] = power( digit, k );
+            }
+        }
+
+        std::string name() const override { return "table"; }
+        size_t memoryFootprint() const override { return fPowers.size() * sizeof( uint64_t ); }
+
+        bool isNarcissistic( uint64_t value, bool& aOK ) const override
+        {
+            aOK = true;
+            return check( value, row( numDigits( value ) ) );
+        }
+
+        uint64_t findInRange( uint64_t min, uint64_t max, const TFoundFunction& foundFunc, const TContinueFunction& continueFunc ) const override
+        {
+            auto ii = min;
+            while ( ii < max )
+            {
+                // the digit length, and therefore the table row, is constant up to the next power of the base
+                auto k = numDigits( ii );
+                auto lengthMax = ( static_cast< size_t >( k ) < fBasePowers.size() ) ? std::min( max, fBasePowers[ k ] ) : max;
+                auto powers = row( k );
+                for ( ; ii < lengthMax; ++ii )
+                {
+                    if ( ( ( ( ii - min ) % kCheckInterval ) == 0 ) && continueFunc && !continueFunc( ii ) )
+                        return ii;
+                    if ( check( ii, powers ) )
+                        foundFunc( ii );
+                }
+            }
+            return max;
+        }
+    private:
+        const uint64_t* row( int numDigits ) const { return fPowers.data() + numDigits * fBase; }
+
+        bool check( uint64_t value, const uint64_t* powers ) const
+        {
+            uint64_t sum = 0;
+            for ( auto curr = value; curr; curr /= fBase )
+            {
+                sum = addSat( sum, powers[ curr % fBase ] );
+                if ( ( sum > value ) || ( sum == kSaturated ) )
+                    return false;
+            }
+            return sum == value;
+        }
+
+        std::vector< uint64_t > fPowers; // fPowers[ k * base + digit ] = digit^k
+    };
+
+    // splits the candidate into blocks of w digits, the power sum of every block value comes from a table
+    // per digit length, so a candidate costs one load and add per block rather than per digit
+    // within findInRange the sum of the upper blocks is computed once per b^w consecutive candidates
+    class CBlockEngine : public CNarcissisticEngine
+    {
+    public:
+        // the largest block whose table still fits comfortably in L2
+        static const uint64_t kMaxBlockTableSize{ 32768 };
+
+        CBlockEngine( int base, const TPowerFunction& powerFunction ) :
+            CNarcissisticEngine( base, powerFunction )
+        {
+            fBlockSize = fBase;
+            fBlockWidth = 1;
+            while ( ( fBlockSize * fBase ) <= kMaxBlockTableSize )
+            {
+                fBlockSize *= fBase;
+                fBlockWidth++;
+            }
+
+            auto maxDigits = fBasePowers.size();
+            fTables.resize( maxDigits + 1 );
+            fTablesBuilt.reset( new std::once_flag[ maxDigits + 1 ] );
+        }
+
+        std::string name() const override { return "block"; }
+
+        // only the tables for the digit lengths used so far are built
+        size_t memoryFootprint() const override
+        {
+            std::lock_guard< std::mutex > lock( fMutex );
+            return fNumTablesBuilt * fBlockSize * sizeof( uint64_t );
+        }
+
+        bool isNarcissistic( uint64_t value, bool& aOK ) const override
+        {
+            aOK = true;
+            auto&& table = blockTable( numDigits( value ) );
+            return blockSum( value, table ) == value;
+        }
+
+        uint64_t findInRange( uint64_t min, uint64_t max, const TFoundFunction& foundFunc, const TContinueFunction& continueFunc ) const override
+        {
+            auto ii = min;
+            auto nextCheck = min;
+            while ( ii < max )
+            {
+                auto k = numDigits( ii );
+                auto lengthMax = ( static_cast< size_t >( k ) < fBasePowers.size() ) ? std::min( max, fBasePowers[ k ] ) : max;
+                auto&& table = blockTable( k );
+                while ( ii < lengthMax )
+                {
+                    if ( ( ii >= nextCheck ) && continueFunc )
+                    {
+                        if ( !continueFunc( ii ) )
+                            return ii;
+                        nextCheck = addSat( ii, kCheckInterval );
+                    }
+
+                    auto high = ii / fBlockSize;
+                    auto low = ii - high * fBlockSize;
+                    auto runMax = ( ( lengthMax - ii ) > ( fBlockSize - low ) ) ? ( ii + fBlockSize - low ) : lengthMax; // prevents overflow
+                    runMax = std::min( runMax, std::max( nextCheck, ii + 1 ) );
+
+                    auto highSum = blockSum( high, table );
+                    if ( highSum >= runMax ) // every sum in the run is at least highSum
+                    {
+                        ii = runMax;
+                        continue;
+                    }
+                    for ( ; ii < runMax; ++ii, ++low )
+                    {
+                        if ( ( ii >= highSum ) && ( table[ low ] == ( ii - highSum ) ) )
+                            foundFunc( ii );
+                    }
+                }
+            }
+            return max;
+        }
+    private:
+        const std::vector< uint64_t >& blockTable( int numDigits ) const
+        {
+            std::call_once( fTablesBuilt[ numDigits ],
+                [ this, numDigits ]()
+                {
+                    std::vector< uint64_t > digitPowers( fBase );
+                    for ( int digit = 0; digit < fBase; ++digit )
+                        digitPowers[ digit ] = power( digit, numDigits );
+
+                    auto&& table = fTables[ numDigits ];
+                    table.resize( fBlockSize );
+                    for ( uint64_t block = 0; block < fBlockSize; ++block )
+                    {
+                        // the leading zeros of the block contribute 0^k == 0
+                        uint64_t sum = 0;
+                        for ( auto curr = block; curr; curr /= fBase )
+                            sum = addSat( sum, digitPowers[ curr % fBase ] );
+                        table[ block ] = sum;
+                    }
+
+                    std::lock_guard< std::mutex > lock( fMutex );
+                    fNumTablesBuilt++;
+                } );
+            return fTables[ numDigits ];
+        }
+
+        uint64_t blockSum( uint64_t value, const std::vector< uint64_t >& table ) const
+        {
+            uint64_t sum = 0;
+            for ( auto curr = value; curr; curr /= fBlockSize )
+            {
+                sum = addSat( sum, table[ curr % fBlockSize ] );
+                if ( sum == kSaturated )
+                    break;
+            }
+            return sum;
+        }
+
+        uint64_t fBlockSize{ 0 }; // b^w
+        int fBlockWidth{ 0 };
+        mutable std::vector< std::vector< uint64_t > > fTables; // fTables[ k ][ block ] = sum of the blocks digits^k
+        mutable std::unique_ptr< std::once_flag[] > fTablesBuilt;
+        mutable std::mutex fMutex;
+        mutable size_t fNumTablesBuilt{ 0 };
+    };
+
+    // for bases up to 16 the candidate is kept as packed 4 bit digits, stored biased by 16 - b so the
+    // digit b - 1 is the nibble 0xF and a plain +1 ripples the carry through the nibbles (SWAR)
+    // the power sum is maintained incrementally from the changed nibbles, so findInRange does no division
+    // the sums are modulo 2^64, a match is confirmed by the exact (saturated) check
+    class CNibbleEngine : public CNarcissisticEngine
+    {
+    public:
+        static const int kMaxBase{ 16 };
+        static const size_t kMaxWords{ 4 }; // 64 digits for base 2
+        static const uint64_t kNibbleOnes{ 0x1111111111111111ULL };
+
+        CNibbleEngine( int base, const TPowerFunction& powerFunction ) :
+            CNarcissisticEngine( base, powerFunction )
+        {
+            auto maxDigits = fBasePowers.size();
+            fPowers.resize( ( maxDigits + 1 ) * 16 );
+            fDeltas.resize( ( maxDigits + 1 ) * 16 );
+            if ( fBase > kMaxBase )
+                return;
+
+            fBias = 16 - fBase;
+            fBiasWord = fBias * kNibbleOnes;
+            for ( size_t k = 1; k <= maxDigits; ++k )
+            {
+                // nibbles below the bias are never a digit, they are the unused high nibbles
+                for ( int digit = 0; digit < fBase; ++digit )
+                    fPowers[ k * 16 + fBias + digit ] = power( digit, k );
+                for ( int nibble = 0; nibble < 15; ++nibble )
+                    fDeltas[ k * 16 + nibble ] = fPowers[ k * 16 + nibble + 1 ] - fPowers[ k * 16 + nibble ];
+            }
+        }
+
+        std::string name() const override { return "nibble"; }
+        size_t memoryFootprint() const override { return ( fPowers.size() + fDeltas.size() ) * sizeof( uint64_t ); }
+
+        bool isNarcissistic( uint64_t value, bool& aOK ) const override
+        {
+            aOK = true;
+            auto k = numDigits( value );
+            if ( fBase > kMaxBase )
+                return exactSum( value, k ) == value;
+
+            uint64_t words[ kMaxWords + 1 ];
+            return ( packedSum( value, k, words ) == value ) && ( exactSum( value, k ) == value );
+        }
+
+        uint64_t findInRange( uint64_t min, uint64_t max, const TFoundFunction& foundFunc, const TContinueFunction& continueFunc ) const override
+        {
+            if ( fBase > kMaxBase )
+                return CNarcissisticEngine::findInRange( min, max, foundFunc, continueFunc );
+
+            auto ii = min;
+            auto nextCheck = min;
+            while ( ii < max )
+            {
+                auto k = numDigits( ii );
+                auto lengthMax = ( static_cast< size_t >( k ) < fBasePowers.size() ) ? std::min( max, fBasePowers[ k ] ) : max;
+                auto powers = fPowers.data() + k * 16;
+                auto deltas = fDeltas.data() + k * 16;
+                auto maxDigitPower = powers[ 15 ];
+
+                // the only division, once per digit length
+                uint64_t words[ kMaxWords + 1 ];
+                auto sum = packedSum( ii, k, words );
+                while ( ii < lengthMax )
+                {
+                    if ( ( ii >= nextCheck ) && continueFunc )
+                    {
+                        if ( !continueFunc( ii ) )
+                            return ii;
+                        nextCheck = addSat( ii, kCheckInterval );
+                    }
+
+                    if ( ( sum == ii ) && ( exactSum( ii, k ) == ii ) )
+                        foundFunc( ii );
+                    if ( ++ii == lengthMax )
+                        break;
+
+                    for ( size_t w = 0; ; ++w )
+                    {
+                        auto packed = words[ w ];
+                        if ( packed == ~0ULL )
+                        {
+                            // every digit of the word wraps, the carry moves to the next word
+                            words[ w ] = fBiasWord;
+                            sum -= 16 * maxDigitPower;
+                            continue;
+                        }
+
+                        // the trailing 0xF nibbles wrap to the bias, the nibble above them is incremented
+                        auto maxNibbles = ( packed & ( packed >> 1 ) & ( packed >> 2 ) & ( packed >> 3 ) & kNibbleOnes ) * 0xF;
+                        auto wrapped = maxNibbles & ~( maxNibbles + 1 );
+                        auto numWrapped = ( ( wrapped & kNibbleOnes ) * kNibbleOnes ) >> 60;
+                        auto nibble = ( packed >> ( 4 * numWrapped ) ) & 0xF;
+                        sum += deltas[ nibble ] - numWrapped * maxDigitPower;
+                        words[ w ] = ( packed + 1 ) | ( fBiasWord & wrapped );
+                        break;
+                    }
+                }
+            }
+            return max;
+        }
+    private:
+        // packs the k digits of value into words (unused nibbles are 0), returns the power sum modulo 2^64
+        uint64_t packedSum( uint64_t value, int k, uint64_t* words ) const
+        {
+            auto powers = fPowers.data() + k * 16;
+            for ( size_t w = 0; w <= kMaxWords; ++w )
+                words[ w ] = 0;
+
+            uint64_t sum = 0;
+            for ( int digit = 0; digit < k; ++digit, value /= fBase )
+            {
+                auto nibble = static_cast< uint64_t >( value % fBase + fBias );
+                words[ digit / 16 ] |= nibble << ( 4 * ( digit % 16 ) );
+                sum += powers[ nibble ];
+            }
+            return sum;
+        }
+
+        uint64_t exactSum( uint64_t value, int k ) const
+        {
+            uint64_t sum = 0;
+            for ( auto curr = value; curr; curr /= fBase )
+            {
+                sum = addSat( sum, power( curr % fBase, k ) );
+                if ( ( sum > value ) || ( sum == kSaturated ) )
+                    return kSaturated;
+            }
+            return sum;
+        }
+
+        int fBias{ 0 };
+        uint64_t fBiasWord{ 0 };
+        std::vector< uint64_t > fPowers; // fPowers[ k * 16 + nibble ] = digit^k, modulo 2^64
+        std::vector< uint64_t > fDeltas; // fDeltas[ k * 16 + nibble ] = ( digit + 1 )^k - digit^k, modulo 2^64
+    };
+}
+
+CNarcissisticEngine::CNarcissisticEngine( int base, const TPowerFunction& powerFunction ) :
+    fBase( base ),
+    fPowerFunction( powerFunction )
+{
+    // only the powers that fit, so fBasePowers.size() is the max number of digits
+    for ( uint64_t curr = 1; ; )
+    {
+        fBasePowers.push_back( curr );
+        if ( curr > kSaturated / fBase )
+            break;
+        curr *= fBase;
+    }
+}
+
+CNarcissisticEngine::~CNarcissisticEngine()
+{
+}
+
+uint64_t CNarcissisticEngine::findInRange( uint64_t min, uint64_t max, const TFoundFunction& foundFunc, const TContinueFunction& continueFunc ) const
+{
+    for ( auto ii = min; ii < max; ++ii )
+    {
+        if ( ( ( ( ii - min ) % kCheckInterval ) == 0 ) && continueFunc && !continueFunc( ii ) )
+            return ii;
+
+        bool aOK = true;
+        if ( isNarcissistic( ii, aOK ) )
+            foundFunc( ii );
+        if ( !aOK )
+            return ii;
+    }
+    return max;
+}
+
+int CNarcissisticEngine::numDigits( uint64_t value ) const
+{
+    int retVal = 1;
+    while ( ( static_cast< size_t >( retVal ) < fBasePowers.size() ) && ( value >= fBasePowers[ retVal ] ) )
+        retVal++;
+    return retVal;
+}
+
+int CNarcissisticEngine::computeNumDigits( uint64_t value, int base )
+{
+    int retVal = 1;
+    for ( value /= base; value; value /= base )
+        retVal++;
+    return retVal;
+}
+
+uint64_t CNarcissisticEngine::firstWithDigits( int numDigits ) const
+{
+    if ( numDigits <= 1 )
+        return 0;
+    if ( static_cast< size_t >( numDigits ) > fBasePowers.size() )
+        return kSaturated;
+    return fBasePowers[ numDigits - 1 ];
+}
+
+uint64_t CNarcissisticEngine::addSat( uint64_t lhs, uint64_t rhs )
+{
+    if ( lhs > kSaturated - rhs )
+        return kSaturated;
+    return lhs + rhs;
+}
+
+uint64_t CNarcissisticEngine::mulSat( uint64_t lhs, uint64_t rhs )
+{
+    if ( lhs && ( rhs > kSaturated / lhs ) )
+        return kSaturated;
+    return lhs * rhs;
+}
+
+uint64_t CNarcissisticEngine::powerSat( uint64_t x, uint64_t y )
+{
+    uint64_t retVal = 1;
+    for ( uint64_t ii = 0; ii < y; ++ii )
+    {
+        retVal = mulSat( retVal, x );
+        if ( retVal == kSaturated )
+            break;
+    }
+    return retVal;
+}
+
+uint64_t CNarcissisticEngine::power( uint64_t x, uint64_t y ) const
+{
+    return fPowerFunction ? fPowerFunction( x, y ) : powerSat( x, y );
+}
+
+CNarcissisticEngineRegistry& CNarcissisticEngineRegistry::instance()
+{
+    static CNarcissisticEngineRegistry sRegistry;
+    return sRegistry;
+}
+
+CNarcissisticEngineRegistry::CNarcissisticEngineRegistry()
+{
+    registerEngine( "sabutils", "NUtils::isNarcissistic from SABUtils", []( int base, const CNarcissisticEngine::TPowerFunction& powerFunction ) { return std::make_shared< CSABUtilsEngine >( base, powerFunction ); } );
+    registerEngine( "string", "Digits from the string representation", []( int base, const CNarcissisticEngine::TPowerFunction& powerFunction ) { return std::make_shared< CStringEngine >( base, powerFunction ); } );
+    registerEngine( "division", "Digits by division, powers computed per digit", []( int base, const CNarcissisticEngine::TPowerFunction& powerFunction ) { return std::make_shared< CDivisionEngine >( base, powerFunction ); } );
+    registerEngine( "table", "Digits by division, powers from a table per digit length", []( int base, const CNarcissisticEngine::TPowerFunction& powerFunction ) { return std::make_shared< CTableEngine >( base, powerFunction ); } );
+    registerEngine( "block", "Blocks of digits by division, block power sums from a table per digit length", []( int base, const CNarcissisticEngine::TPowerFunction& powerFunction ) { return std::make_shared< CBlockEngine >( base, powerFunction ); } );
+    registerEngine( "nibble", "Packed 4 bit digits incremented without division, power sums updated per changed digit (bases 2-16)", []( int base, const CNarcissisticEngine::TPowerFunction& powerFunction ) { return std::make_shared< CNibbleEngine >( base, powerFunction ); } );
+}
+
+void CNarcissisticEngineRegistry::registerEngine( const std::string& name, const std::string& description, const TFactory& factory )
+{
+    std::lock_guard< std::mutex > lock( fMutex );
+    if ( fEngines.find( name ) == fEngines.end() )
+        fOrder.push_back( name );
+    fEngines[ name ] = { description, factory };
+}
+
+bool CNarcissisticEngineRegistry::hasEngine( const std::string& name ) const
+{
+    if ( name == "auto" )
+        return true;
+    std::lock_guard< std::mutex > lock( fMutex );
+    return fEngines.find( name ) != fEngines.end();
+}
+
+std::list< std::string > CNarcissisticEngineRegistry::names() const
+{
+    std::lock_guard< std::mutex > lock( fMutex );
+    return fOrder;
+}
+
+std::string CNarcissisticEngineRegistry::description( const std::string& name ) const
+{
+    if ( name == "auto" )
+        return "Fastest engine for the base and digit length";
+    std::lock_guard< std::mutex > lock( fMutex );
+    auto pos = fEngines.find( name );
+    return ( pos == fEngines.end() ) ? std::string() : ( *pos ).second.fDescription;
+}
+
+std::shared_ptr< CNarcissisticEngine > CNarcissisticEngineRegistry::create( const std::string& name, int base, int numDigits, const CNarcissisticEngine::TPowerFunction& powerFunction )
+{
+    auto engineName = ( name == "auto" ) ? autoSelect( base, numDigits, powerFunction ) : name;
+
+    auto cacheKey = std::make_pair( engineName, base );
+    TFactory factory;
+    {
+        std::lock_guard< std::mutex > lock( fMutex );
+        auto pos = fEngines.find( engineName );
+        if ( pos == fEngines.end() )
+            return {};
+        factory = ( *pos ).second.fFactory;
+
+        auto cached = fEngineCache.find( cacheKey );
+        if ( !powerFunction && ( cached != fEngineCache.end() ) )
+            return ( *cached ).second;
+    }
+
+    auto retVal = factory( base, powerFunction );
+    if ( !powerFunction )
+    {
+        std::lock_guard< std::mutex > lock( fMutex );
+        fEngineCache[ cacheKey ] = retVal;
+    }
+    return retVal;
+}
+
+std::string CNarcissisticEngineRegistry::autoSelect( int base, int numDigits, const CNarcissisticEngine::TPowerFunction& powerFunction )
+{
+    auto key = std::make_pair( base, numDigits );
+    {
+        std::lock_guard< std::mutex > lock( fMutex );
+        auto pos = fAutoSelections.find( key );
+        if ( pos != fAutoSelections.end() )
+            return ( *pos ).second;
+    }
+
+    const uint64_t kSliceSize = 20000;
+    std::string retVal;
+    auto bestTime = std::chrono::steady_clock::duration::max();
+    std::map< std::string, double > timings;
+    for ( auto&& ii : names() )
+    {
+        auto engine = create( ii, base, numDigits, powerFunction );
+        auto min = engine->firstWithDigits( numDigits );
+        auto max = engine->addSat( min, kSliceSize );
+
+        // best of 3, the first run also warms up the engine
+        auto currTime = std::chrono::steady_clock::duration::max();
+        for ( int jj = 0; jj < 3; ++jj )
+        {
+            auto start = std::chrono::steady_clock::now();
+            engine->findInRange( min, max, []( uint64_t ) {}, {} );
+            currTime = std::min( currTime, std::chrono::steady_clock::now() - start );
+        }
+        if ( max > min )
+            timings[ ii ] = std::chrono::duration< double >( currTime ).count() / ( max - min );
+        if ( currTime < bestTime )
+        {
+            bestTime = currTime;
+            retVal = ii;
+        }
+    }
+
+    setAutoSelection( base, numDigits, retVal );
+    std::lock_guard< std::mutex > lock( fMutex );
+    fAutoTimings[ key ] = timings;
+    return retVal;
+}
+
+void CNarcissisticEngineRegistry::setAutoSelection( int base, int numDigits, const std::string& name )
+{
+    std::lock_guard< std::mutex > lock( fMutex );
+    fAutoSelections[ std::make_pair( base, numDigits ) ] = name;
+}
+
+std::map< std::pair< int, int >, std::string > CNarcissisticEngineRegistry::autoSelections() const
+{
+    std::lock_guard< std::mutex > lock( fMutex );
+    return fAutoSelections;
+}
+
+std::map< std::string, double > CNarcissisticEngineRegistry::autoTimings( int base, int numDigits ) const
+{
+    std::lock_guard< std::mutex > lock( fMutex );
+    auto pos = fAutoTimings.find( std::make_pair( base, numDigits ) );
+    return ( pos == fAutoTimings.end() ) ? std::map< std::string, double >() : ( *pos ).second;
+}
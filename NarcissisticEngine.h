@@ -0,0 +1,117 @@
+// The MIT License( MIT )
+//
+// Copyright( c ) 2020 Scott Aron Bloom
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sub-license, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef __NARCISSISTICENGINE_H
+#define __NARCISSISTICENGINE_H
+
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// An engine checks candidates for a single base, engines are immutable once created
+// so a single instance is shared by all the worker threads
+class CNarcissisticEngine
+{
+public:
+    using TPowerFunction = std::function< uint64_t( uint64_t, uint64_t ) >;
+    using TFoundFunction = std::function< void( uint64_t value ) >;
+    using TContinueFunction = std::function< bool( uint64_t curr ) >;
+
+    CNarcissisticEngine( int base, const TPowerFunction& powerFunction );
+    virtual ~CNarcissisticEngine();
+
+    virtual std::string name() const = 0;
+    int base() const { return fBase; }
+
+    // aOK is false when the value could not be analyzed
+    virtual bool isNarcissistic( uint64_t value, bool& aOK ) const = 0;
+
+    // calls foundFunc for every narcissistic number in [min:max)
+    // continueFunc is called every kCheckInterval candidates, when it returns false the search stops
+    // returns the first value not checked, max when the full range was checked
+    virtual uint64_t findInRange( uint64_t min, uint64_t max, const TFoundFunction& foundFunc, const TContinueFunction& continueFunc ) const;
+
+    // bytes of lookup tables owned by the engine
+    virtual size_t memoryFootprint() const { return 0; }
+
+    int numDigits( uint64_t value ) const;
+    static int computeNumDigits( uint64_t value, int base );
+    // b^(numDigits-1), 0 for 1 digit
+    uint64_t firstWithDigits( int numDigits ) const;
+
+    static uint64_t addSat( uint64_t lhs, uint64_t rhs );
+    static uint64_t mulSat( uint64_t lhs, uint64_t rhs );
+    static uint64_t powerSat( uint64_t x, uint64_t y );
+
+    static const uint64_t kCheckInterval{ 1024 };
+protected:
+    uint64_t power( uint64_t x, uint64_t y ) const;
+
+    int fBase{ 10 };
+    TPowerFunction fPowerFunction;
+    std::vector< uint64_t > fBasePowers; // fBasePowers[ k ] == b^k, saturated
+};
+
+class CNarcissisticEngineRegistry
+{
+public:
+    using TFactory = std::function< std::shared_ptr< CNarcissisticEngine >( int base, const CNarcissisticEngine::TPowerFunction& powerFunction ) >;
+
+    static CNarcissisticEngineRegistry& instance();
+
+    void registerEngine( const std::string& name, const std::string& description, const TFactory& factory );
+    bool hasEngine( const std::string& name ) const;
+    std::list< std::string > names() const; // does not include "auto"
+    std::string description( const std::string& name ) const;
+
+    // "auto" is resolved via autoSelect
+    // engines using the default power function are cached, so repeated runs reuse their tables
+    std::shared_ptr< CNarcissisticEngine > create( const std::string& name, int base, int numDigits, const CNarcissisticEngine::TPowerFunction& powerFunction = {} );
+
+    // micro-benchmarks every engine for the base and digit length, the choice is cached
+    std::string autoSelect( int base, int numDigits, const CNarcissisticEngine::TPowerFunction& powerFunction = {} );
+    void setAutoSelection( int base, int numDigits, const std::string& name );
+    std::map< std::pair< int, int >, std::string > autoSelections() const;
+    // seconds per candidate of each engine measured by autoSelect, empty if the base and length was not benchmarked
+    std::map< std::string, double > autoTimings( int base, int numDigits ) const;
+private:
+    CNarcissisticEngineRegistry();
+
+    struct SEngineInfo
+    {
+        std::string fDescription;
+        TFactory fFactory;
+    };
+
+    mutable std::mutex fMutex;
+    std::map< std::string, SEngineInfo > fEngines;
+    std::list< std::string > fOrder;
+    std::map< std::pair< int, int >, std::string > fAutoSelections;
+    std::map< std::pair< int, int >, std::map< std::string, double > > fAutoTimings;
+    std::map< std::pair< std::string, int >, std::shared_ptr< CNarcissisticEngine > > fEngineCache; // by name and base, only engines with the default power function
+};
+#endif
@@ -0,0 +1,278 @@
+// The MIT License( MIT )
+//
+// Copyright( c ) 2020 Scott Aron Bloom
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sub-license, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "NarcissisticIndex.h"
+
+#include <QFile>
+#include <QLockFile>
+#include <QSaveFile>
+#include <QDir>
+#include <QStandardPaths>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <iterator>
+
+namespace
+{
+    const char kMagic[ 8 ] = { 'N', 'A', 'R', 'C', 'I', 'D', 'X', 0 };
+    const uint32_t kVersion = 2;
+}
+
+size_t CNarcissisticIndex::headerSize( uint32_t version )
+{
+    return ( version == 1 ) ? offsetof( SHeader, fNumIntervals ) : sizeof( SHeader );
+}
+
+CNarcissisticIndex::CNarcissisticIndex( int base ) :
+    fBase( base )
+{
+    map();
+}
+
+CNarcissisticIndex::~CNarcissisticIndex()
+{
+    unmap();
+}
+
+std::string CNarcissisticIndex::indexDir()
+{
+    auto dir = QStandardPaths::writableLocation( QStandardPaths::AppDataLocation ) + "/index";
+    return QDir::toNativeSeparators( dir ).toStdString();
+}
+
+std::string CNarcissisticIndex::fileName() const
+{
+    return indexDir() + QString( "/base_%1.idx" ).arg( fBase, 2, 10, QChar( '0' ) ).toStdString();
+}
+
+void CNarcissisticIndex::map()
+{
+    unmap();
+
+    fFile.reset( new QFile( QString::fromStdString( fileName() ) ) );
+    if ( !fFile->exists() || !fFile->open( QIODevice::ReadOnly ) )
+        return;
+
+    if ( fFile->size() < static_cast< qint64 >( headerSize( 1 ) ) )
+        return unmap();
+
+    auto data = fFile->map( 0, fFile->size() );
+    if ( !data )
+        return unmap();
+
+    auto header = reinterpret_cast< const SHeader* >( data );
+    if ( ( std::memcmp( header->fMagic, kMagic, sizeof( kMagic ) ) != 0 )
+        || ( ( header->fVersion != 1 ) && ( header->fVersion != kVersion ) )
+        || ( header->fBase != static_cast< uint32_t >( fBase ) ) )
+    {
+        return unmap();
+    }
+
+    auto size = static_cast< uint64_t >( fFile->size() );
+    auto hdrSize = headerSize( header->fVersion );
+    uint64_t numIntervals = 0;
+    if ( header->fVersion != 1 )
+    {
+        if ( size < hdrSize )
+            return unmap();
+        numIntervals = header->fNumIntervals;
+    }
+    auto expectedSize = hdrSize + ( 2 * numIntervals + header->fCount ) * sizeof( uint64_t );
+    if ( size != expectedSize )
+        return unmap();
+
+    fHeader = header;
+    if ( header->fVersion == 1 )
+    {
+        fV1Interval[ 0 ] = 0;
+        fV1Interval[ 1 ] = header->fCoverageBound;
+        fIntervals = fV1Interval;
+        fNumIntervals = header->fCoverageBound ? 1 : 0;
+    }
+    else
+    {
+        fIntervals = reinterpret_cast< const uint64_t* >( data + hdrSize );
+        fNumIntervals = numIntervals;
+    }
+    fValues = reinterpret_cast< const uint64_t* >( data + hdrSize ) + 2 * numIntervals;
+}
+
+void CNarcissisticIndex::unmap()
+{
+    fHeader = nullptr;
+    fIntervals = nullptr;
+    fNumIntervals = 0;
+    fValues = nullptr;
+    if ( fFile )
+        fFile->close(); // unmaps any mapped regions
+    fFile.reset();
+}
+
+uint64_t CNarcissisticIndex::coverageBound() const
+{
+    return ( fNumIntervals && ( fIntervals[ 0 ] == 0 ) ) ? fIntervals[ 1 ] : 0;
+}
+
+bool CNarcissisticIndex::covers( uint64_t value ) const
+{
+    // the last interval starting at or below the value
+    uint64_t lo = 0;
+    uint64_t hi = fNumIntervals;
+    while ( lo < hi )
+    {
+        auto mid = lo + ( hi - lo ) / 2;
+        if ( fIntervals[ 2 * mid ] <= value )
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return ( lo != 0 ) && ( value < fIntervals[ 2 * ( lo - 1 ) + 1 ] );
+}
+
+std::list< CNarcissisticIndex::TInterval > CNarcissisticIndex::coveredIntervals() const
+{
+    std::list< TInterval > retVal;
+    for ( uint64_t ii = 0; ii < fNumIntervals; ++ii )
+        retVal.emplace_back( fIntervals[ 2 * ii ], fIntervals[ 2 * ii + 1 ] );
+    return retVal;
+}
+
+std::list< CNarcissisticIndex::TInterval > CNarcissisticIndex::gaps( uint64_t min, uint64_t max ) const
+{
+    std::list< TInterval > retVal;
+    auto curr = min;
+    for ( uint64_t ii = 0; ( ii < fNumIntervals ) && ( curr < max ); ++ii )
+    {
+        auto first = fIntervals[ 2 * ii ];
+        auto second = fIntervals[ 2 * ii + 1 ];
+        if ( second <= curr )
+            continue;
+        if ( first > curr )
+            retVal.emplace_back( curr, std::min( first, max ) );
+        curr = std::max( curr, second );
+    }
+    if ( curr < max )
+        retVal.emplace_back( curr, max );
+    return retVal;
+}
+
+std::list< uint64_t > CNarcissisticIndex::values( uint64_t min, uint64_t max ) const
+{
+    if ( !fHeader )
+        return {};
+    auto end = fValues + fHeader->fCount;
+    return std::list< uint64_t >( std::lower_bound( fValues, end, min ), std::lower_bound( fValues, end, max ) );
+}
+
+bool CNarcissisticIndex::contains( uint64_t value ) const
+{
+    if ( !fHeader )
+        return false;
+    return std::binary_search( fValues, fValues + fHeader->fCount, value );
+}
+
+bool CNarcissisticIndex::extend( uint64_t min, uint64_t max, const std::list< uint64_t >& found )
+{
+    return extend( std::list< TInterval >( { std::make_pair( min, max ) } ), found );
+}
+
+bool CNarcissisticIndex::extend( const std::list< TInterval >& searched, const std::list< uint64_t >& found )
+{
+    if ( std::none_of( searched.begin(), searched.end(), []( const TInterval& ii ) { return ii.first < ii.second; } ) )
+        return false;
+
+    // other calculators, in this process or another, may have extended the file since it was mapped,
+    // so it is re-read under the lock and merged with
+    if ( !QDir().mkpath( QString::fromStdString( indexDir() ) ) )
+        return false;
+    QLockFile lock( QString::fromStdString( fileName() + ".lock" ) );
+    if ( !lock.lock() )
+        return false;
+    map();
+
+    auto intervals = coveredIntervals();
+    std::list< uint64_t > values;
+    if ( fHeader )
+        values.assign( fValues, fValues + fHeader->fCount );
+
+    for ( auto&& ii : searched )
+    {
+        if ( ii.first >= ii.second )
+            continue;
+        for ( auto&& jj : found )
+        {
+            if ( ( jj >= ii.first ) && ( jj < ii.second ) )
+                values.push_back( jj );
+        }
+        intervals.push_back( ii );
+    }
+
+    // merge the overlapping and adjacent intervals
+    intervals.sort();
+    for ( auto ii = intervals.begin(); ii != intervals.end(); )
+    {
+        auto next = std::next( ii );
+        if ( ( next != intervals.end() ) && ( ( *next ).first <= ( *ii ).second ) )
+        {
+            ( *ii ).second = std::max( ( *ii ).second, ( *next ).second );
+            intervals.erase( next );
+        }
+        else
+            ++ii;
+    }
+    values.sort();
+    values.unique();
+
+    unmap(); // a mapped file cannot be replaced on all platforms
+    auto aOK = write( intervals, values );
+    map();
+    return aOK;
+}
+
+bool CNarcissisticIndex::write( const std::list< TInterval >& intervals, const std::list< uint64_t >& values )
+{
+    if ( !QDir().mkpath( QString::fromStdString( indexDir() ) ) )
+        return false;
+
+    QSaveFile file( QString::fromStdString( fileName() ) );
+    if ( !file.open( QIODevice::WriteOnly ) )
+        return false;
+
+    SHeader header;
+    std::memcpy( header.fMagic, kMagic, sizeof( kMagic ) );
+    header.fVersion = kVersion;
+    header.fBase = static_cast< uint32_t >( fBase );
+    header.fCoverageBound = ( !intervals.empty() && ( intervals.front().first == 0 ) ) ? intervals.front().second : 0;
+    header.fCount = values.size();
+    header.fNumIntervals = intervals.size();
+    file.write( reinterpret_cast< const char* >( &header ), sizeof( header ) );
+    for ( auto&& ii : intervals )
+    {
+        file.write( reinterpret_cast< const char* >( &ii.first ), sizeof( ii.first ) );
+        file.write( reinterpret_cast< const char* >( &ii.second ), sizeof( ii.second ) );
+    }
+    for ( auto&& ii : values )
+        file.write( reinterpret_cast< const char* >( &ii ), sizeof( ii ) );
+    return file.commit();
+}
@@ -0,0 +1,92 @@
+// The MIT License( MIT )
+//
+// Copyright( c ) 2020 Scott Aron Bloom
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sub-license, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef __NARCISSISTICINDEX_H
+#define __NARCISSISTICINDEX_H
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <string>
+#include <utility>
+
+class QFile;
+
+// On disk, memory mapped, index of the narcissistic numbers known for a single base.
+// The index records a set of disjoint covered intervals, every value in them has been
+// checked by a completed run, so any covered value can be answered with a binary search
+// and a run only needs to search the gaps
+class CNarcissisticIndex
+{
+public:
+    using TInterval = std::pair< uint64_t, uint64_t >; // [first:second)
+
+    CNarcissisticIndex( int base );
+    ~CNarcissisticIndex();
+
+    int base() const { return fBase; }
+    // every value in [0:bound) is covered
+    uint64_t coverageBound() const;
+    bool covers( uint64_t value ) const;
+    std::list< TInterval > coveredIntervals() const;
+    // the parts of [min:max) that are not covered
+    std::list< TInterval > gaps( uint64_t min, uint64_t max ) const;
+
+    // only valid for values that are covered
+    bool contains( uint64_t value ) const;
+    // the known values in [min:max)
+    std::list< uint64_t > values( uint64_t min, uint64_t max ) const;
+
+    // the values found by a completed run of [min:max), the interval is merged into the coverage
+    // the file is locked (base_NN.idx.lock) and re-read first, so concurrent runs never drop each others coverage
+    bool extend( uint64_t min, uint64_t max, const std::list< uint64_t >& found );
+    bool extend( const std::list< TInterval >& searched, const std::list< uint64_t >& found );
+
+    static std::string indexDir();
+    std::string fileName() const;
+private:
+    // version 2, the header is followed by fNumIntervals sorted intervals (first, second) then fCount sorted values
+    // version 1 files (no intervals, fCoverageBound only) are read as the single interval [0:fCoverageBound)
+    struct SHeader
+    {
+        char fMagic[ 8 ];
+        uint32_t fVersion;
+        uint32_t fBase;
+        uint64_t fCoverageBound;
+        uint64_t fCount;
+        uint64_t fNumIntervals; // version 2 only
+    };
+    static size_t headerSize( uint32_t version );
+
+    void map();
+    void unmap();
+    bool write( const std::list< TInterval >& intervals, const std::list< uint64_t >& values );
+
+    int fBase{ 10 };
+    std::unique_ptr< QFile > fFile;
+    const SHeader* fHeader{ nullptr };
+    const uint64_t* fIntervals{ nullptr }; // pairs
+    uint64_t fNumIntervals{ 0 };
+    uint64_t fV1Interval[ 2 ]{ 0, 0 }; // the interval of a version 1 file
+    const uint64_t* fValues{ nullptr };
+};
+#endif
@@ -0,0 +1,155 @@
+// The MIT License( MIT )
+//
+// Copyright( c ) 2020 Scott Aron Bloom
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sub-license, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "NarcissisticMetrics.h"
+
+#include <algorithm>
+#include <functional>
+#include <iomanip>
+#include <map>
+#include <sstream>
+
+void CNarcissisticMetrics::SJob::reset()
+{
+    fRunning = false;
+    fPaused = false;
+    fNumThreads = 0;
+    for ( size_t ii = 0; ii < kMaxThreads; ++ii )
+    {
+        fThreadCandidates[ ii ] = 0;
+        fThreadBusyNanos[ ii ] = 0;
+    }
+    fCandidates = 0;
+    fHits = 0;
+    fPartitionsCompleted = 0;
+    fPartitionsRemaining = 0;
+    fQueueDepth = 0;
+    fActiveThreads = 0;
+    fLockWaitNanos = 0;
+    fLockAcquisitions = 0;
+    fETANanos = 0;
+}
+
+void CNarcissisticMetrics::SJob::addThreadWork( size_t threadNum, uint64_t candidates, uint64_t busyNanos )
+{
+    threadNum = std::min( threadNum, kMaxThreads - 1 );
+    fThreadCandidates[ threadNum ].fetch_add( candidates, std::memory_order_relaxed );
+    fThreadBusyNanos[ threadNum ].fetch_add( busyNanos, std::memory_order_relaxed );
+    fCandidates.fetch_add( candidates, std::memory_order_relaxed );
+
+    auto numThreads = fNumThreads.load( std::memory_order_relaxed );
+    while ( ( numThreads <= threadNum ) && !fNumThreads.compare_exchange_weak( numThreads, threadNum + 1, std::memory_order_relaxed ) )
+        ;
+}
+
+CNarcissisticMetrics& CNarcissisticMetrics::instance()
+{
+    static CNarcissisticMetrics sInstance;
+    return sInstance;
+}
+
+std::shared_ptr< CNarcissisticMetrics::SJob > CNarcissisticMetrics::addJob()
+{
+    auto retVal = std::make_shared< SJob >();
+    std::unique_lock< std::mutex > lock( fMutex );
+    retVal->fId = fNextId++;
+    fJobs.push_back( retVal );
+    return retVal;
+}
+
+void CNarcissisticMetrics::removeJob( const std::shared_ptr< SJob >& job )
+{
+    std::unique_lock< std::mutex > lock( fMutex );
+    fJobs.remove( job );
+}
+
+namespace
+{
+    void writeHeader( std::ostringstream& oss, const char* name, const char* type, const char* help )
+    {
+        oss << "# HELP " << name << " " << help << "\n";
+        oss << "# TYPE " << name << " " << type << "\n";
+    }
+}
+
+std::string CNarcissisticMetrics::prometheusText() const
+{
+    std::list< std::shared_ptr< SJob > > jobs;
+    {
+        std::unique_lock< std::mutex > lock( fMutex );
+        jobs = fJobs;
+    }
+
+    std::ostringstream oss;
+    oss << std::setprecision( 15 );
+    auto labels = []( const std::shared_ptr< SJob >& job )
+    {
+        return "job=\"" + std::to_string( job->fId ) + "\",base=\"" + std::to_string( job->fBase.load( std::memory_order_relaxed ) ) + "\"";
+    };
+    auto writeJobValues = [ &oss, &jobs, &labels ]( const char* name, const char* type, const char* help, const std::function< double( const SJob& ) >& value )
+    {
+        writeHeader( oss, name, type, help );
+        for ( auto&& ii : jobs )
+            oss << name << "{" << labels( ii ) << "} " << value( *ii ) << "\n";
+    };
+    auto load = []( const std::atomic< uint64_t >& value ) { return static_cast< double >( value.load( std::memory_order_relaxed ) ); };
+
+    writeJobValues( "narcissistic_running", "gauge", "1 while the calculator has a run in progress", []( const SJob& job ) { return job.fRunning.load( std::memory_order_relaxed ) ? 1.0 : 0.0; } );
+    writeJobValues( "narcissistic_paused", "gauge", "1 while the run is paused", []( const SJob& job ) { return job.fPaused.load( std::memory_order_relaxed ) ? 1.0 : 0.0; } );
+    writeJobValues( "narcissistic_candidates_total", "counter", "Candidates checked", [ &load ]( const SJob& job ) { return load( job.fCandidates ); } );
+    writeJobValues( "narcissistic_hits", "gauge", "Narcissistic numbers found by the run", [ &load ]( const SJob& job ) { return load( job.fHits ); } );
+    writeJobValues( "narcissistic_partitions_completed_total", "counter", "Partitions completed", [ &load ]( const SJob& job ) { return load( job.fPartitionsCompleted ); } );
+    writeJobValues( "narcissistic_partitions_remaining", "gauge", "Partitions not yet started", [ &load ]( const SJob& job ) { return load( job.fPartitionsRemaining ); } );
+    writeJobValues( "narcissistic_queue_depth", "gauge", "Partitions queued or requeued (not counting the uncut range)", [ &load ]( const SJob& job ) { return load( job.fQueueDepth ); } );
+    writeJobValues( "narcissistic_active_threads", "gauge", "Threads running a partition", [ &load ]( const SJob& job ) { return load( job.fActiveThreads ); } );
+    writeJobValues( "narcissistic_lock_wait_seconds_total", "counter", "Time the workers waited for the calculator lock, measured while scraping is enabled", [ &load ]( const SJob& job ) { return load( job.fLockWaitNanos ) / 1e9; } );
+    writeJobValues( "narcissistic_lock_acquisitions_total", "counter", "Calculator lock acquisitions measured", [ &load ]( const SJob& job ) { return load( job.fLockAcquisitions ); } );
+    writeJobValues( "narcissistic_eta_seconds", "gauge", "Estimated time to finish the run", [ &load ]( const SJob& job ) { return load( job.fETANanos ) / 1e9; } );
+
+    writeHeader( oss, "narcissistic_thread_candidates_total", "counter", "Candidates checked by each thread" );
+    for ( auto&& ii : jobs )
+    {
+        auto numThreads = std::min( ii->fNumThreads.load( std::memory_order_relaxed ), kMaxThreads );
+        for ( size_t jj = 0; jj < numThreads; ++jj )
+            oss << "narcissistic_thread_candidates_total{" << labels( ii ) << ",thread=\"" << jj << "\"} " << load( ii->fThreadCandidates[ jj ] ) << "\n";
+    }
+    writeHeader( oss, "narcissistic_thread_candidates_per_second", "gauge", "Candidates per busy second of each thread" );
+    for ( auto&& ii : jobs )
+    {
+        auto numThreads = std::min( ii->fNumThreads.load( std::memory_order_relaxed ), kMaxThreads );
+        for ( size_t jj = 0; jj < numThreads; ++jj )
+        {
+            auto busy = load( ii->fThreadBusyNanos[ jj ] ) / 1e9;
+            oss << "narcissistic_thread_candidates_per_second{" << labels( ii ) << ",thread=\"" << jj << "\"} " << ( ( busy > 0.0 ) ? ( load( ii->fThreadCandidates[ jj ] ) / busy ) : 0.0 ) << "\n";
+        }
+    }
+
+    // hits summed over every calculator of a base
+    std::map< int, uint64_t > hitsPerBase;
+    for ( auto&& ii : jobs )
+        hitsPerBase[ ii->fBase.load( std::memory_order_relaxed ) ] += ii->fHits.load( std::memory_order_relaxed );
+    writeHeader( oss, "narcissistic_base_hits", "gauge", "Narcissistic numbers found for each base" );
+    for ( auto&& ii : hitsPerBase )
+        oss << "narcissistic_base_hits{base=\"" << ii.first << "\"} " << ii.second << "\n";
+    return oss.str();
+}
@@ -0,0 +1,85 @@
+// The MIT License( MIT )
+//
+// Copyright( c ) 2020 Scott Aron Bloom
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sub-license, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#ifndef __NARCISSISTICMETRICS_H
+#define __NARCISSISTICMETRICS_H
+
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+
+// Live counters of every calculator, rendered in the Prometheus text format by CNarcissisticMetricsServer
+// The workers only ever update atomics, a scrape reads them without taking any calculator lock
+class CNarcissisticMetrics
+{
+public:
+    static const size_t kMaxThreads{ 256 }; // per thread values of higher thread numbers are folded into the last
+
+    struct SJob
+    {
+        SJob() { reset(); }
+        SJob( const SJob& ) = delete;
+        SJob& operator=( const SJob& ) = delete;
+        void reset();
+        void addThreadWork( size_t threadNum, uint64_t candidates, uint64_t busyNanos );
+
+        uint64_t fId{ 0 };
+        std::atomic< int > fBase{ 10 };
+        std::atomic< bool > fRunning{ false };
+        std::atomic< bool > fPaused{ false };
+        std::atomic< size_t > fNumThreads{ 0 };
+        std::atomic< uint64_t > fThreadCandidates[ kMaxThreads ];
+        std::atomic< uint64_t > fThreadBusyNanos[ kMaxThreads ];
+        std::atomic< uint64_t > fCandidates{ 0 };
+        std::atomic< uint64_t > fHits{ 0 };
+        std::atomic< uint64_t > fPartitionsCompleted{ 0 };
+        std::atomic< uint64_t > fPartitionsRemaining{ 0 };
+        std::atomic< uint64_t > fQueueDepth{ 0 }; // partitions already cut, queued or requeued
+        std::atomic< uint64_t > fActiveThreads{ 0 };
+        std::atomic< uint64_t > fLockWaitNanos{ 0 };
+        std::atomic< uint64_t > fLockAcquisitions{ 0 };
+        std::atomic< uint64_t > fETANanos{ 0 };
+    };
+
+    static CNarcissisticMetrics& instance();
+
+    std::shared_ptr< SJob > addJob();
+    void removeJob( const std::shared_ptr< SJob >& job );
+
+    // lock wait times are only measured while someone is scraping
+    void setEnabled( bool value ){ fEnabled = value; }
+    bool enabled() const { return fEnabled.load( std::memory_order_relaxed ); }
+
+    std::string prometheusText() const;
+private:
+    CNarcissisticMetrics() {}
+
+    std::atomic< bool > fEnabled{ false };
+    mutable std::mutex fMutex; // guards fJobs, never held by a worker
+    std::list< std::shared_ptr< SJob > > fJobs;
+    uint64_t fNextId{ 0 };
+};
+#endif
@@ -0,0 +1,132 @@
+// The MIT License( MIT )
+//
+// Copyright( c ) 2020 Scott Aron Bloom
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sub-license, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "NarcissisticMetricsServer.h"
+#include "NarcissisticMetrics.h"
+
+#include <QThread>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QHostAddress>
+
+CNarcissisticMetricsServer& CNarcissisticMetricsServer::instance()
+{
+    static CNarcissisticMetricsServer sInstance;
+    return sInstance;
+}
+
+CNarcissisticMetricsServer::~CNarcissisticMetricsServer()
+{
+    close();
+}
+
+bool CNarcissisticMetricsServer::listen( uint16_t port, std::string& errorMsg )
+{
+    close();
+
+    fThread = new QThread;
+    fThread->setObjectName( "metrics" );
+    fServer = new QTcpServer;
+    fServer->moveToThread( fThread );
+    fThread->start();
+
+    auto server = fServer;
+    QObject::connect( server, &QTcpServer::newConnection, server,
+        [ server ]()
+        {
+            while ( auto socket = server->nextPendingConnection() )
+            {
+                QObject::connect( socket, &QTcpSocket::disconnected, socket, &QObject::deleteLater );
+                QObject::connect( socket, &QTcpSocket::readyRead, socket,
+                    [ socket ]()
+                    {
+                        // one request per connection, answered once its headers are complete
+                        auto request = socket->property( "request" ).toByteArray() + socket->readAll();
+                        if ( !request.contains( "\r\n\r\n" ) && !request.contains( "\n\n" ) )
+                        {
+                            socket->setProperty( "request", request );
+                            return;
+                        }
+
+                        auto requestLine = request.left( request.indexOf( '\n' ) ).trimmed().split( ' ' );
+                        auto method = requestLine.value( 0 );
+                        auto path = requestLine.value( 1 );
+                        QByteArray status = "200 OK";
+                        QByteArray body;
+                        if ( ( method != "GET" ) && ( method != "HEAD" ) )
+                            status = "405 Method Not Allowed";
+                        else if ( ( path == "/metrics" ) || ( path == "/" ) )
+                            body = QByteArray::fromStdString( CNarcissisticMetrics::instance().prometheusText() );
+                        else
+                            status = "404 Not Found";
+
+                        QByteArray response = "HTTP/1.1 " + status + "\r\n"
+                            "Content-Type: text/plain; version=0.0.4; charset=utf-8\r\n"
+                            "Content-Length: " + QByteArray::number( body.size() ) + "\r\n"
+                            "Connection: close\r\n\r\n";
+                        if ( method != "HEAD" )
+                            response += body;
+                        socket->write( response );
+                        socket->disconnectFromHost();
+                    } );
+            }
+        } );
+
+    bool aOK = false;
+    QString error;
+    quint16 actualPort = 0;
+    QMetaObject::invokeMethod( server,
+        [ server, port, &aOK, &error, &actualPort ]()
+        {
+            aOK = server->listen( QHostAddress::LocalHost, port );
+            error = server->errorString();
+            actualPort = server->serverPort();
+        }, Qt::BlockingQueuedConnection );
+
+    if ( !aOK )
+    {
+        errorMsg = error.toStdString();
+        close();
+        return false;
+    }
+    fPort = actualPort;
+    CNarcissisticMetrics::instance().setEnabled( true );
+    return true;
+}
+
+void CNarcissisticMetricsServer::close()
+{
+    // main() closes it while the application exists, from the static destructor nothing is touched
+    if ( !fThread )
+        return;
+    CNarcissisticMetrics::instance().setEnabled( false );
+    fPort = 0;
+
+    // the server and its sockets are destroyed in their own thread
+    QMetaObject::invokeMethod( fServer, "deleteLater", Qt::QueuedConnection );
+    fServer = nullptr;
+    fThread->quit();
+    fThread->wait();
+    delete fThread;
+    fThread = nullptr;
+}
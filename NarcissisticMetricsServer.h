@@ -0,0 +1,52 @@
+// The MIT License( MIT )
+//
+// Copyright( c ) 2020 Scott Aron Bloom
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sub-license, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#ifndef __NARCISSISTICMETRICSSERVER_H
+#define __NARCISSISTICMETRICSSERVER_H
+
+#include <cstdint>
+#include <string>
+
+class QThread;
+class QTcpServer;
+
+// Serves CNarcissisticMetrics on http://127.0.0.1:<port>/metrics from its own thread and event loop,
+// so it works while run() blocks the main thread, and a scrape never waits on the workers
+class CNarcissisticMetricsServer
+{
+public:
+    static CNarcissisticMetricsServer& instance();
+    ~CNarcissisticMetricsServer();
+
+    bool listen( uint16_t port, std::string& errorMsg ); // 0 picks a free port
+    void close();
+    bool isListening() const { return fPort != 0; }
+    uint16_t port() const { return fPort; }
+private:
+    CNarcissisticMetricsServer() {}
+
+    QThread* fThread{ nullptr };
+    QTcpServer* fServer{ nullptr }; // lives in fThread
+    uint16_t fPort{ 0 };
+};
+#endif
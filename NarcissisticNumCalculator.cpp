@@ -21,16 +21,32 @@
 // SOFTWARE.
 
 #include "NarcissisticNumCalculator.h"
+#include "NarcissisticIndex.h"
+#include "NarcissisticEngine.h"
+#include "NarcissisticTable.h"
+#include "NarcissisticTrace.h"
+#include "NarcissisticMetricsServer.h"
+#include "NarcissisticOrbits.h"
+#include "NarcissisticShard.h"
 #include "SABUtils/utils.h"
 
 #include <QSettings>
 #include <QLocale>
 
 #include <iostream>
+#include <fstream>
+#include <iterator>
+#include <csignal>
 #include <cctype>
+#include <cerrno>
+#include <cstdlib>
 #include <string>
 #include <cstring>
+#include <limits>
 #include <sstream>
+#ifdef SIGTSTP
+#include <unistd.h>
+#endif
 
 namespace CNarcissisticNumCalculatorDefaults
 {
@@ -120,6 +136,38 @@ namespace CNarcissisticNumCalculatorDefaults
         return settings.setValue( "NumbersList", QVariant::fromValue( values ) );
     }
 
+    bool byRanges()
+    {
+        QSettings settings;
+        return settings.value( "ByRanges", false ).toBool();
+    }
+
+    void setByRanges( bool value )
+    {
+        QSettings settings;
+        return settings.setValue( "ByRanges", value );
+    }
+
+    std::list< std::pair< uint64_t, uint64_t > > rangesList()
+    {
+        // stored flat, min then max of each range
+        QSettings settings;
+        auto values = toIntList( settings.value( "RangesList", QVariant::fromValue( QList< QVariant >() ) ).value< QList< QVariant > >() );
+        std::list< std::pair< uint64_t, uint64_t > > retVal;
+        for ( auto ii = values.begin(); ( ii != values.end() ) && ( std::next( ii ) != values.end() ); std::advance( ii, 2 ) )
+            retVal.emplace_back( *ii, *std::next( ii ) );
+        return retVal;
+    }
+
+    void setRangesList( const std::list< std::pair< uint64_t, uint64_t > >& value )
+    {
+        QSettings settings;
+        QList< QVariant > values;
+        for ( auto&& ii : value )
+            values << ii.first << ii.second;
+        return settings.setValue( "RangesList", QVariant::fromValue( values ) );
+    }
+
     bool useStringBasedAnalysis()
     {
         QSettings settings;
@@ -132,6 +180,65 @@ namespace CNarcissisticNumCalculatorDefaults
         return settings.setValue( "UseStringBasedAnalysis", value );
     }
 
+    bool useIndex()
+    {
+        QSettings settings;
+        return settings.value( "UseIndex", true ).toBool();
+    }
+
+    void setUseIndex( bool value )
+    {
+        QSettings settings;
+        return settings.setValue( "UseIndex", value );
+    }
+
+    bool useKnownTable()
+    {
+        QSettings settings;
+        return settings.value( "UseKnownTable", true ).toBool();
+    }
+
+    void setUseKnownTable( bool value )
+    {
+        QSettings settings;
+        return settings.setValue( "UseKnownTable", value );
+    }
+
+    std::string engine()
+    {
+        QSettings settings;
+        auto defaultEngine = useStringBasedAnalysis() ? "string" : "auto";
+        auto retVal = settings.value( "Engine", defaultEngine ).toString().toStdString();
+        return CNarcissisticEngineRegistry::instance().hasEngine( retVal ) ? retVal : "auto";
+    }
+
+    void setEngine( const std::string& value )
+    {
+        QSettings settings;
+        return settings.setValue( "Engine", QString::fromStdString( value ) );
+    }
+
+    // the registered engines are part of the key, so a choice made before an engine was added is never reused
+    QString autoEngineKey( int base, int numDigits )
+    {
+        std::string engines;
+        for ( auto&& ii : CNarcissisticEngineRegistry::instance().names() )
+            engines += ( engines.empty() ? "" : "+" ) + ii;
+        return QString( "AutoEngine/%1/%2_%3" ).arg( QString::fromStdString( engines ) ).arg( base ).arg( numDigits );
+    }
+
+    std::string autoEngine( int base, int numDigits )
+    {
+        QSettings settings;
+        return settings.value( autoEngineKey( base, numDigits ), QString() ).toString().toStdString();
+    }
+
+    void setAutoEngine( int base, int numDigits, const std::string& value )
+    {
+        QSettings settings;
+        return settings.setValue( autoEngineKey( base, numDigits ), QString::fromStdString( value ) );
+    }
+
     void reset()
     {
         QSettings settings;
@@ -141,20 +248,54 @@ namespace CNarcissisticNumCalculatorDefaults
         settings.remove( "ByRange" );
         settings.remove( "Range" );
         settings.remove( "NumbersList" );
+        settings.remove( "ByRanges" );
+        settings.remove( "RangesList" );
         settings.remove( "UseStringBasedAnalysis" );
+        settings.remove( "UseIndex" );
+        settings.remove( "UseKnownTable" );
+        settings.remove( "Engine" );
+        settings.remove( "AutoEngine" );
     }
 }
 
 CNarcissisticNumCalculator::CNarcissisticNumCalculator( bool saveSettings )
 {
     fSaveSettings = saveSettings;
+    fMetrics = CNarcissisticMetrics::instance().addJob();
     fNumThreads = std::thread::hardware_concurrency();
     loadSettings();
     init();
 }
 
+CNarcissisticNumCalculator::CNarcissisticNumCalculator( const SNarcissisticConfig& config )
+{
+    fSaveSettings = false;
+    fUseSettings = false;
+    fMetrics = CNarcissisticMetrics::instance().addJob();
+    fNumThreads = config.fNumThreads ? config.fNumThreads : std::thread::hardware_concurrency();
+    setBase( config.fBase );
+    fNumPerThread = std::max< uint64_t >( 1, config.fNumPerPartition );
+    fNumbers = std::make_tuple( config.fByRange, config.fRange, config.fNumbers );
+    if ( !config.fRanges.empty() )
+        setRanges( config.fRanges );
+    fEngineName = config.fEngine;
+    fUseIndex = config.fUseIndex;
+    fUseKnownTable = config.fUseKnownTable;
+    fPriority = config.fPriority;
+    fWeight = config.fWeight;
+    fResultWindow = config.fMaxBuffered;
+    fInlineThreshold = config.fInlineThreshold;
+    init();
+}
+
 CNarcissisticNumCalculator::~CNarcissisticNumCalculator()
 {
+    if ( fLaunched )
+    {
+        setStopped( true );
+        CNarcissisticThreadPool::instance().removeJob( this );
+    }
+    CNarcissisticMetrics::instance().removeJob( fMetrics );
     if ( fSaveSettings )
         saveSettings();
 }
@@ -177,11 +318,51 @@ bool CNarcissisticNumCalculator::parse( int argc, char** argv )
         {
             std::get< 0 >( fNumbers ) = true;
             std::get< 1 >( fNumbers ).first = getInt( ii, argc, argv, "-min", aOK );
+            fRanges.clear();
         }
         else if ( strncmp( argv[ ii ], "-max", 4 ) == 0 )
         {
             std::get< 0 >( fNumbers ) = true;
             std::get< 1 >( fNumbers ).second = getInt( ii, argc, argv, "-max", aOK );
+            fRanges.clear();
+        }
+        else if ( strncmp( argv[ ii ], "-ranges_file", 12 ) == 0 )
+        {
+            auto fileName = getString( ii, argc, argv, "-ranges_file", aOK );
+            std::ifstream iss( fileName );
+            if ( aOK && !iss )
+            {
+                std::cerr << "Could not open '" << fileName << "'" << std::endl;
+                aOK = false;
+            }
+            std::list< std::pair< uint64_t, uint64_t > > ranges;
+            std::string errorMsg;
+            if ( aOK && !parseRanges( std::string( std::istreambuf_iterator< char >( iss ), std::istreambuf_iterator< char >() ), ranges, errorMsg ) )
+            {
+                std::cerr << fileName << ": " << errorMsg << std::endl;
+                aOK = false;
+            }
+            if ( aOK )
+            {
+                ranges.insert( ranges.begin(), fRanges.begin(), fRanges.end() ); // added to any given by -ranges
+                setRanges( ranges );
+            }
+        }
+        else if ( strncmp( argv[ ii ], "-ranges", 7 ) == 0 )
+        {
+            std::string text;
+            while ( ( ( ii + 1 ) < argc ) && ( argv[ ii + 1 ][ 0 ] != '-' ) )
+                text += std::string( argv[ ++ii ] ) + " ";
+            std::list< std::pair< uint64_t, uint64_t > > ranges;
+            std::string errorMsg;
+            aOK = parseRanges( text, ranges, errorMsg ) && !ranges.empty();
+            if ( !aOK )
+                std::cerr << "-ranges requires a list of min:max ranges" << ( errorMsg.empty() ? "" : ", " ) << errorMsg << std::endl;
+            else
+            {
+                ranges.insert( ranges.begin(), fRanges.begin(), fRanges.end() );
+                setRanges( ranges );
+            }
         }
         else if ( strncmp( argv[ ii ], "-num_threads", 12 ) == 0 )
         {
@@ -195,6 +376,157 @@ bool CNarcissisticNumCalculator::parse( int argc, char** argv )
         {
             fReportSeconds = getInt( ii, argc, argv, "-report_seconds", aOK );
         }
+        else if ( strncmp( argv[ ii ], "-first_n", 8 ) == 0 )
+        {
+            fFirstN = getUInt64( ii, argc, argv, "-first_n", aOK );
+        }
+        else if ( strncmp( argv[ ii ], "-next_after", 11 ) == 0 )
+        {
+            auto value = getUInt64( ii, argc, argv, "-next_after", aOK );
+            if ( aOK )
+                setNextAfter( value );
+        }
+        else if ( strncmp( argv[ ii ], "-time_budget_ms", 15 ) == 0 )
+        {
+            fTimeBudget = std::chrono::milliseconds( getUInt64( ii, argc, argv, "-time_budget_ms", aOK ) );
+        }
+        else if ( strncmp( argv[ ii ], "-candidate_budget", 17 ) == 0 )
+        {
+            fCandidateBudget = getUInt64( ii, argc, argv, "-candidate_budget", aOK );
+        }
+        else if ( strncmp( argv[ ii ], "-throttle_cpu", 13 ) == 0 )
+        {
+            auto percent = getDouble( ii, argc, argv, "-throttle_cpu", aOK );
+            if ( aOK && ( ( percent <= 0 ) || ( percent > 100 ) ) )
+            {
+                std::cerr << "-throttle_cpu must be greater than 0 and at most 100" << std::endl;
+                aOK = false;
+            }
+            fThrottle.setCPUPercent( percent );
+        }
+        else if ( strncmp( argv[ ii ], "-throttle_rate", 14 ) == 0 )
+        {
+            auto rate = getDouble( ii, argc, argv, "-throttle_rate", aOK );
+            if ( aOK && ( rate <= 0 ) )
+            {
+                std::cerr << "-throttle_rate must be greater than 0" << std::endl;
+                aOK = false;
+            }
+            fThrottle.setRate( rate );
+        }
+        else if ( strncmp( argv[ ii ], "-adaptive_throttle", 18 ) == 0 )
+        {
+            fThrottle.setAdaptive( true );
+            aOK = true;
+        }
+        else if ( strncmp( argv[ ii ], "-idle_priority", 14 ) == 0 )
+        {
+            fThrottle.setIdlePriority( true );
+            aOK = true;
+        }
+        else if ( strncmp( argv[ ii ], "-trace", 6 ) == 0 )
+        {
+            fTraceFile = getString( ii, argc, argv, "-trace", aOK );
+        }
+        else if ( strncmp( argv[ ii ], "-metrics_port", 13 ) == 0 )
+        {
+            auto port = getInt( ii, argc, argv, "-metrics_port", aOK );
+            if ( aOK && ( ( port <= 0 ) || ( port > 65535 ) ) )
+            {
+                std::cerr << "-metrics_port must be between 1 and 65535" << std::endl;
+                aOK = false;
+            }
+            fMetricsPort = static_cast< uint16_t >( port );
+        }
+        else if ( strncmp( argv[ ii ], "-inline_threshold", 17 ) == 0 )
+        {
+            fInlineThreshold = getInt( ii, argc, argv, "-inline_threshold", aOK );
+            if ( aOK && ( fInlineThreshold < -1 ) )
+            {
+                std::cerr << "-inline_threshold must be -1 (calibrated), 0 (never) or a number of digit-candidates" << std::endl;
+                aOK = false;
+            }
+        }
+        else if ( strncmp( argv[ ii ], "-estimate", 9 ) == 0 )
+        {
+            fEstimateOnly = true;
+            aOK = true;
+        }
+        else if ( strncmp( argv[ ii ], "-orbits", 7 ) == 0 )
+        {
+            fOrbitPower = getInt( ii, argc, argv, "-orbits", aOK );
+            if ( aOK && ( fOrbitPower < 1 ) )
+            {
+                std::cerr << "-orbits requires a power of at least 1" << std::endl;
+                aOK = false;
+            }
+        }
+        else if ( strncmp( argv[ ii ], "-shard_file", 11 ) == 0 )
+        {
+            fShardFile = getString( ii, argc, argv, "-shard_file", aOK );
+        }
+        else if ( strncmp( argv[ ii ], "-shard", 6 ) == 0 )
+        {
+            // i/N, 0 <= i < N
+            auto value = getString( ii, argc, argv, "-shard", aOK );
+            std::istringstream iss( value );
+            int64_t shard = -1;
+            int64_t numShards = 0;
+            char separator = 0;
+            if ( aOK && ( !( iss >> shard >> separator >> numShards ) || ( separator != '/' ) || !iss.eof()
+                || ( numShards < 1 ) || ( numShards > std::numeric_limits< uint32_t >::max() ) || ( shard < 0 ) || ( shard >= numShards ) ) )
+            {
+                std::cerr << "-shard requires i/N with 0 <= i < N, not '" << value << "'" << std::endl;
+                aOK = false;
+            }
+            fShard = static_cast< uint32_t >( shard );
+            fNumShards = static_cast< uint32_t >( numShards );
+        }
+        else if ( strncmp( argv[ ii ], "-merge", 6 ) == 0 )
+        {
+            aOK = ( ( ii + 1 ) < argc ) && ( argv[ ii + 1 ][ 0 ] != '-' );
+            if ( !aOK )
+            {
+                std::cerr << "-merge requires a list of shard files\n";
+            }
+            while ( ( ( ii + 1 ) < argc ) && ( argv[ ii + 1 ][ 0 ] != '-' ) )
+                fMergeFiles.push_back( argv[ ++ii ] );
+        }
+        else if ( strncmp( argv[ ii ], "-priority", 9 ) == 0 )
+        {
+            fPriority = getInt( ii, argc, argv, "-priority", aOK );
+        }
+        else if ( strncmp( argv[ ii ], "-weight", 7 ) == 0 )
+        {
+            fWeight = getDouble( ii, argc, argv, "-weight", aOK );
+            if ( aOK && ( fWeight <= 0 ) )
+            {
+                std::cerr << "-weight must be greater than 0" << std::endl;
+                aOK = false;
+            }
+        }
+        else if ( strncmp( argv[ ii ], "-no_index", 9 ) == 0 )
+        {
+            fUseIndex = false;
+            aOK = true;
+        }
+        else if ( strncmp( argv[ ii ], "-engine", 7 ) == 0 )
+        {
+            fEngineName = getString( ii, argc, argv, "-engine", aOK );
+            if ( aOK && !CNarcissisticEngineRegistry::instance().hasEngine( fEngineName ) )
+            {
+                std::cerr << "Unknown engine '" << fEngineName << "', must be one of: auto";
+                for ( auto&& curr : CNarcissisticEngineRegistry::instance().names() )
+                    std::cerr << ", " << curr;
+                std::cerr << std::endl;
+                aOK = false;
+            }
+        }
+        else if ( strncmp( argv[ ii ], "-no_table", 9 ) == 0 )
+        {
+            fUseKnownTable = false;
+            aOK = true;
+        }
         else if ( strncmp( argv[ ii ], "-numbers", 8 ) == 0 )
         {
             std::get< 0 >( fNumbers ) = false;
@@ -225,19 +557,51 @@ bool CNarcissisticNumCalculator::parse( int argc, char** argv )
             return false;
 
     }
+
+    if ( fOrbitPower )
+    {
+        if ( !CNarcissisticOrbits::supported( fBase, fOrbitPower ) )
+        {
+            std::cerr << "-orbits " << fOrbitPower << " in base " << fBase << " needs a table of more than " << CNarcissisticOrbits::kMaxDomain << " values" << std::endl;
+            return false;
+        }
+        if ( isQuery() )
+        {
+            std::cerr << "-orbits can not be combined with -first_n, -next_after, -time_budget_ms or -candidate_budget" << std::endl;
+            return false;
+        }
+    }
+    if ( fNumShards && ( isQuery() || fOrbitPower ) )
+    {
+        std::cerr << "-shard can not be combined with -orbits, -first_n, -next_after, -time_budget_ms or -candidate_budget" << std::endl;
+        return false;
+    }
+    if ( fNumShards && ( fRanges.size() > 1 ) && std::get< 0 >( fNumbers ) )
+    {
+        std::cerr << "-shard can not be combined with more than one range" << std::endl;
+        return false;
+    }
+    if ( fNumShards && !fMergeFiles.empty() )
+    {
+        std::cerr << "-shard can not be combined with -merge" << std::endl;
+        return false;
+    }
     return true;
 }
 
 void CNarcissisticNumCalculator::launch( const TReportFunctionType & reportFunction, bool callInLoop )
 {
-    for ( unsigned int ii = 0; ii < fNumThreads; ++ii )
     {
-        fHandles.push_back( std::make_pair( std::async( std::launch::async, &CNarcissisticNumCalculator::analyzeNextPartition, this, ii ), std::make_tuple( 0, 0, 0 ) ) );
-        if ( callInLoop && reportFunction )
-        {
-            if ( !reportFunction( 0, fNumThreads, ii ) )
-                break;
-        }
+        std::unique_lock< std::mutex > lock( fMutex );
+        fSlotInUse.assign( fNumThreads, false );
+        fThreadProgress.assign( fNumThreads, std::make_tuple( 0, 0, 0 ) );
+        fLaunched = true;
+    }
+    // the job is added to the pool by partition(), once it is known to be worth the pool
+    if ( callInLoop && reportFunction )
+    {
+        if ( !reportFunction( 0, fNumThreads, 0 ) )
+            return;
     }
     if ( reportFunction )
     {
@@ -245,32 +609,117 @@ void CNarcissisticNumCalculator::launch( const TReportFunctionType & reportFunct
     }
 }
 
+void CNarcissisticNumCalculator::setNumThreads( int value )
+{
+    if ( value < 1 )
+        return;
+    fNumThreads = value;
+    if ( fLaunched )
+        CNarcissisticThreadPool::instance().setMaxConcurrency( this, value );
+}
+
+void CNarcissisticNumCalculator::setPriority( int value )
+{
+    fPriority = value;
+    if ( fLaunched )
+        CNarcissisticThreadPool::instance().setPriority( this, value );
+}
+
+void CNarcissisticNumCalculator::setWeight( double value )
+{
+    fWeight = value;
+    if ( fLaunched )
+        CNarcissisticThreadPool::instance().setWeight( this, value );
+}
+
 std::chrono::system_clock::duration CNarcissisticNumCalculator::run()
 {
-    return run( std::function< int64_t( int64_t, int64_t ) >() );
+    return run( std::function< uint64_t( uint64_t, uint64_t ) >() );
 }
 
 void CNarcissisticNumCalculator::init()
 {
+    if ( fLaunched )
+    {
+        CNarcissisticThreadPool::instance().removeJob( this );
+        fLaunched = false;
+    }
     fNarcissisticNumbers.clear();
-    fHandles.clear();
+    fRanInline = false;
+    fSlotInUse.clear();
+    fThreadProgress.clear();
+    fNumActive = 0;
     fFinishedPartition = false;
+    fIncomplete = false;
+    fIndexUpdated = false;
+    fPartitions.clear();
+    fRequeued.clear();
+    fPaused = false;
+    fPausedDuration = std::chrono::system_clock::duration( 0 );
+    fRangeCursor = fRangeEnd = 0;
+    fPendingRanges.clear();
+    fSearchedRanges.clear();
+    fRangeProgress.clear();
+    fNumCached = 0;
+    fCandidatesChecked = 0;
+    fNumConsumed = 0;
+    fNextPartitionIndex = 0;
+    fFrontier = 0;
+    fCompletedAboveFrontier.clear();
+    fCovered = std::make_pair( 0, 0 );
+    fAnswered = false;
+    fBudgetExpired = false;
+    fQueryFinalized = false;
+    fStats.clear();
+    fOrbitStepCounts.clear();
+    fOrbitCycleCounts.clear();
+    fShardRange = std::make_pair( 0, 0 );
+    fShardValues.clear();
+    fShardFailed = false;
+    fMetrics->reset();
+    fMetrics->fBase = fBase;
+    fMetrics->fNumThreads = fNumThreads;
+    fMetrics->fRunning = true;
+    fMetricsPublished = std::chrono::steady_clock::time_point();
+    if ( !fTraceFile.empty() )
+        CNarcissisticTrace::instance().start();
+    fThrottle.start();
+    fEnergy.start();
+    fEnergySampled = std::chrono::steady_clock::now();
     fRunTime.first = std::chrono::system_clock::now();
 }
 
 std::chrono::system_clock::duration CNarcissisticNumCalculator::run( const std::function< uint64_t( uint64_t, uint64_t ) >& pwrFunction )
 {
     init();
+    if ( !fMergeFiles.empty() )
+        return mergeShards();
     report();
     if ( pwrFunction )
         fPowerFunction = pwrFunction;
 
+    if ( fEstimateOnly )
+    {
+        std::cout << "=============================================\n";
+        std::cout << estimate().toString();
+        std::cout << "=============================================\n";
+        return std::chrono::system_clock::duration( 0 );
+    }
+
+    if ( fMetricsPort && !CNarcissisticMetricsServer::instance().isListening() )
+    {
+        std::string errorMsg;
+        if ( CNarcissisticMetricsServer::instance().listen( fMetricsPort, errorMsg ) )
+            std::cout << "Metrics: http://127.0.0.1:" << fMetricsPort << "/metrics\n";
+        else
+            std::cerr << "Could not serve metrics: " << errorMsg << std::endl;
+    }
+
     TReportFunctionType launchReport = 
         [this]( int /*min*/, int /*max*/, int /*curr*/ )
     {
         std::cout << "=============================================\n";
-        std::unique_lock< std::mutex > lock( fMutex );
-        std::cout << "Number of Threads Created: " << fHandles.size() << "\n";
+        std::cout << "Number of Threads: " << fNumThreads << " (Pool Workers: " << CNarcissisticThreadPool::instance().numWorkers() << ")\n";
         return true;
     };
     launch( launchReport, false );
@@ -279,8 +728,7 @@ std::chrono::system_clock::duration CNarcissisticNumCalculator::run( const std::
     TReportFunctionType partitionReport =
         [ this ]( int /*min*/, int /*max*/, int /*curr*/ )
     {
-        std::unique_lock< std::mutex > lock( fMutex );
-        std::cout << "Number of Ranges Created: " << fPartitions.size() << "\n";
+        std::cout << "Number of Ranges Created: " << numPartitions() << "\n";
         std::cout << "=============================================\n";
         return true;
     };
@@ -290,11 +738,80 @@ std::chrono::system_clock::duration CNarcissisticNumCalculator::run( const std::
     reportNumPartitionsRemaining( prev, true );
     while ( !isFinished( &prev ) )
     {
+        handleSignals();
+        std::this_thread::sleep_for( std::chrono::milliseconds( 10 ) );
     }
     reportNumPartitionsRemaining( prev, true );
 
     fRunTime.second = std::chrono::system_clock::now();
     reportFindings();
+    if ( fNumShards )
+        writeShardFile();
+    return fRunTime.second - fRunTime.first;
+}
+
+std::string CNarcissisticNumCalculator::shardFile() const
+{
+    return fShardFile.empty() ? CNarcissisticShard::defaultFileName( fShard, fNumShards ) : fShardFile;
+}
+
+void CNarcissisticNumCalculator::writeShardFile()
+{
+    // a partial shard would leave a gap the merge can not see
+    if ( fStopped || fIncomplete )
+    {
+        std::cerr << "Shard " << fShard << " of " << fNumShards << " did not complete, no shard file written" << std::endl;
+        fShardFailed = true;
+        return;
+    }
+
+    CNarcissisticShard::SResult result;
+    result.fShard = fShard;
+    result.fNumShards = fNumShards;
+    result.fBase = fBase;
+    result.fByRange = std::get< 0 >( fNumbers );
+    result.fRange = shardedRange(); // what the shards were cut from
+    result.fListSize = fShardListSize;
+    result.fListHash = fShardListHash;
+    result.fCovered = fShardRange;
+    result.fChecked.assign( fShardValues.begin(), fShardValues.end() );
+    fNarcissisticNumbers.sort();
+    result.fFound.assign( fNarcissisticNumbers.begin(), fNarcissisticNumbers.end() );
+    result.fRunNanos = std::chrono::duration_cast< std::chrono::nanoseconds >( fRunTime.second - fRunTime.first ).count();
+
+    std::string errorMsg;
+    if ( result.write( shardFile(), errorMsg ) )
+        std::cout << "Shard File: " << shardFile() << "\n";
+    else
+    {
+        std::cerr << errorMsg << std::endl;
+        fShardFailed = true;
+    }
+}
+
+std::chrono::system_clock::duration CNarcissisticNumCalculator::mergeShards()
+{
+    CNarcissisticShard::SResult merged;
+    std::string errorMsg;
+    if ( !CNarcissisticShard::merge( fMergeFiles, merged, errorMsg ) )
+    {
+        std::cerr << "Merge failed: " << errorMsg << std::endl;
+        fShardFailed = true;
+        return std::chrono::system_clock::duration( 0 );
+    }
+
+    fBase = merged.fBase;
+    std::get< 0 >( fNumbers ) = merged.fByRange;
+    std::get< 1 >( fNumbers ) = merged.fRange;
+    std::get< 2 >( fNumbers ).assign( merged.fChecked.begin(), merged.fChecked.end() );
+    fNarcissisticNumbers.assign( merged.fFound.begin(), merged.fFound.end() );
+    // the shards ran side by side, so the job took as long as the slowest
+    fRunTime.second = fRunTime.first + std::chrono::duration_cast< std::chrono::system_clock::duration >( std::chrono::nanoseconds( merged.fRunNanos ) );
+
+    report();
+    std::cout << "=============================================\n";
+    std::cout << "Merged " << merged.fNumShards << " shards, coverage complete\n";
+    reportFindings();
     return fRunTime.second - fRunTime.first;
 }
 
@@ -307,6 +824,10 @@ void CNarcissisticNumCalculator::loadSettings()
     std::get< 0 >( fNumbers ) = CNarcissisticNumCalculatorDefaults::byRange();
     std::get< 1 >( fNumbers ) = CNarcissisticNumCalculatorDefaults::range();
     std::get< 2 >( fNumbers ) = CNarcissisticNumCalculatorDefaults::numbersList();
+    // the list of ranges is the dialogs, which sets it on the calculator for each run
+    fUseIndex = CNarcissisticNumCalculatorDefaults::useIndex();
+    fUseKnownTable = CNarcissisticNumCalculatorDefaults::useKnownTable();
+    fEngineName = CNarcissisticNumCalculatorDefaults::engine();
 }
 
 void CNarcissisticNumCalculator::saveSettings() const
@@ -319,6 +840,9 @@ void CNarcissisticNumCalculator::saveSettings() const
     CNarcissisticNumCalculatorDefaults::setByRange( std::get< 0 >( fNumbers ) );
     CNarcissisticNumCalculatorDefaults::setRange( std::get< 1 >( fNumbers ) );
     CNarcissisticNumCalculatorDefaults::setNumbersList( std::get< 2 >( fNumbers ) );
+    CNarcissisticNumCalculatorDefaults::setUseIndex( fUseIndex );
+    CNarcissisticNumCalculatorDefaults::setUseKnownTable( fUseKnownTable );
+    CNarcissisticNumCalculatorDefaults::setEngine( fEngineName );
 }
 
 int CNarcissisticNumCalculator::getInt( int& ii, int argc, char** argv, const char* switchName, bool& aOK )
@@ -349,37 +873,104 @@ int CNarcissisticNumCalculator::getInt( int& ii, int argc, char** argv, const ch
     return retVal;
 }
 
-void CNarcissisticNumCalculator::dumpNumbers( const std::list< uint64_t >& numbers ) const
+double CNarcissisticNumCalculator::getDouble( int& ii, int argc, char** argv, const char* switchName, bool& aOK )
 {
-    bool first = true;
-    size_t ii = 0;
-    std::string str;
-    for ( auto&& currVal : numbers )
+    aOK = false;
+    if ( ++ii == argc )
     {
-        if ( ii && ( ii % 5 == 0 ) )
-        {
-            std::cout << "\n";
-            first = true;
-        }
-        if ( !first )
-            std::cout << ", ";
-        else
-            std::cout << "    ";
-        first = false;
-        
-        std::cout << NUtils::toString( currVal, fBase );
-        if ( fBase != 10 )
-            std::cout << "(=" << currVal << ")";
-        ii++;
+        std::cerr << switchName << " requires a value\n";
+        return 0;
     }
-    std::cout << "\n";
+    const char* str = argv[ ii ];
+    double retVal = 0;
+    try
+    {
+        retVal = std::stod( str );
+        aOK = true;
+    }
+    catch ( std::invalid_argument const& e )
+    {
+        std::cerr << switchName << " value '" << str << "' is invalid. \n" << e.what() << "\n";
+    }
+    catch ( std::out_of_range const& e )
+    {
+        std::cerr << switchName << " value '" << str << "' is out of range. \n" << e.what() << "\n";
+    }
+    return retVal;
 }
 
-void CNarcissisticNumCalculator::report()
+uint64_t CNarcissisticNumCalculator::getUInt64( int& ii, int argc, char** argv, const char* switchName, bool& aOK )
 {
-    if ( std::get< 0 >( fNumbers ) )
+    aOK = false;
+    if ( ++ii == argc )
     {
-        std::cout << "Finding Narcissistic in the range: [" << std::get< 1 >( fNumbers ).first << ":" << std::get< 1 >( fNumbers ).second << "]." << std::endl;
+        std::cerr << switchName << " requires a value\n";
+        return 0;
+    }
+    const char* str = argv[ ii ];
+    uint64_t retVal = 0;
+    try
+    {
+        retVal = std::stoull( str );
+        aOK = true;
+    }
+    catch ( std::invalid_argument const& e )
+    {
+        std::cerr << switchName << " value '" << str << "' is invalid. \n" << e.what() << "\n";
+    }
+    catch ( std::out_of_range const& e )
+    {
+        std::cerr << switchName << " value '" << str << "' is out of range. \n" << e.what() << "\n";
+    }
+    return retVal;
+}
+
+std::string CNarcissisticNumCalculator::getString( int& ii, int argc, char** argv, const char* switchName, bool& aOK )
+{
+    aOK = ( ++ii < argc );
+    if ( !aOK )
+    {
+        std::cerr << switchName << " requires a value\n";
+        return std::string();
+    }
+    return argv[ ii ];
+}
+
+void CNarcissisticNumCalculator::dumpNumbers( const std::list< uint64_t >& numbers ) const
+{
+    bool first = true;
+    size_t ii = 0;
+    std::string str;
+    for ( auto&& currVal : numbers )
+    {
+        if ( ii && ( ii % 5 == 0 ) )
+        {
+            std::cout << "\n";
+            first = true;
+        }
+        if ( !first )
+            std::cout << ", ";
+        else
+            std::cout << "    ";
+        first = false;
+        
+        std::cout << NUtils::toString( currVal, fBase );
+        if ( fBase != 10 )
+            std::cout << "(=" << currVal << ")";
+        ii++;
+    }
+    std::cout << "\n";
+}
+
+void CNarcissisticNumCalculator::report()
+{
+    if ( std::get< 0 >( fNumbers ) && !fRanges.empty() )
+    {
+        std::cout << "Finding Narcissistic in " << fRanges.size() << " ranges: " << rangesString( fRanges ) << std::endl;
+    }
+    else if ( std::get< 0 >( fNumbers ) )
+    {
+        std::cout << "Finding Narcissistic in the range: [" << std::get< 1 >( fNumbers ).first << ":" << std::get< 1 >( fNumbers ).second << "]." << std::endl;
     }
     else
     {
@@ -388,86 +979,942 @@ void CNarcissisticNumCalculator::report()
     }
     std::cout << "Maximum Numbers per thread: " << fNumPerThread << "\n";
     std::cout << "Base : " << fBase << "\n";
+    std::cout << "Engine : " << fEngineName << "\n";
     std::cout << "HW Concurrency : " << std::thread::hardware_concurrency() << "\n";
 }
 
-void CNarcissisticNumCalculator::reportFindings()
+void CNarcissisticNumCalculator::reportFindings()
+{
+    std::cout << "=============================================\n";
+    if ( fOrbits )
+        reportOrbits();
+    else
+    {
+        std::cout << "There are " << fNarcissisticNumbers.size() << " Narcissistic numbers";
+        if ( std::get< 0 >( fNumbers ) && fNumShards )
+            std::cout << " in shard " << fShard << " of " << fNumShards << ", the range [" << fShardRange.first << ":" << fShardRange.second << ")." << std::endl;
+        else if ( std::get< 0 >( fNumbers ) && !fRanges.empty() )
+            std::cout << " in " << fRanges.size() << " ranges." << std::endl;
+        else if ( std::get< 0 >( fNumbers ) )
+            std::cout << " in the range [" << std::get< 1 >( fNumbers ).first << ":" << std::get< 1 >( fNumbers ).second << "]." << std::endl;
+        else if ( fNumShards )
+            std::cout << " in shard " << fShard << " of " << fNumShards << ", " << fShardValues.size() << " of the " << fShardListSize << " requested values." << std::endl;
+        else
+            std::cout << " in the requested list." << std::endl;
+        fNarcissisticNumbers.sort();
+        dumpNumbers( fNarcissisticNumbers );
+        if ( std::get< 0 >( fNumbers ) && !fRanges.empty() )
+        {
+            // sorted, so each range is a contiguous run of the results
+            auto curr = fNarcissisticNumbers.begin();
+            for ( auto&& ii : fRanges )
+            {
+                curr = std::lower_bound( curr, fNarcissisticNumbers.end(), ii.first );
+                auto end = std::lower_bound( curr, fNarcissisticNumbers.end(), ii.second );
+                std::cout << "    [" << ii.first << ":" << ii.second << "): " << std::distance( curr, end ) << " found\n";
+                curr = end;
+            }
+        }
+    }
+    std::cout << "=============================================\n";
+    if ( isQuery() )
+    {
+        auto covered = coveredInterval();
+        std::cout << "Covered: [" << covered.first << ":" << covered.second << ")";
+        if ( queryAnswered() )
+            std::cout << " - answer proven";
+        if ( budgetExpired() )
+            std::cout << " - budget expired";
+        std::cout << "\n";
+    }
+    if ( fMergeFiles.empty() ) // the shards may each have run a different engine
+    {
+        std::cout << "Engine: " << engineName();
+        if ( fEngine && fEngine->memoryFootprint() )
+            std::cout << " - Tables: " << QLocale().toString( static_cast< qulonglong >( fEngine->memoryFootprint() ) ).toStdString() << " bytes";
+        std::cout << "\n";
+        reportEngineSpeedup();
+    }
+    if ( fRanInline )
+        std::cout << "Inline: below the inline threshold, run on the calling thread without the pool\n";
+    if ( fIndex && std::get< 0 >( fNumbers ) && !isQuery() && !tableCovers() )
+    {
+        uint64_t numSearched = 0;
+        for ( auto&& ii : fSearchedRanges )
+            numSearched += ii.second - ii.first;
+        uint64_t numCandidates = 0;
+        for ( auto&& ii : searchRanges() )
+            numCandidates += ii.second - ii.first;
+        if ( fNumShards )
+            numCandidates = fShardRange.second - fShardRange.first;
+        std::cout << "Index: " << fNumCached << " values reused - " << QLocale().toString( static_cast< qulonglong >( numSearched ) ).toStdString() << " of "
+            << QLocale().toString( static_cast< qulonglong >( numCandidates ) ).toStdString() << " candidates searched\n";
+    }
+    if ( fThrottle.enabled() )
+        std::cout << fThrottle.report();
+    if ( fMergeFiles.empty() ) // the shards ran elsewhere
+        std::cout << fEnergy.report( fCandidatesChecked );
+    if ( !fTraceFile.empty() )
+    {
+        CNarcissisticTrace::instance().stop();
+        std::string errorMsg;
+        if ( CNarcissisticTrace::instance().write( fTraceFile, errorMsg ) )
+            std::cout << "Trace: " << fTraceFile << "\n";
+        else
+            std::cerr << errorMsg << "\n";
+    }
+    std::cout << "Runtime: " << NUtils::getTimeString( fRunTime, true, true ) << std::endl;
+    std::cout << "=============================================\n";
+}
+
+namespace
+{
+    volatile uint64_t sEstimateSink{ 0 }; // keeps the sampled orbit sums from being optimized away
+
+    // the system clock duration overflows after ~292 years, which is well within what a full range can take
+    std::string estimateTimeString( double seconds )
+    {
+        const double kSecondsPerYear = 365.25 * 24 * 3600;
+        if ( seconds < 100 * kSecondsPerYear )
+            return NUtils::getTimeString( std::chrono::duration_cast< std::chrono::system_clock::duration >( std::chrono::duration< double >( seconds ) ), false, true );
+        return QLocale().toString( seconds / kSecondsPerYear, 'g', 3 ).toStdString() + " years";
+    }
+}
+
+std::string SNarcissisticEstimate::toString() const
+{
+    std::ostringstream oss;
+    if ( fFromTable )
+    {
+        oss << "Estimate: answered by the known table, nothing is searched\n";
+        return oss.str();
+    }
+    if ( fUnsupported )
+    {
+        oss << "Estimate: the orbit table for this base and power needs more than " << CNarcissisticOrbits::kMaxDomain << " values, the run is refused\n";
+        return oss.str();
+    }
+    oss << "Estimate: " << QLocale().toString( static_cast< qulonglong >( fCandidates ) ).toStdString() << " candidates\n";
+    for ( auto&& ii : fSecondsPerCandidate )
+        oss << "    " << ii.first << " digits: " << QLocale().toString( ii.second * 1e9, 'f', 2 ).toStdString() << " ns/candidate\n";
+    oss << "CPU Time: " << estimateTimeString( fCPUSeconds ) << "\n";
+    oss << "Wall Time: " << estimateTimeString( fWallSeconds ) << " (" << QLocale().toString( fConcurrency, 'g', 3 ).toStdString() << " cores)\n";
+    oss << "Memory: " << QLocale().toString( static_cast< qulonglong >( fMemoryBytes ) ).toStdString() << " bytes\n";
+    return oss.str();
+}
+
+SNarcissisticEstimate CNarcissisticNumCalculator::estimate()
+{
+    const uint64_t kNumSlices = 5; // spread across each length, the block engine skips some runs
+    const uint64_t kSliceSize = 2000;
+
+    SNarcissisticEstimate retVal;
+    createEngine();
+    uint32_t numThreads = fNumThreads;
+    retVal.fConcurrency = std::min( numThreads ? numThreads : std::thread::hardware_concurrency(), std::max( 1U, std::thread::hardware_concurrency() ) );
+    if ( fThrottle.enabled() )
+        retVal.fConcurrency = std::min( retVal.fConcurrency, fThrottle.currentRate() );
+    retVal.fConcurrency = std::max( retVal.fConcurrency, 1e-3 );
+
+    if ( !fOrbitPower && tableCovers() )
+    {
+        retVal.fFromTable = true;
+        return retVal;
+    }
+    if ( fOrbitPower && !CNarcissisticOrbits::supported( fBase, fOrbitPower ) )
+    {
+        retVal.fUnsupported = true;
+        return retVal;
+    }
+    if ( fOrbitPower )
+        retVal.fMemoryBytes += CNarcissisticOrbits::domainSize( fBase, fOrbitPower ) * sizeof( uint32_t );
+
+    // exactly what partition() would schedule
+    CNarcissisticStats::TLengthCounts counts{};
+    std::list< std::pair< uint64_t, uint64_t > > ranges;
+    if ( std::get< 0 >( fNumbers ) )
+    {
+        auto jobRanges = searchRanges();
+        if ( fNumShards )
+        {
+            auto range = shardedRange();
+            auto shard = CNarcissisticShard::shardRange( range.first, range.second, fBase, fShard, fNumShards );
+            for ( auto&& ii : jobRanges )
+            {
+                auto first = std::max( ii.first, shard.first );
+                ii = std::make_pair( first, std::max( first, std::min( ii.second, shard.second ) ) );
+            }
+        }
+        std::unique_ptr< CNarcissisticIndex > index( ( fUseIndex && !fOrbitPower && !isQuery() ) ? new CNarcissisticIndex( fBase ) : nullptr );
+        for ( auto&& ii : jobRanges )
+        {
+            if ( index )
+                ranges.splice( ranges.end(), index->gaps( ii.first, ii.second ) );
+            else if ( ii.second > ii.first )
+                ranges.push_back( ii );
+        }
+        for ( auto&& ii : ranges )
+        {
+            auto curr = CNarcissisticStats::countRange( ii.first, ii.second, fBase );
+            for ( size_t jj = 0; jj < counts.size(); ++jj )
+                counts[ jj ] += curr[ jj ];
+        }
+    }
+    else if ( fNumShards )
+        counts = CNarcissisticStats::countValues( CNarcissisticShard::shardValues( std::get< 2 >( fNumbers ), fBase, fShard, fNumShards ), fBase );
+    else
+        counts = CNarcissisticStats::countValues( std::get< 2 >( fNumbers ), fBase );
+
+    // orbit mode costs one digit power sum per value once the memo is warm
+    std::vector< uint64_t > digitPowers;
+    for ( int digit = 0; fOrbitPower && ( digit < fBase ); ++digit )
+        digitPowers.push_back( CNarcissisticEngine::powerSat( digit, fOrbitPower ) );
+
+    for ( int k = 1; k < static_cast< int >( counts.size() ); ++k )
+    {
+        if ( !counts[ k ] )
+            continue;
+        retVal.fCandidates += counts[ k ];
+
+        // the slices come from the largest searched part of the length
+        auto lengthMin = ( k == 1 ) ? 0 : CNarcissisticEngine::powerSat( fBase, k - 1 );
+        auto lengthMax = CNarcissisticEngine::powerSat( fBase, k );
+        auto segment = std::make_pair( lengthMin, lengthMax );
+        if ( !ranges.empty() )
+        {
+            segment = std::make_pair( 0, 0 );
+            for ( auto&& ii : ranges )
+            {
+                auto curr = std::make_pair( std::max( ii.first, lengthMin ), std::min( ii.second, lengthMax ) );
+                if ( ( curr.second > curr.first ) && ( ( curr.second - curr.first ) > ( segment.second - segment.first ) ) )
+                    segment = curr;
+            }
+        }
+        auto segmentSize = segment.second - segment.first;
+        auto sliceSize = std::min( kSliceSize, segmentSize );
+        auto numSlices = ( segmentSize > sliceSize ) ? kNumSlices : 1;
+
+        bool aOK = true;
+        fEngine->isNarcissistic( segment.first, aOK ); // builds the tables for the length
+        std::chrono::steady_clock::duration elapsed( 0 );
+        uint64_t numSampled = 0;
+        for ( uint64_t slice = 0; slice < numSlices; ++slice )
+        {
+            auto sliceMin = segment.first + ( ( numSlices > 1 ) ? ( ( segmentSize - sliceSize ) / ( numSlices - 1 ) * slice ) : 0 );
+            auto start = std::chrono::steady_clock::now();
+            if ( fOrbitPower )
+            {
+                uint64_t sum = 0;
+                for ( auto ii = sliceMin; ii < sliceMin + sliceSize; ++ii )
+                {
+                    for ( auto curr = ii; curr; curr /= fBase )
+                        sum += digitPowers[ curr % fBase ];
+                }
+                sEstimateSink = sEstimateSink + sum;
+            }
+            else
+                fEngine->findInRange( sliceMin, sliceMin + sliceSize, []( uint64_t ) {}, {} );
+            elapsed += std::chrono::steady_clock::now() - start;
+            numSampled += sliceSize;
+        }
+
+        auto secondsPerCandidate = std::chrono::duration< double >( elapsed ).count() / numSampled;
+        retVal.fSecondsPerCandidate[ k ] = secondsPerCandidate;
+        retVal.fCPUSeconds += secondsPerCandidate * counts[ k ];
+    }
+
+    retVal.fWallSeconds = retVal.fCPUSeconds / retVal.fConcurrency;
+    retVal.fMemoryBytes += fEngine->memoryFootprint();
+    return retVal;
+}
+
+void CNarcissisticNumCalculator::reportOrbits() const
+{
+    std::cout << "Orbits of F(n) = sum of the digits^" << fOrbitPower;
+    if ( std::get< 0 >( fNumbers ) )
+        std::cout << " in the range [" << std::get< 1 >( fNumbers ).first << ":" << std::get< 1 >( fNumbers ).second << "]." << std::endl;
+    else
+        std::cout << " of the requested list." << std::endl;
+
+    // the cycles are indexed in the order the workers found them, they are reported by smallest member
+    auto cycles = orbitCycles();
+    std::map< uint64_t, std::pair< std::vector< uint64_t >, uint64_t > > reached;
+    for ( auto&& ii : orbitCycleCounts() )
+        reached[ cycles[ ii.first ].front() ] = std::make_pair( cycles[ ii.first ], ii.second );
+
+    std::cout << "There are " << reached.size() << " cycles reached:\n";
+    for ( auto&& ii : reached )
+    {
+        auto&& members = ii.second.first;
+        std::cout << "    " << ( ( members.size() == 1 ) ? "Fixed point" : ( "Length " + std::to_string( members.size() ) ) ) << ": ";
+        for ( auto&& jj : members )
+            std::cout << jj << " -> ";
+        std::cout << members.front() << " - reached by " << QLocale().toString( static_cast< qulonglong >( ii.second.second ) ).toStdString() << " values\n";
+    }
+    std::cout << "Steps to reach a cycle:\n";
+    for ( auto&& ii : orbitStepCounts() )
+        std::cout << "    " << ii.first << ": " << QLocale().toString( static_cast< qulonglong >( ii.second ) ).toStdString() << "\n";
+}
+
+std::vector< std::vector< uint64_t > > CNarcissisticNumCalculator::orbitCycles() const
+{
+    return fOrbits ? fOrbits->cycles() : std::vector< std::vector< uint64_t > >();
+}
+
+std::map< uint32_t, uint64_t > CNarcissisticNumCalculator::orbitCycleCounts() const
+{
+    std::unique_lock< std::mutex > lock( fMutex );
+    return fOrbitCycleCounts;
+}
+
+std::map< uint32_t, uint64_t > CNarcissisticNumCalculator::orbitStepCounts() const
+{
+    std::unique_lock< std::mutex > lock( fMutex );
+    return fOrbitStepCounts;
+}
+
+bool CNarcissisticNumCalculator::tableCovers() const
+{
+    return fUseKnownTable && NNarcissisticTable::hasTable( fBase );
+}
+
+std::pair< bool, bool > CNarcissisticNumCalculator::checkAndAddValue( uint64_t value )
+{
+    bool aOK = true;
+    bool isNarcissistic = tableCovers() ? NNarcissisticTable::isNarcissistic( value, fBase ) : fEngine->isNarcissistic( value, aOK );
+    if ( !aOK )
+        return std::make_pair( false, false );
+    if ( isNarcissistic )
+    {
+        addNarcissisticValue( value );
+    }
+    return std::make_pair( isNarcissistic, true );
+}
+
+bool CNarcissisticNumCalculator::hasWork() const
+{
+    std::unique_lock< std::mutex > lock( fMutex );
+    if ( fResultWindow && ( ( fNarcissisticNumbers.size() - fNumConsumed ) >= fResultWindow ) )
+        return false;
+    return !fStopped && !fPaused && ( !fRequeued.empty() || !fPartitions.empty() || ( fRangeCursor < fRangeEnd ) ) && fThrottle.mayRun();
+}
+
+bool CNarcissisticNumCalculator::runNextPartition()
+{
+    TPartitionSet currRange;
+    size_t threadNum = 0;
+    uint64_t index = 0;
+    {
+        auto measure = CNarcissisticMetrics::instance().enabled();
+        CNarcissisticTrace::CLock< std::mutex > lock( fMutex, "take partition", measure ? &fMetrics->fLockWaitNanos : nullptr, measure ? &fMetrics->fLockAcquisitions : nullptr );
+        if ( fStopped || fPaused || checkTimeBudget() || !takeNextPartition( currRange, index ) )
+            return false;
+
+        threadNum = std::find( fSlotInUse.begin(), fSlotInUse.end(), false ) - fSlotInUse.begin();
+        if ( threadNum == fSlotInUse.size() )
+        {
+            fSlotInUse.push_back( false );
+            fThreadProgress.push_back( std::make_tuple( 0, 0, 0 ) );
+        }
+        fSlotInUse[ threadNum ] = true;
+        fNumActive++;
+    }
+
+    auto endValue = partitionEnd( currRange );
+    auto numCandidates = partitionSize( currRange );
+    auto lengthCounts = partitionLengthCounts( currRange );
+    auto firstValue = std::get< 0 >( currRange ) ? std::get< 2 >( currRange ).first : ( std::get< 1 >( currRange ).empty() ? 0 : std::get< 1 >( currRange ).front() );
+    auto start = std::chrono::steady_clock::now();
+    bool complete = false;
+    {
+        CNarcissisticThrottle::CIdlePriorityScope priority( fThrottle.idlePriority() );
+        complete = findNarcissistic( threadNum, currRange );
+    }
+    auto finish = std::chrono::steady_clock::now();
+    auto busy = finish - start;
+    if ( CNarcissisticTrace::instance().enabled() )
+        CNarcissisticTrace::instance().record( CNarcissisticTrace::EKind::ePartition, "partition", start, finish, firstValue, complete ? endValue : partitionEnd( currRange ), complete ? numCandidates : ( numCandidates - partitionSize( currRange ) ) );
+    fThrottle.consumed( busy, complete ? numCandidates : ( numCandidates - partitionSize( currRange ) ) );
+    if ( !complete )
+    {
+        // only the checked part is measured, the remainder stays in the remaining counts
+        auto remainder = partitionLengthCounts( currRange );
+        for ( size_t ii = 0; ii < lengthCounts.size(); ++ii )
+            lengthCounts[ ii ] -= remainder[ ii ];
+    }
+
+    auto numChecked = complete ? numCandidates : ( numCandidates - partitionSize( currRange ) );
+    fMetrics->addThreadWork( threadNum, numChecked, static_cast< uint64_t >( std::chrono::duration_cast< std::chrono::nanoseconds >( busy ).count() ) );
+
+    auto measure = CNarcissisticMetrics::instance().enabled();
+    CNarcissisticTrace::CLock< std::mutex > lock( fMutex, "commit partition", measure ? &fMetrics->fLockWaitNanos : nullptr, measure ? &fMetrics->fLockAcquisitions : nullptr );
+    fStats.recordPartition( busy, lengthCounts );
+    if ( !fRangeProgress.empty() && std::get< 0 >( currRange ) )
+        rangeChecked( firstValue, numChecked );
+    fSlotInUse[ threadNum ] = false;
+    fNumActive--;
+    if ( complete )
+    {
+        if ( numCandidates )
+            partitionCompleted( index, endValue, numCandidates );
+    }
+    else if ( fPaused && !fStopped )
+    {
+        // the remainder keeps its index, so the covered interval is unaffected by the pause
+        fCandidatesChecked += numCandidates - partitionSize( currRange );
+        fRequeued.emplace_back( index, std::move( currRange ) );
+        fRequeued.sort( []( const std::pair< uint64_t, TPartitionSet >& lhs, const std::pair< uint64_t, TPartitionSet >& rhs ) { return lhs.first < rhs.first; } );
+    }
+    if ( complete )
+        fMetrics->fPartitionsCompleted.fetch_add( 1, std::memory_order_relaxed );
+    publishMetrics( fNumActive == 0 );
+    if ( fNumActive == 0 )
+        fIdle.notify_all();
+    if ( fProgressObserver )
+        fProgressObserver();
+    return true;
+}
+
+// a job below the inline threshold is not on the pool, so nothing else takes its partitions. They are all
+// taken under one lock, searched without it, and committed under one more, instead of locking per partition
+// and per kCheckInterval candidates. Orbits, queries and traced runs keep the per partition bookkeeping
+bool CNarcissisticNumCalculator::runInlineRanges()
+{
+    if ( fOrbits || isQuery() || !std::get< 0 >( fNumbers ) || CNarcissisticTrace::instance().enabled() )
+        return false;
+
+    struct SInlinePartition
+    {
+        uint64_t fIndex{ 0 };
+        TPartitionSet fPartition;
+        uint64_t fEndValue{ 0 };
+        uint64_t fNumCandidates{ 0 };
+        CNarcissisticStats::TLengthCounts fLengthCounts{};
+        std::chrono::steady_clock::duration fBusy{ 0 };
+        bool fComplete{ false };
+    };
+    std::list< SInlinePartition > partitions;
+    {
+        std::unique_lock< std::mutex > lock( fMutex );
+        SInlinePartition curr;
+        // a partition per digit length, there is no other worker to balance against
+        while ( !fStopped && !fPaused && takeNextPartition( curr.fPartition, curr.fIndex, true ) )
+            partitions.push_back( std::move( curr ) );
+        fNumActive++;
+    }
+    for ( auto&& ii : partitions )
+    {
+        ii.fEndValue = partitionEnd( ii.fPartition );
+        ii.fNumCandidates = partitionSize( ii.fPartition );
+    }
+
+    std::list< uint64_t > found;
+    bool failed = false;
+    for ( auto&& ii : partitions )
+    {
+        if ( fStopped || fPaused || failed )
+            break;
+        auto&& range = std::get< 2 >( ii.fPartition );
+        ii.fLengthCounts = partitionLengthCounts( ii.fPartition );
+        auto start = std::chrono::steady_clock::now();
+        auto next = fEngine->findInRange( range.first, range.second, [ &found ]( uint64_t value ) { found.push_back( value ); }, [ this ]( uint64_t ) { return !fStopped && !fPaused; } );
+        ii.fBusy = std::chrono::steady_clock::now() - start;
+        range.first = next;
+        ii.fComplete = ( next == range.second );
+        failed = !ii.fComplete && !fStopped && !fPaused;
+        if ( !ii.fComplete )
+        {
+            auto remainder = partitionLengthCounts( ii.fPartition );
+            for ( size_t jj = 0; jj < ii.fLengthCounts.size(); ++jj )
+                ii.fLengthCounts[ jj ] -= remainder[ jj ];
+        }
+    }
+
+    std::unique_lock< std::mutex > lock( fMutex );
+    fNarcissisticNumbers.splice( fNarcissisticNumbers.end(), found );
+    for ( auto&& ii : partitions )
+    {
+        // the partitions after a pause or a stop were never started, nothing of them was checked
+        auto numChecked = ii.fNumCandidates - ( ii.fComplete ? 0 : partitionSize( ii.fPartition ) );
+        if ( numChecked )
+        {
+            fStats.recordPartition( ii.fBusy, ii.fLengthCounts );
+            fMetrics->addThreadWork( 0, numChecked, static_cast< uint64_t >( std::chrono::duration_cast< std::chrono::nanoseconds >( ii.fBusy ).count() ) );
+            if ( !fRangeProgress.empty() )
+                rangeChecked( std::get< 2 >( ii.fPartition ).first - numChecked, numChecked );
+        }
+        if ( ii.fComplete )
+        {
+            if ( ii.fNumCandidates )
+                partitionCompleted( ii.fIndex, ii.fEndValue, ii.fNumCandidates );
+            fMetrics->fPartitionsCompleted.fetch_add( 1, std::memory_order_relaxed );
+        }
+        else if ( fPaused && !fStopped )
+        {
+            // as in runNextPartition, the remainder (or the untouched partition) keeps its index
+            fCandidatesChecked += numChecked;
+            fRequeued.emplace_back( ii.fIndex, std::move( ii.fPartition ) );
+        }
+    }
+    if ( failed )
+        fIncomplete = true;
+    fRequeued.sort( []( const std::pair< uint64_t, TPartitionSet >& lhs, const std::pair< uint64_t, TPartitionSet >& rhs ) { return lhs.first < rhs.first; } );
+    fNumActive--;
+    publishMetrics( fNumActive == 0 );
+    if ( fNumActive == 0 )
+        fIdle.notify_all();
+    if ( fProgressObserver )
+        fProgressObserver();
+    return true;
+}
+
+bool CNarcissisticNumCalculator::takeNextPartition( TPartitionSet& partition, uint64_t& index, bool wholeLength )
+{
+    if ( !fRequeued.empty() )
+    {
+        index = fRequeued.front().first;
+        partition = std::move( fRequeued.front().second );
+        fRequeued.pop_front();
+        return true;
+    }
+    if ( !fPartitions.empty() )
+    {
+        partition = std::move( fPartitions.front() );
+        fPartitions.pop_front();
+        index = fNextPartitionIndex++;
+        return true;
+    }
+    if ( fRangeCursor >= fRangeEnd )
+        return false;
+
+    auto lclMax = rangePartitionEnd( fRangeCursor, fRangeEnd, wholeLength );
+    partition = std::make_tuple( true, std::list< uint64_t >(), std::make_pair( fRangeCursor, lclMax ) );
+    fRangeCursor = lclMax;
+    if ( ( fRangeCursor >= fRangeEnd ) && !fPendingRanges.empty() )
+    {
+        std::tie( fRangeCursor, fRangeEnd ) = fPendingRanges.front();
+        fPendingRanges.pop_front();
+    }
+    index = fNextPartitionIndex++;
+    return true;
+}
+
+// range partitions never straddle a digit length, and are sized so each costs about
+// fNumPerThread candidates of the longest length in the range (count * digits), or run to the end of the length
+uint64_t CNarcissisticNumCalculator::rangePartitionEnd( uint64_t curr, uint64_t end, bool wholeLength ) const
+{
+    auto numDigits = static_cast< uint64_t >( CNarcissisticEngine::computeNumDigits( curr, fBase ) );
+    auto lengthEnd = CNarcissisticEngine::powerSat( fBase, numDigits );
+    if ( lengthEnd == std::numeric_limits< uint64_t >::max() )
+        lengthEnd = end; // the last length runs to 2^64-1
+    end = std::min( end, lengthEnd );
+    if ( wholeLength )
+        return end;
+
+    auto partitionDigits = static_cast< uint64_t >( std::max( 1, fPartitionDigits ) );
+    auto size = std::numeric_limits< uint64_t >::max();
+    if ( fNumPerThread <= ( size / partitionDigits ) )
+        size = std::max< uint64_t >( 1, fNumPerThread * partitionDigits / numDigits );
+    return ( ( end - curr ) > size ) ? ( curr + size ) : end; // prevents overflow
+}
+
+uint64_t CNarcissisticNumCalculator::countRangePartitions( uint64_t min, uint64_t max ) const
+{
+    uint64_t retVal = 0;
+    while ( min < max )
+    {
+        // every partition of a length but the last is full sized
+        auto partitionEnd = rangePartitionEnd( min, max );
+        auto size = partitionEnd - min;
+        auto lengthEnd = CNarcissisticEngine::powerSat( fBase, CNarcissisticEngine::computeNumDigits( min, fBase ) );
+        lengthEnd = std::min( max, lengthEnd );
+        auto remaining = lengthEnd - min;
+        retVal += remaining / size + ( ( ( remaining % size ) != 0 ) ? 1 : 0 );
+        min = lengthEnd;
+    }
+    return retVal;
+}
+
+uint64_t CNarcissisticNumCalculator::partitionSize( const TPartitionSet& partition )
+{
+    if ( std::get< 0 >( partition ) )
+        return std::get< 2 >( partition ).second - std::get< 2 >( partition ).first;
+    return std::get< 1 >( partition ).size();
+}
+
+CNarcissisticStats::TLengthCounts CNarcissisticNumCalculator::partitionLengthCounts( const TPartitionSet& partition ) const
+{
+    if ( std::get< 0 >( partition ) )
+        return CNarcissisticStats::countRange( std::get< 2 >( partition ).first, std::get< 2 >( partition ).second, fBase );
+    return CNarcissisticStats::countValues( std::get< 1 >( partition ), fBase );
+}
+
+uint64_t CNarcissisticNumCalculator::partitionEnd( const TPartitionSet& partition )
+{
+    if ( std::get< 0 >( partition ) )
+        return std::get< 2 >( partition ).second;
+    return std::get< 1 >( partition ).empty() ? 0 : ( std::get< 1 >( partition ).back() + 1 );
+}
+
+void CNarcissisticNumCalculator::pause()
+{
+    std::unique_lock< std::mutex > lock( fMutex );
+    if ( fPaused )
+        return;
+    fPauseStart = std::chrono::system_clock::now();
+    fPaused = true;
+    fMetrics->fPaused = true;
+}
+
+void CNarcissisticNumCalculator::resume()
+{
+    {
+        std::unique_lock< std::mutex > lock( fMutex );
+        if ( !fPaused )
+            return;
+        fPausedDuration += std::chrono::system_clock::now() - fPauseStart;
+        fPaused = false;
+        fMetrics->fPaused = false;
+    }
+    CNarcissisticThreadPool::instance().notify();
+}
+
+void CNarcissisticNumCalculator::setStopped( bool stopped )
+{
+    fStopped = stopped;
+    if ( stopped )
+        CNarcissisticThreadPool::instance().notify();
+}
+
+bool CNarcissisticNumCalculator::waitUntilIdle( const std::chrono::milliseconds& timeout )
+{
+    std::unique_lock< std::mutex > lock( fMutex );
+    return fIdle.wait_for( lock, timeout, [ this ]() { return fNumActive == 0; } );
+}
+
+namespace
+{
+    // only lock free atomics may be touched by a signal handler, run() polls them
+    std::atomic< bool > sCancelRequested{ false };
+    std::atomic< bool > sPauseRequested{ false };
+    std::atomic< bool > sResumeRequested{ false };
+    std::atomic< int > sThreadsRequested{ 0 }; // threads to add (or retire when negative)
+
+    extern "C" void calculatorSignalHandler( int signal )
+    {
+        if ( signal == SIGINT )
+        {
+            sCancelRequested = true;
+            std::signal( SIGINT, SIG_DFL ); // a second interrupt kills the process
+        }
+#ifdef SIGTSTP
+        else if ( signal == SIGTSTP )
+        {
+            // caught, so the shell sees no stopped job, a second Ctrl-Z really stops the process
+            sPauseRequested = true;
+            std::signal( SIGTSTP, SIG_DFL );
+        }
+        else if ( signal == SIGCONT )
+            sResumeRequested = true;
+#endif
+#ifdef SIGUSR1
+        else if ( signal == SIGUSR1 )
+            sThreadsRequested++;
+        else if ( signal == SIGUSR2 )
+            sThreadsRequested--;
+#endif
+    }
+}
+
+void CNarcissisticNumCalculator::enableSignalHandling()
+{
+    std::signal( SIGINT, calculatorSignalHandler );
+#ifdef SIGTSTP
+    std::signal( SIGTSTP, calculatorSignalHandler );
+    std::signal( SIGCONT, calculatorSignalHandler );
+#endif
+#ifdef SIGUSR1
+    std::signal( SIGUSR1, calculatorSignalHandler );
+    std::signal( SIGUSR2, calculatorSignalHandler );
+#endif
+}
+
+void CNarcissisticNumCalculator::handleSignals()
+{
+    if ( sCancelRequested.exchange( false ) )
+    {
+        std::cout << "Cancelling...\n";
+        cancel();
+    }
+    if ( sPauseRequested.exchange( false ) )
+    {
+#ifdef SIGTSTP
+        std::cout << "Paused, run 'kill -CONT " << getpid() << "' to resume (Ctrl-Z again stops the process, fg then resumes it)\n";
+#endif
+        pause();
+    }
+    if ( sResumeRequested.exchange( false ) && isPaused() )
+    {
+        std::cout << "Resumed\n";
+        resume();
+#ifdef SIGTSTP
+        std::signal( SIGTSTP, calculatorSignalHandler );
+#endif
+    }
+    if ( auto delta = sThreadsRequested.exchange( 0 ) )
+    {
+        setNumThreads( std::max( 1, static_cast< int >( fNumThreads ) + delta ) );
+        std::cout << "Number of Threads: " << fNumThreads << "\n";
+    }
+}
+
+void CNarcissisticNumCalculator::partitionCompleted( uint64_t index, uint64_t endValue, uint64_t numCandidates )
+{
+    fCandidatesChecked += numCandidates;
+    fCompletedAboveFrontier[ index ] = endValue;
+    while ( !fCompletedAboveFrontier.empty() && ( ( *fCompletedAboveFrontier.begin() ).first == fFrontier ) )
+    {
+        fCovered.second = std::max( fCovered.second, ( *fCompletedAboveFrontier.begin() ).second );
+        fCompletedAboveFrontier.erase( fCompletedAboveFrontier.begin() );
+        fFrontier++;
+    }
+
+    if ( fFirstN && !fAnswered )
+    {
+        auto covered = fCovered.second;
+        auto numFound = std::count_if( fNarcissisticNumbers.begin(), fNarcissisticNumbers.end(), [ covered ]( uint64_t value ) { return value < covered; } );
+        if ( static_cast< uint64_t >( numFound ) >= fFirstN )
+        {
+            fAnswered = true;
+            fStopped = true;
+        }
+    }
+    if ( fCandidateBudget && ( fCandidatesChecked >= fCandidateBudget ) )
+    {
+        fBudgetExpired = true;
+        fStopped = true;
+    }
+    checkTimeBudget();
+}
+
+bool CNarcissisticNumCalculator::checkTimeBudget()
+{
+    if ( !fTimeBudget.count() || fBudgetExpired || fPaused )
+        return fBudgetExpired;
+    if ( ( std::chrono::system_clock::now() - fRunTime.first - fPausedDuration ) >= fTimeBudget )
+    {
+        fBudgetExpired = true;
+        fStopped = true;
+    }
+    return fBudgetExpired;
+}
+
+void CNarcissisticNumCalculator::finalizeQuery()
+{
+    std::unique_lock< std::mutex > lock( fMutex );
+    if ( !isQuery() || fQueryFinalized )
+        return;
+    fQueryFinalized = true;
+
+    // only the hits inside the covered interval are proven
+    auto covered = fCovered;
+    fNarcissisticNumbers.remove_if( [ covered ]( uint64_t value ) { return ( value < covered.first ) || ( value >= covered.second ); } );
+    fNarcissisticNumbers.sort();
+    if ( fFirstN && ( fNarcissisticNumbers.size() > fFirstN ) )
+        fNarcissisticNumbers.resize( fFirstN );
+}
+
+void CNarcissisticNumCalculator::setRanges( const std::list< std::pair< uint64_t, uint64_t > >& value )
 {
-    std::cout << "=============================================\n";
-    std::cout << "There are " << fNarcissisticNumbers.size() << " Narcissistic numbers";
-    if ( std::get< 0 >( fNumbers ) )
-        std::cout << " in the range [" << std::get< 1 >( fNumbers ).first << ":" << std::get< 1 >( fNumbers ).second << "]." << std::endl;
-    else
-        std::cout << " in the requested list." << std::endl;
-    fNarcissisticNumbers.sort();
-    dumpNumbers( fNarcissisticNumbers );
-    std::cout << "=============================================\n";
-    std::cout << "Runtime: " << NUtils::getTimeString( fRunTime, true, true ) << std::endl;
-    std::cout << "=============================================\n";
+    std::get< 0 >( fNumbers ) = true;
+    fRanges = normalizeRanges( value );
 }
 
-std::pair< bool, bool > CNarcissisticNumCalculator::checkAndAddValue( uint64_t value )
+std::list< std::pair< uint64_t, uint64_t > > CNarcissisticNumCalculator::searchRanges() const
 {
-    bool aOK = true;
-    bool isNarcissistic = NUtils::isNarcissistic( value, fBase, aOK );
-    if ( !aOK )
-        return std::make_pair( false, false );
-    if ( isNarcissistic )
+    if ( !fRanges.empty() )
+        return fRanges;
+    std::list< std::pair< uint64_t, uint64_t > > retVal;
+    if ( std::get< 1 >( fNumbers ).second > std::get< 1 >( fNumbers ).first )
+        retVal.push_back( std::get< 1 >( fNumbers ) );
+    return retVal;
+}
+
+std::pair< uint64_t, uint64_t > CNarcissisticNumCalculator::shardedRange() const
+{
+    // -shard allows a single range, the hull keeps the shards tiling if more are set through the API
+    return fRanges.empty() ? std::get< 1 >( fNumbers ) : std::make_pair( fRanges.front().first, fRanges.back().second );
+}
+
+std::list< std::pair< uint64_t, uint64_t > > CNarcissisticNumCalculator::normalizeRanges( std::list< std::pair< uint64_t, uint64_t > > ranges )
+{
+    ranges.remove_if( []( const std::pair< uint64_t, uint64_t >& ii ) { return ii.first >= ii.second; } );
+    ranges.sort();
+    for ( auto ii = ranges.begin(); ii != ranges.end(); )
     {
-        addNarcissisticValue( value );
+        auto next = std::next( ii );
+        if ( ( next != ranges.end() ) && ( ( *next ).first <= ( *ii ).second ) )
+        {
+            ( *ii ).second = std::max( ( *ii ).second, ( *next ).second );
+            ranges.erase( next );
+        }
+        else
+            ++ii;
     }
-    return std::make_pair( isNarcissistic, true );
+    return ranges;
 }
 
-void CNarcissisticNumCalculator::analyzeNextPartition( size_t threadNum )
+bool CNarcissisticNumCalculator::parseRanges( const std::string& text, std::list< std::pair< uint64_t, uint64_t > >& ranges, std::string& errorMsg )
 {
-    while ( true ) // infinite loop 
+    // strtoull accepts a sign and white space, so only digits are allowed on either side
+    auto isNumber = []( const std::string& str ) { return !str.empty() && ( str.length() <= 20 ) && std::all_of( str.begin(), str.end(), []( char ch ) { return std::isdigit( static_cast< unsigned char >( ch ) ) != 0; } ); };
+
+    ranges.clear();
+    std::istringstream lines( text );
+    std::string line;
+    for ( int lineNum = 1; std::getline( lines, line ); ++lineNum )
     {
-        TPartitionSet currRange;
+        line = line.substr( 0, line.find( '#' ) );
+        std::replace( line.begin(), line.end(), ',', ' ' );
+        std::istringstream iss( line );
+        std::string token;
+        while ( iss >> token )
         {
-            //std::cout << std::this_thread::get_id() << " - Trying next\n";
-            std::unique_lock< std::mutex > lock( fMutex );
-            //std::cout << "Locked: " << std::this_thread::get_id() << " - Analyze Next Range\n";
-
-            fConditionVariable.wait( lock, [ this ]() { return ( fFinishedPartition || !fPartitions.empty() ); } );
-            if ( fPartitions.empty() )
+            auto pos = token.find( ':' );
+            auto min = ( pos == std::string::npos ) ? std::string() : token.substr( 0, pos );
+            auto max = ( pos == std::string::npos ) ? std::string() : token.substr( pos + 1 );
+            errno = 0;
+            auto minValue = isNumber( min ) ? std::strtoull( min.c_str(), nullptr, 10 ) : 0;
+            auto maxValue = isNumber( max ) ? std::strtoull( max.c_str(), nullptr, 10 ) : 0;
+            if ( !isNumber( min ) || !isNumber( max ) || ( errno == ERANGE ) )
             {
-                //std::cout << std::this_thread::get_id() << " - Finished with all ranges\n";
-                //std::cout << "UnLocked - Analyze Next Range (finished)\n";
-                return;
+                errorMsg = "line " + std::to_string( lineNum ) + ": '" + token + "' is not a min:max range";
+                return false;
             }
-
-            currRange = std::move( fPartitions.front() );
-            fPartitions.pop_front();
-            //std::cout << "UnLocked: Analyze Next Range (still going)\n";
+            if ( minValue >= maxValue )
+            {
+                errorMsg = "line " + std::to_string( lineNum ) + ": '" + token + "' is an empty range, the max is excluded";
+                return false;
+            }
+            ranges.emplace_back( minValue, maxValue );
         }
-        findNarcissistic( threadNum, currRange );
-        if ( fStopped )
-            break;
     }
+    return true;
 }
 
-void CNarcissisticNumCalculator::findNarcissistic( size_t threadNum, const TPartitionSet& range )
+std::string CNarcissisticNumCalculator::rangesString( const std::list< std::pair< uint64_t, uint64_t > >& ranges )
 {
-    auto start = std::chrono::system_clock::now();
+    std::ostringstream oss;
+    for ( auto&& ii : ranges )
+        oss << ( ( &ii == &ranges.front() ) ? "" : " " ) << ii.first << ":" << ii.second;
+    return oss.str();
+}
 
-    if ( std::get< 0 >( range ) )
-        findNarcissisticRange( threadNum, std::get< 2 >( range ) );
+void CNarcissisticNumCalculator::setNextAfter( uint64_t value )
+{
+    std::get< 0 >( fNumbers ) = true;
+    auto max = std::numeric_limits< uint64_t >::max();
+    std::get< 1 >( fNumbers ) = std::make_pair( ( value < max ) ? ( value + 1 ) : max, max );
+    fRanges.clear();
+    fFirstN = 1;
+}
+
+bool CNarcissisticNumCalculator::queryAnswered() const
+{
+    std::unique_lock< std::mutex > lock( fMutex );
+    return fAnswered;
+}
+
+bool CNarcissisticNumCalculator::budgetExpired() const
+{
+    std::unique_lock< std::mutex > lock( fMutex );
+    return fBudgetExpired;
+}
+
+void CNarcissisticNumCalculator::setProgressObserver( const std::function< void() >& observer )
+{
+    std::unique_lock< std::mutex > lock( fMutex );
+    fProgressObserver = observer;
+}
+
+std::list< uint64_t > CNarcissisticNumCalculator::provenResults( uint64_t& from, bool finished ) const
+{
+    std::list< uint64_t > retVal;
+    std::unique_lock< std::mutex > lock( fMutex );
+    auto end = finished ? std::numeric_limits< uint64_t >::max() : fCovered.second;
+    for ( auto&& ii : fNarcissisticNumbers )
+    {
+        if ( ( ii >= from ) && ( finished || ( ii < end ) ) )
+            retVal.push_back( ii );
+    }
+    retVal.sort();
+    if ( finished )
+        from = retVal.empty() ? from : ( retVal.back() + 1 );
     else
-        findNarcissisticList( threadNum, std::get< 1 >( range ) );
+        from = std::max( from, end );
+    return retVal;
+}
+
+void CNarcissisticNumCalculator::resultsConsumed( size_t num )
+{
+    bool wasHeld = false;
+    {
+        std::unique_lock< std::mutex > lock( fMutex );
+        wasHeld = fResultWindow && ( ( fNarcissisticNumbers.size() - fNumConsumed ) >= fResultWindow );
+        fNumConsumed = std::min( fNumConsumed + num, fNarcissisticNumbers.size() );
+    }
+    if ( wasHeld )
+        CNarcissisticThreadPool::instance().notify();
+}
+
+std::pair< uint64_t, uint64_t > CNarcissisticNumCalculator::coveredInterval() const
+{
+    std::unique_lock< std::mutex > lock( fMutex );
+    return fCovered;
+}
+
+size_t CNarcissisticNumCalculator::numPartitions() const
+{
+    std::unique_lock< std::mutex > lock( fMutex );
+    return numPartitionsLocked();
+}
 
-    auto end = std::chrono::system_clock::now();
+size_t CNarcissisticNumCalculator::numPartitionsLocked() const
+{
+    auto retVal = fRequeued.size() + fPartitions.size();
+    retVal += countRangePartitions( fRangeCursor, fRangeEnd );
+    for ( auto&& ii : fPendingRanges )
+        retVal += countRangePartitions( ii.first, ii.second );
+    return retVal;
+}
 
-    std::lock_guard< std::mutex > lock( fMutex );
-    fPartitionTimes.push_back( end - start );
+bool CNarcissisticNumCalculator::findNarcissistic( size_t threadNum, TPartitionSet& range )
+{
+    bool complete = false;
+    if ( std::get< 0 >( range ) )
+    {
+        auto next = findNarcissisticRange( threadNum, std::get< 2 >( range ) );
+        complete = ( next == std::get< 2 >( range ).second );
+        std::get< 2 >( range ).first = next;
+    }
+    else
+    {
+        auto&& values = std::get< 1 >( range );
+        auto numChecked = findNarcissisticList( threadNum, values );
+        complete = ( numChecked == values.size() );
+        auto pos = values.begin();
+        std::advance( pos, numChecked );
+        values.erase( values.begin(), pos );
+    }
+    return complete;
 }
 
-void CNarcissisticNumCalculator::findNarcissisticRange( size_t threadNum, uint64_t min, uint64_t max )
+uint64_t CNarcissisticNumCalculator::findNarcissisticRange( size_t threadNum, uint64_t min, uint64_t max )
 {
     return findNarcissisticRange( threadNum, std::make_pair( min, max ) );
 }
 
-void CNarcissisticNumCalculator::findNarcissisticRange( size_t threadNum, const std::pair< uint64_t, uint64_t >& range )
+uint64_t CNarcissisticNumCalculator::findNarcissisticRange( size_t threadNum, const std::pair< uint64_t, uint64_t >& range )
 {
     {
         //std::unique_lock< std::mutex > lock(fMutex);
@@ -476,21 +1923,28 @@ void CNarcissisticNumCalculator::findNarcissisticRange( size_t threadNum, const
         //std::cout << "UnLocked: FindNarcissisticRange - Header\n";
     }
     int numArm = 0;
-    fHandles[ threadNum ].second = std::make_tuple( range.first, range.second, range.first );
-    for ( auto ii = range.first; ii < range.second; ++ii )
     {
-        bool isNarcissistic = false;
-        bool aOK = false;
-        std::tie( isNarcissistic, aOK ) = checkAndAddValue( ii );
-        if ( !aOK )
-            return;
-        if ( isNarcissistic )
+        std::unique_lock< std::mutex > lock( fMutex );
+        fThreadProgress[ threadNum ] = std::make_tuple( range.first, range.second, range.first );
+    }
+    if ( fOrbits )
+        return findOrbitsRange( threadNum, range );
+    auto next = fEngine->findInRange( range.first, range.second,
+        [ this, &numArm ]( uint64_t value )
+        {
+            addNarcissisticValue( value );
             numArm++;
-        if ( fStopped )
-            break;
-
+        },
+        [ this, threadNum ]( uint64_t curr )
+        {
+            std::unique_lock< std::mutex > lock( fMutex ); // not traced, it is taken every kCheckInterval candidates
+            std::get< 2 >( fThreadProgress[ threadNum ] ) = curr;
+            return !fStopped && !fPaused && !checkTimeBudget();
+        } );
+    if ( ( next < range.second ) && !fStopped && !fPaused )
+    {
         std::unique_lock< std::mutex > lock( fMutex );
-        std::get< 2 >( fHandles[ threadNum ].second ) = ii;
+        fIncomplete = true;
     }
     {
         //std::unique_lock< std::mutex > lock(fMutex);
@@ -498,65 +1952,262 @@ void CNarcissisticNumCalculator::findNarcissisticRange( size_t threadNum, const
         //std::cout << "\n" << std::this_thread::get_id() << ": ----> Computing for (" << range.first << "," << range.second - 1 << ")" << " = " << numArm << std::endl;
         //std::cout << "UnLocked: FindNarcissisticRange - Footer\n";
     }
+    return next;
+}
+
+uint64_t CNarcissisticNumCalculator::findOrbitsRange( size_t threadNum, const std::pair< uint64_t, uint64_t >& range )
+{
+    // counted locally, only merged once the partition is done
+    std::vector< uint64_t > stepCounts;
+    std::vector< uint64_t > cycleCounts;
+    auto curr = range.first;
+    while ( curr < range.second )
+    {
+        {
+            std::unique_lock< std::mutex > lock( fMutex ); // not traced, see findNarcissisticRange
+            std::get< 2 >( fThreadProgress[ threadNum ] ) = curr;
+            if ( fStopped || fPaused || checkTimeBudget() )
+                break;
+        }
+
+        auto chunkEnd = ( ( range.second - curr ) > CNarcissisticEngine::kCheckInterval ) ? ( curr + CNarcissisticEngine::kCheckInterval ) : range.second;
+        for ( ; curr < chunkEnd; ++curr )
+        {
+            auto orbit = fOrbits->resolve( curr );
+            if ( orbit.first >= stepCounts.size() )
+                stepCounts.resize( orbit.first + 1 );
+            stepCounts[ orbit.first ]++;
+            if ( orbit.second >= cycleCounts.size() )
+                cycleCounts.resize( orbit.second + 1 );
+            cycleCounts[ orbit.second ]++;
+        }
+    }
+    addOrbits( stepCounts, cycleCounts );
+
+    if ( ( curr < range.second ) && !fStopped && !fPaused )
+    {
+        std::unique_lock< std::mutex > lock( fMutex );
+        fIncomplete = true;
+    }
+    return curr;
 }
 
-void CNarcissisticNumCalculator::findNarcissisticList( size_t threadNum, const std::list< uint64_t >& values )
+void CNarcissisticNumCalculator::addOrbits( const std::vector< uint64_t >& stepCounts, const std::vector< uint64_t >& cycleCounts )
+{
+    std::unique_lock< std::mutex > lock( fMutex );
+    for ( uint32_t ii = 0; ii < stepCounts.size(); ++ii )
+    {
+        if ( stepCounts[ ii ] )
+            fOrbitStepCounts[ ii ] += stepCounts[ ii ];
+    }
+    for ( uint32_t ii = 0; ii < cycleCounts.size(); ++ii )
+    {
+        if ( cycleCounts[ ii ] )
+            fOrbitCycleCounts[ ii ] += cycleCounts[ ii ];
+    }
+}
+
+size_t CNarcissisticNumCalculator::findNarcissisticList( size_t threadNum, const std::list< uint64_t >& values )
 {
     int numArm = 0;
     size_t curr = 0;
-    fHandles[ threadNum ].second = std::make_tuple( 0, values.size(), 0);
+    {
+        std::unique_lock< std::mutex > lock( fMutex );
+        fThreadProgress[ threadNum ] = std::make_tuple( 0, values.size(), 0 );
+    }
     for ( auto ii : values )
     {
+        if ( fOrbits )
+        {
+            auto orbit = fOrbits->resolve( ii );
+            std::vector< uint64_t > stepCounts( orbit.first + 1 );
+            std::vector< uint64_t > cycleCounts( orbit.second + 1 );
+            stepCounts.back() = cycleCounts.back() = 1;
+            addOrbits( stepCounts, cycleCounts );
+            std::unique_lock< std::mutex > lock( fMutex );
+            std::get< 2 >( fThreadProgress[ threadNum ] ) = curr++;
+            if ( fStopped || fPaused || checkTimeBudget() )
+                return curr;
+            continue;
+        }
+
         bool isNarcissistic = false;
         bool aOK = false;
-        std::tie( isNarcissistic, aOK ) = checkAndAddValue( ii );
+        if ( !tableCovers() && fIndex && fIndex->covers( ii ) )
+        {
+            aOK = true;
+            isNarcissistic = fIndex->contains( ii );
+            if ( isNarcissistic )
+                addNarcissisticValue( ii );
+        }
+        else
+            std::tie( isNarcissistic, aOK ) = checkAndAddValue( ii );
         if ( !aOK )
-            return;
+            return curr;
         if ( isNarcissistic )
             numArm++;
-        if ( fStopped )
-            break;
 
         std::unique_lock< std::mutex > lock( fMutex );
-        std::get< 2 >( fHandles[ threadNum ].second ) = curr++;
+        std::get< 2 >( fThreadProgress[ threadNum ] ) = curr++;
+        if ( fStopped || fPaused || checkTimeBudget() )
+            return curr;
     }
+    return curr;
 }
 
 uint64_t CNarcissisticNumCalculator::partition( const TReportFunctionType & reportFunction, bool callInLoop )
 {
+    // the memo would not fit, or F has no bounded domain and resolve would never end, so the job is refused
+    // as if it was stopped before anything was searched
+    if ( fOrbitPower && !CNarcissisticOrbits::supported( fBase, fOrbitPower ) )
+    {
+        std::cerr << "Orbits of power " << fOrbitPower << " in base " << fBase << " need a table of more than " << CNarcissisticOrbits::kMaxDomain << " values, nothing is run" << std::endl;
+        std::unique_lock< std::mutex > lock( fMutex );
+        fIncomplete = true;
+        fFinishedPartition = true;
+        fStopped = true;
+        return 0;
+    }
+
     uint64_t min = 0;
     uint64_t max = 0;
     uint64_t numPartitions = 0;
+    uint64_t work = 0; // digit-candidates, saturated
+    // the known table answers the whole job here, nothing is scheduled on the pool
+    auto fromTable = !fOrbitPower && tableCovers();
+    std::list< uint64_t > tableValues;
+    uint64_t numFromTable = 0;
+    if ( fUseIndex && !fOrbitPower && ( !fIndex || ( fIndex->base() != fBase ) ) )
+        fIndex.reset( new CNarcissisticIndex( fBase ) );
+    else if ( !fUseIndex || fOrbitPower )
+        fIndex.reset();
+    if ( !fOrbitPower )
+        fOrbits.reset();
+    else if ( !fOrbits || ( fOrbits->base() != fBase ) || ( fOrbits->power() != fOrbitPower ) )
+        fOrbits.reset( new CNarcissisticOrbits( fBase, fOrbitPower ) );
+    createEngine();
+
     if ( std::get< 0 >( fNumbers ) )
     {
-        min = std::get< 1 >( fNumbers ).first;
-        max = std::get< 1 >( fNumbers ).second;
-        auto maxNumPartitons = ( max - min ) / fNumPerThread;
-        if ( ( ( max - min ) % fNumPerThread ) != 0 )
-            maxNumPartitons++;
-
-       for ( auto ii = min; ii < max; )
-       {
-           auto lclMax = std::min( std::get< 1 >( fNumbers ).second, static_cast<uint64_t>( ii + fNumPerThread ) );
-           if ( std::numeric_limits<uint64_t >::max() == std::get< 1 >( fNumbers ).second )
-           {
-               auto remaining = std::get< 1 >( fNumbers ).second - ii;
-               if ( fNumPerThread > remaining )
-                   lclMax = std::get< 1 >( fNumbers ).second;
-           }
-           addPartition( std::make_pair( ii, lclMax ) );
-           if ( callInLoop && reportFunction && ( ( numPartitions % 100 ) == 0 ) )
-           {
-               if ( !reportFunction( 0, maxNumPartitons, numPartitions ) )
-                   break;
-           }
-           ii = lclMax; // prevents overflow 
-           ++numPartitions;
-       }
+        auto jobRanges = searchRanges();
+        min = jobRanges.empty() ? std::get< 1 >( fNumbers ).first : jobRanges.front().first;
+        max = jobRanges.empty() ? min : jobRanges.back().second;
+        if ( fNumShards )
+        {
+            auto range = shardedRange();
+            std::tie( min, max ) = fShardRange = CNarcissisticShard::shardRange( range.first, range.second, fBase, fShard, fNumShards );
+            std::list< std::pair< uint64_t, uint64_t > > inShard;
+            for ( auto&& ii : jobRanges )
+            {
+                auto curr = std::make_pair( std::max( ii.first, min ), std::min( ii.second, max ) );
+                if ( curr.second > curr.first )
+                    inShard.push_back( curr );
+            }
+            jobRanges = std::move( inShard );
+        }
+
+        // every range goes through the one cursor, so a multi-range job is scheduled like a single range
+        std::list< std::pair< uint64_t, uint64_t > > ranges;
+        std::list< uint64_t > cached;
+        std::vector< std::tuple< uint64_t, uint64_t, uint64_t > > rangeProgress;
+        if ( fromTable )
+        {
+            // a first-N or next-after query is proven by the table alone, however far the answer is
+            // (or that there is none up to 2^64-1), so only -no_table searches for it
+            for ( auto&& ii : jobRanges )
+            {
+                for ( auto pos = NNarcissisticTable::lowerBound( ii.first, fBase ); ( pos != NNarcissisticTable::end( fBase ) ) && ( *pos < ii.second ) && ( !fFirstN || ( tableValues.size() < fFirstN ) ); ++pos )
+                    tableValues.push_back( *pos );
+                numFromTable += ii.second - ii.first;
+                if ( !fRanges.empty() )
+                    rangeProgress.emplace_back( ii.first, ii.second, ii.second - ii.first );
+            }
+            jobRanges.clear(); // so the covered interval below is the whole job
+        }
+        for ( auto&& ii : jobRanges )
+        {
+            uint64_t numSearched = ii.second - ii.first;
+            if ( fIndex && !isQuery() && !tableCovers() )
+            {
+                // only the gaps in the index are searched, its values are reused for the rest
+                auto gaps = fIndex->gaps( ii.first, ii.second );
+                auto values = fIndex->values( ii.first, ii.second );
+                numSearched = 0;
+                for ( auto&& jj : gaps )
+                    numSearched += jj.second - jj.first;
+                ranges.splice( ranges.end(), gaps );
+                cached.splice( cached.end(), values );
+            }
+            else
+                ranges.push_back( ii );
+            if ( !fRanges.empty() )
+                rangeProgress.emplace_back( ii.first, ii.second, ( ii.second - ii.first ) - numSearched );
+        }
+
+        // the partitions are taken from the cursor as the workers need them, so even
+        // a range to 2^64-1 costs nothing to partition
+        std::unique_lock< std::mutex > lock( fMutex );
+        fPartitionDigits = ( max > min ) ? CNarcissisticEngine::computeNumDigits( max - 1, fBase ) : 1;
+        fSearchedRanges = ranges;
+        fRangeProgress = std::move( rangeProgress );
+        for ( auto&& ii : ranges )
+        {
+            numPartitions += countRangePartitions( ii.first, ii.second );
+            auto counts = CNarcissisticStats::countRange( ii.first, ii.second, fBase );
+            fStats.addRemaining( counts );
+            for ( size_t jj = 1; jj < counts.size(); ++jj )
+                work = CNarcissisticEngine::addSat( work, CNarcissisticEngine::mulSat( counts[ jj ], jj ) );
+        }
+        fNumCached = cached.size();
+        fNarcissisticNumbers.insert( fNarcissisticNumbers.end(), cached.begin(), cached.end() );
+        fNarcissisticNumbers.insert( fNarcissisticNumbers.end(), tableValues.begin(), tableValues.end() );
+        fCovered = std::make_pair( min, ranges.empty() ? std::max( min, max ) : ranges.front().first );
+
+        fRangeCursor = fRangeEnd = min;
+        fPendingRanges = std::move( ranges );
+        if ( !fPendingRanges.empty() )
+        {
+            std::tie( fRangeCursor, fRangeEnd ) = fPendingRanges.front();
+            fPendingRanges.pop_front();
+        }
     }
     else
     {
-        if ( std::get< 2 >( fNumbers ).size() <= fNumPerThread )
+        if ( fNumShards )
+        {
+            // the merge identifies the list by its size and hash
+            auto unique = std::get< 2 >( fNumbers );
+            unique.sort();
+            unique.unique();
+            fShardListSize = unique.size();
+            fShardListHash = CNarcissisticShard::listHash( unique );
+            fShardValues = CNarcissisticShard::shardValues( std::move( unique ), fBase, fShard, fNumShards );
+            std::get< 2 >( fNumbers ) = fShardValues;
+        }
+        auto counts = CNarcissisticStats::countValues( std::get< 2 >( fNumbers ), fBase );
+        for ( size_t jj = 1; jj < counts.size(); ++jj )
+            work += counts[ jj ] * jj;
+        if ( isQuery() )
+            std::get< 2 >( fNumbers ).sort(); // ascending, so the covered interval grows from the smallest value
+        if ( !std::get< 2 >( fNumbers ).empty() )
+        {
+            std::unique_lock< std::mutex > lock( fMutex );
+            fCovered = std::make_pair( std::get< 2 >( fNumbers ).front(), std::get< 2 >( fNumbers ).front() );
+        }
+        if ( fromTable )
+        {
+            auto&& values = std::get< 2 >( fNumbers );
+            std::copy_if( values.begin(), values.end(), std::back_inserter( tableValues ), [ this ]( uint64_t value ) { return NNarcissisticTable::isNarcissistic( value, fBase ); } );
+            numFromTable = values.size();
+            std::unique_lock< std::mutex > lock( fMutex );
+            fNarcissisticNumbers.insert( fNarcissisticNumbers.end(), tableValues.begin(), tableValues.end() );
+            if ( !values.empty() )
+            {
+                auto limits = std::minmax_element( values.begin(), values.end() );
+                fCovered = std::make_pair( *limits.first, std::max( *limits.second, *limits.second + 1 ) );
+            }
+        }
+        else if ( std::get< 2 >( fNumbers ).size() <= fNumPerThread )
         {
             addPartition( std::get< 2 >( fNumbers ) );
             numPartitions++;
@@ -579,6 +2230,8 @@ uint64_t CNarcissisticNumCalculator::partition( const TReportFunctionType & repo
                 addPartition( std::list< uint64_t >( start, end ) );
                 tmp.erase( start, end );
                 numPartitions++;
+                if ( fStopped )
+                    break;
                 if ( callInLoop && reportFunction && ( ( numPartitions % 100 ) == 0 ) )
                 {
                     if ( !reportFunction( 0, max, numPartitions ) )
@@ -591,22 +2244,151 @@ uint64_t CNarcissisticNumCalculator::partition( const TReportFunctionType & repo
     {
         reportFunction( min, max, max );
     }
-    fFinishedPartition = true;
-    fConditionVariable.notify_all();
+    {
+        std::unique_lock< std::mutex > lock( fMutex );
+        fFinishedPartition = true;
+        if ( fromTable )
+        {
+            fCandidatesChecked = numFromTable;
+            fAnswered = fFirstN && ( tableValues.size() >= fFirstN );
+            if ( fProgressObserver )
+                fProgressObserver();
+        }
+    }
+    if ( fLaunched && !fromTable )
+    {
+        auto threshold = ( fInlineThreshold < 0 ) ? calibratedInlineThreshold() : static_cast< uint64_t >( fInlineThreshold );
+        // the throttle, idle priority and result window are only honored by the pool (through hasWork),
+        // idle priority must never be applied to the calling thread
+        auto runInline = ( work < threshold ) && !fThrottle.enabled() && !fThrottle.idlePriority() && !fResultWindow;
+        if ( runInline )
+        {
+            // cheaper than waking the pool, the partitions are run here and the job is usually finished on return
+            fRanInline = true;
+            if ( !runInlineRanges() )
+            {
+                while ( runNextPartition() )
+                    ;
+            }
+            // paused (or a pause requested by a signal), the rest is left to the pool so resume() continues it
+            std::unique_lock< std::mutex > lock( fMutex );
+            runInline = fStopped || ( fRequeued.empty() && fPartitions.empty() && ( fRangeCursor >= fRangeEnd ) );
+            fRanInline = runInline;
+        }
+        if ( !runInline )
+        {
+            // the pool workers persist between runs, only missing workers are created
+            CNarcissisticThreadPool::instance().addJob( this, fPriority, fWeight, fNumThreads );
+        }
+    }
+    CNarcissisticThreadPool::instance().notify();
     return numPartitions;
 }
 
+uint64_t CNarcissisticNumCalculator::calibratedInlineThreshold()
+{
+    // measured once per process, the median of a few samples of each
+    static uint64_t sThreshold = []()
+    {
+        const int kNumSamples = 7;
+        auto median = []( std::vector< double >& samples )
+        {
+            std::nth_element( samples.begin(), samples.begin() + samples.size() / 2, samples.end() );
+            return samples[ samples.size() / 2 ];
+        };
+
+        std::vector< double > spawnSeconds;
+        for ( int ii = 0; ii < kNumSamples; ++ii )
+        {
+            auto start = std::chrono::steady_clock::now();
+            std::thread( []() {} ).join();
+            spawnSeconds.push_back( std::chrono::duration< double >( std::chrono::steady_clock::now() - start ).count() );
+        }
+
+        // 7 digit base 10 candidates with the table engine, typical of the interactive queries
+        const uint64_t kMin = 1000000;
+        const uint64_t kNumCandidates = 4096;
+        auto engine = CNarcissisticEngineRegistry::instance().create( "table", 10, 7 );
+        bool aOK = true;
+        engine->isNarcissistic( kMin, aOK ); // builds the tables
+        std::vector< double > digitSeconds;
+        for ( int ii = 0; ii < kNumSamples; ++ii )
+        {
+            auto start = std::chrono::steady_clock::now();
+            engine->findInRange( kMin, kMin + kNumCandidates, []( uint64_t ) {}, {} );
+            digitSeconds.push_back( std::chrono::duration< double >( std::chrono::steady_clock::now() - start ).count() / ( kNumCandidates * 7 ) );
+        }
+
+        auto numCores = std::max( 1U, std::thread::hardware_concurrency() );
+        return static_cast< uint64_t >( median( spawnSeconds ) * numCores / std::max( median( digitSeconds ), 1e-12 ) );
+    }();
+    return sThreshold;
+}
+
+void CNarcissisticNumCalculator::createEngine()
+{
+    uint64_t maxValue = 0;
+    if ( std::get< 0 >( fNumbers ) )
+        maxValue = std::get< 1 >( fNumbers ).second ? ( std::get< 1 >( fNumbers ).second - 1 ) : 0;
+    else if ( !std::get< 2 >( fNumbers ).empty() )
+        maxValue = *std::max_element( std::get< 2 >( fNumbers ).begin(), std::get< 2 >( fNumbers ).end() );
+    auto numDigits = CNarcissisticEngine::computeNumDigits( maxValue, fBase );
+
+    auto&& registry = CNarcissisticEngineRegistry::instance();
+    if ( ( fEngineName == "auto" ) && fUseSettings )
+    {
+        auto cached = CNarcissisticNumCalculatorDefaults::autoEngine( fBase, numDigits );
+        if ( !cached.empty() && registry.hasEngine( cached ) && !fPowerFunction )
+            registry.setAutoSelection( fBase, numDigits, cached );
+    }
+
+    fEngineNumDigits = numDigits;
+    fEngine = registry.create( fEngineName, fBase, numDigits, fPowerFunction );
+    if ( !fEngine )
+        fEngine = registry.create( "auto", fBase, numDigits, fPowerFunction );
+
+    if ( ( fEngineName == "auto" ) && !fPowerFunction && fUseSettings )
+        CNarcissisticNumCalculatorDefaults::setAutoEngine( fBase, numDigits, fEngine->name() );
+}
+
+void CNarcissisticNumCalculator::reportEngineSpeedup() const
+{
+    if ( !fEngine )
+        return;
+
+    // only known when this run benchmarked the engines
+    auto timings = CNarcissisticEngineRegistry::instance().autoTimings( fBase, fEngineNumDigits );
+    auto pos = timings.find( fEngine->name() );
+    if ( ( pos == timings.end() ) || ( ( *pos ).second <= 0.0 ) )
+        return;
+
+    std::cout << "Engine Speedup:";
+    for ( auto&& ii : timings )
+    {
+        if ( ii.first == fEngine->name() )
+            continue;
+        std::cout << " " << ii.second / ( *pos ).second << "x vs " << ii.first << ";";
+    }
+    std::cout << "\n";
+}
+
+std::string CNarcissisticNumCalculator::engineName() const
+{
+    return fEngine ? fEngine->name() : fEngineName;
+}
+
 void CNarcissisticNumCalculator::reportNumPartitionsRemaining( std::chrono::system_clock::time_point& prev, bool force )
 {
     auto now = std::chrono::system_clock::now();
     auto duration = now - prev;
     if ( force || ( std::chrono::duration_cast<std::chrono::seconds>( duration ).count() > fReportSeconds ) )
     {
+        auto remaining = numPartitions();
         {
             std::unique_lock< std::mutex > lock( fMutex );
             //std::cout << "Locked: reportNumRangesRemaining\n";
-            std::cout << "Number of Ranges Remaining: " << fPartitions.size() << "\n";
-            std::cout << "Number of Threads Remaining: " << fHandles.size() << "\n";
+            std::cout << "Number of Ranges Remaining: " << remaining << ( fPaused ? " (Paused)" : "" ) << "\n";
+            std::cout << "Number of Threads Running: " << fNumActive << "\n";
             //std::cout << "UnLocked: reportNumRangesRemaining\n";
         }
         prev = now;
@@ -615,27 +2397,120 @@ void CNarcissisticNumCalculator::reportNumPartitionsRemaining( std::chrono::syst
 
 bool CNarcissisticNumCalculator::isFinished( std::chrono::system_clock::time_point * prev )
 {
-    for ( auto ii = fHandles.begin(); ii != fHandles.end(); )
+    if ( prev )
+        reportNumPartitionsRemaining( *prev );
+
+    bool finished = true;
+    bool finishedPartition = false;
+    {
+        std::unique_lock< std::mutex > lock( fMutex );
+        finishedPartition = fFinishedPartition;
+        if ( fLaunched )
+            finished = ( fNumActive == 0 ) && ( fStopped || ( fFinishedPartition && fRequeued.empty() && fPartitions.empty() && ( fRangeCursor >= fRangeEnd ) ) );
+    }
+    if ( fLaunched )
+        sampleEnergy( finished );
+    if ( finished && fLaunched )
+        fMetrics->fRunning = false;
+    if ( finished && fLaunched && finishedPartition )
     {
-        if ( prev )
-            reportNumPartitionsRemaining( *prev );
+        fThrottle.stop();
+        finalizeQuery();
+        updateIndex();
+    }
+    return finished;
+}
 
-        if ( ( *ii ).first.wait_for( std::chrono::seconds( 0 ) ) == std::future_status::ready ) // finished
-            ii = fHandles.erase( ii );
-        else
-            break;
+void CNarcissisticNumCalculator::sampleEnergy( bool finished )
+{
+    // isFinished is polled every few ms, and from more than one thread, the counters only need
+    // reading well inside their wrap period (minutes at full load)
+    const auto kSampleInterval = std::chrono::seconds( 1 );
+
+    std::unique_lock< std::mutex > lock( fMutex );
+    auto now = std::chrono::steady_clock::now();
+    if ( finished )
+        fEnergy.stop(); // once, so the energy and seconds end with the run
+    else if ( ( now - fEnergySampled ) >= kSampleInterval )
+    {
+        fEnergySampled = now;
+        fEnergy.sample();
     }
-    return fHandles.empty();
+}
+
+size_t CNarcissisticNumCalculator::numThreads() const
+{
+    std::unique_lock< std::mutex > lock( fMutex );
+    return fNumActive;
+}
+
+void CNarcissisticNumCalculator::updateIndex()
+{
+    if ( fIndexUpdated )
+        return;
+    fIndexUpdated = true;
+
+    if ( !fUseIndex || fOrbits || fStopped || fIncomplete || !std::get< 0 >( fNumbers ) )
+        return;
+
+    if ( !fIndex || ( fIndex->base() != fBase ) )
+        fIndex.reset( new CNarcissisticIndex( fBase ) );
+    fIndex->extend( fSearchedRanges, fNarcissisticNumbers );
 }
 
 std::pair< std::chrono::system_clock::duration, std::chrono::system_clock::duration > CNarcissisticNumCalculator::computeETA() const
 {
-    std::chrono::system_clock::duration totalTime( 0 );
-    for ( auto&& ii : fPartitionTimes )
-        totalTime += ii;
-    auto averageTime = fPartitionTimes.size() ? ( totalTime / fPartitionTimes.size() ) : std::chrono::system_clock::duration( 0 );
-    auto eta = averageTime * numPartitions();
-    return std::make_pair( averageTime, eta );
+    std::unique_lock< std::mutex > lock( fMutex );
+    auto averageTime = std::chrono::duration_cast< std::chrono::system_clock::duration >( fStats.mean() );
+    return std::make_pair( averageTime, remainingTimeLocked() );
+}
+
+std::chrono::system_clock::duration CNarcissisticNumCalculator::remainingTimeLocked() const
+{
+    // the remaining candidates of each length at the measured cost of that length, divided by the
+    // measured concurrency (busy seconds per second of unpaused run time), so throttling and
+    // an over subscribed pool are both accounted for
+    auto elapsed = std::chrono::system_clock::now() - fRunTime.first - fPausedDuration;
+    if ( fPaused )
+        elapsed -= std::chrono::system_clock::now() - fPauseStart;
+    auto elapsedSeconds = std::chrono::duration< double >( elapsed ).count();
+    if ( ( elapsedSeconds <= 0.0 ) || ( fStats.busySeconds() <= 0.0 ) )
+        return std::chrono::system_clock::duration( 0 );
+
+    auto concurrency = fStats.busySeconds() / elapsedSeconds;
+    auto etaSeconds = fStats.remainingCost() / concurrency;
+    return std::chrono::duration_cast< std::chrono::system_clock::duration >( std::chrono::duration< double >( etaSeconds ) );
+}
+
+void CNarcissisticNumCalculator::rangeChecked( uint64_t value, uint64_t numChecked )
+{
+    // a partition never spans two ranges, so the range holding its first value is credited with all of it
+    auto pos = std::upper_bound( fRangeProgress.begin(), fRangeProgress.end(), value,
+        []( uint64_t lhs, const std::tuple< uint64_t, uint64_t, uint64_t >& rhs ) { return lhs < std::get< 0 >( rhs ); } );
+    if ( pos != fRangeProgress.begin() )
+        std::get< 2 >( *std::prev( pos ) ) += numChecked;
+}
+
+void CNarcissisticNumCalculator::publishMetrics( bool force )
+{
+    fMetrics->fHits.store( fNarcissisticNumbers.size(), std::memory_order_relaxed );
+    fMetrics->fActiveThreads.store( fNumActive, std::memory_order_relaxed );
+    fMetrics->fPaused.store( fPaused, std::memory_order_relaxed );
+
+    // the rest walks the pending ranges and the stats, so is refreshed at most every 100ms
+    auto now = std::chrono::steady_clock::now();
+    if ( !force && ( ( now - fMetricsPublished ) < std::chrono::milliseconds( 100 ) ) )
+        return;
+    fMetricsPublished = now;
+    fMetrics->fQueueDepth.store( fRequeued.size() + fPartitions.size(), std::memory_order_relaxed );
+    fMetrics->fPartitionsRemaining.store( numPartitionsLocked(), std::memory_order_relaxed );
+    fMetrics->fETANanos.store( static_cast< uint64_t >( std::chrono::duration_cast< std::chrono::nanoseconds >( remainingTimeLocked() ).count() ), std::memory_order_relaxed );
+}
+
+std::chrono::nanoseconds CNarcissisticNumCalculator::partitionPercentile( double percent ) const
+{
+    std::unique_lock< std::mutex > lock( fMutex );
+    return fStats.percentile( percent );
 }
 
 std::pair< std::string, bool > CNarcissisticNumCalculator::currentResults()
@@ -668,43 +2543,79 @@ std::string CNarcissisticNumCalculator::getRunningResults() const
 
     std::ostringstream oss;
     oss
+        << ( fPaused ? "*** Paused ***\n" : "" )
+        << "Engine: " << engineName() << "\n"
         << "Number of Partitions Remaining: " << numPartitions() << "\n"
-        << "Number of Threads Remaining: " << numThreads() << "\n"
+        << "Number of Threads Remaining: " << numThreads() << " (Limit: " << fNumThreads << ")\n"
         << "Average Time/Partition: " << NUtils::getTimeString( avg, false, true ) << "\n"
+        << "Partition Time p50/p99: " << NUtils::getTimeString( std::chrono::duration_cast< std::chrono::system_clock::duration >( partitionPercentile( 50.0 ) ), false, true )
+        << "/" << NUtils::getTimeString( std::chrono::duration_cast< std::chrono::system_clock::duration >( partitionPercentile( 99.0 ) ), false, true ) << "\n"
         << "ETA: " << NUtils::getTimeString( eta, false, false ) << "\n"
         ;
     oss << "============================\n";
 
-    auto min = std::get< 0 >( fHandles[ 0 ].second );
-    auto max = std::get< 1 >( fHandles[ 0 ].second );
-    for ( size_t ii = 0; ii < fHandles.size(); ++ii )
+    std::vector< bool > slotInUse;
+    std::vector< std::tuple< uint64_t, uint64_t, uint64_t > > threadProgress;
+    std::vector< std::tuple< uint64_t, uint64_t, uint64_t > > rangeProgress;
+    std::list< uint64_t > found;
+    {
+        std::unique_lock< std::mutex > lock( fMutex );
+        slotInUse = fSlotInUse;
+        threadProgress = fThreadProgress;
+        rangeProgress = fRangeProgress;
+        if ( !rangeProgress.empty() )
+            found = fNarcissisticNumbers;
+    }
+
+    uint64_t min = std::numeric_limits< uint64_t >::max();
+    uint64_t max = 0;
+    for ( size_t ii = 0; ii < threadProgress.size(); ++ii )
     {
-        min = std::min( min, std::get< 0 >( fHandles[ ii ].second ) );
-        max = std::max( min, std::get< 1 >( fHandles[ ii ].second ) );
-        oss << "Thread #: " << ii + 1 << " - Min: " << locale.toString( std::get< 0 >( fHandles[ ii ].second ) ).toStdString() << " Max: " << locale.toString( std::get< 1 >( fHandles[ ii ].second ) ).toStdString() << " Curr: " << locale.toString( std::get< 2 >( fHandles[ ii ].second ) ).toStdString() << "\n";
+        if ( !slotInUse[ ii ] )
+            continue;
+        min = std::min( min, std::get< 0 >( threadProgress[ ii ] ) );
+        max = std::max( max, std::get< 1 >( threadProgress[ ii ] ) );
+        oss << "Thread #: " << ii + 1 << " - Min: " << locale.toString( std::get< 0 >( threadProgress[ ii ] ) ).toStdString() << " Max: " << locale.toString( std::get< 1 >( threadProgress[ ii ] ) ).toStdString() << " Curr: " << locale.toString( std::get< 2 >( threadProgress[ ii ] ) ).toStdString() << "\n";
     }
+    if ( min > max )
+        min = max = 0;
     oss << "============================\n";
     oss << "Range: [" << locale.toString( min ).toStdString() << ":" << locale.toString( max ).toStdString() << "]\n";
     oss << "============================\n";
+    for ( auto&& ii : rangeProgress )
+    {
+        auto size = std::get< 1 >( ii ) - std::get< 0 >( ii );
+        auto numFound = std::count_if( found.begin(), found.end(), [ &ii ]( uint64_t value ) { return ( value >= std::get< 0 >( ii ) ) && ( value < std::get< 1 >( ii ) ); } );
+        oss << "Range [" << locale.toString( std::get< 0 >( ii ) ).toStdString() << ":" << locale.toString( std::get< 1 >( ii ) ).toStdString() << "): "
+            << locale.toString( size ? ( 100.0 * std::get< 2 >( ii ) / size ) : 100.0, 'f', 1 ).toStdString() << "% - " << numFound << " found\n";
+    }
+    if ( !rangeProgress.empty() )
+        oss << "============================\n";
     return oss.str();
 }
 
 void CNarcissisticNumCalculator::addNarcissisticValue( uint64_t value )
 {
-    std::lock_guard< std::mutex > lock( fMutex );
+    CNarcissisticTrace::CScope scope( CNarcissisticTrace::EKind::eResult, "result" );
+    scope.setArgs( value );
+    CNarcissisticTrace::CLock< std::mutex > lock( fMutex, "commit result" );
     fNarcissisticNumbers.push_back( value );
 }
 
 void CNarcissisticNumCalculator::addPartition( const std::pair< uint64_t, uint64_t >& range )
 {
     auto&& tmp = std::make_tuple( true, std::list< uint64_t >(), range );
+    auto lengthCounts = partitionLengthCounts( tmp );
     std::unique_lock< std::mutex > lock( fMutex );
+    fStats.addRemaining( lengthCounts );
     fPartitions.push_back( tmp );
 }
 
 void CNarcissisticNumCalculator::addPartition( const std::list< uint64_t >& list )
 {
     auto&& tmp = std::make_tuple( false, list, std::make_pair< uint64_t, uint64_t >( 0, 0 ) );
+    auto lengthCounts = partitionLengthCounts( tmp );
     std::unique_lock< std::mutex > lock( fMutex );
+    fStats.addRemaining( lengthCounts );
     fPartitions.push_back( tmp );
 }
@@ -23,16 +23,24 @@
 #ifndef __NARCISSISTICNUMCALCULATOR_H
 #define __NARCISSISTICNUMCALCULATOR_H
 
+#include "NarcissisticThreadPool.h"
+#include "NarcissisticThrottle.h"
+#include "NarcissisticEnergy.h"
+#include "NarcissisticStats.h"
+#include "NarcissisticMetrics.h"
 #include "SABUtils/utils.h"
 
 #include <algorithm>
+#include <atomic>
 #include <list>
+#include <map>
 #include <chrono>
 #include <mutex>
 #include <future>
 #include <functional>
 #include <condition_variable>
 #include <string>
+#include <memory>
 #ifdef _DEBUG
 static uint32_t kDefaultMaxNum{ 100000 };
 #else
@@ -59,16 +67,76 @@ namespace CNarcissisticNumCalculatorDefaults
     std::list< uint64_t > numbersList();
     void setNumbersList( const std::list< uint64_t >& values );
 
+    bool byRanges();
+    void setByRanges( bool value );
+
+    std::list< std::pair< uint64_t, uint64_t > > rangesList();
+    void setRangesList( const std::list< std::pair< uint64_t, uint64_t > >& values );
+
     bool useStringBasedAnalysis();
     void setUseStringBasedAnalysis( bool value );
 
+    bool useIndex();
+    void setUseIndex( bool value );
+
+    bool useKnownTable();
+    void setUseKnownTable( bool value );
+
+    // "auto" or one of the registered engine names
+    std::string engine();
+    void setEngine( const std::string& value );
+
+    // the engine chosen by auto for the base and digit length, empty if not benchmarked yet
+    std::string autoEngine( int base, int numDigits );
+    void setAutoEngine( int base, int numDigits, const std::string& value );
+
     void reset();
 }
-    
-class CNarcissisticNumCalculator
+
+// everything an embedded calculator needs (see CNarcissisticSearch), nothing is read from or written to QSettings
+struct SNarcissisticConfig
 {
+    int fBase{ 10 };
+    bool fByRange{ true };
+    std::pair< uint64_t, uint64_t > fRange{ 0, kDefaultMaxNum };
+    std::list< std::pair< uint64_t, uint64_t > > fRanges; // when set replaces fRange
+    std::list< uint64_t > fNumbers;
+    uint32_t fNumThreads{ 0 }; // 0 is one per core
+    uint64_t fNumPerPartition{ 100 };
+    std::string fEngine{ "auto" };
+    bool fUseIndex{ false };
+    bool fUseKnownTable{ true };
+    int fPriority{ 0 };
+    double fWeight{ 1.0 };
+    size_t fMaxBuffered{ 64 }; // results found but not yet consumed before the workers are held back, 0 is unbounded
+    int64_t fInlineThreshold{ -1 }; // see CNarcissisticNumCalculator::setInlineThreshold
+};
+
+// the dry run prediction of a run, from short timed slices of every digit length to be searched
+struct SNarcissisticEstimate
+{
+    bool fFromTable{ false }; // the known table answers the range, nothing is searched
+    bool fUnsupported{ false }; // the orbit memo for the base and power does not fit, nothing would be run
+    uint64_t fCandidates{ 0 }; // the index and the known table are taken into account
+    std::map< int, double > fSecondsPerCandidate; // measured on this machine, by digit length
+    double fCPUSeconds{ 0.0 };
+    double fWallSeconds{ 0.0 }; // the CPU time over the threads that can run at once
+    double fConcurrency{ 1.0 };
+    size_t fMemoryBytes{ 0 }; // the engine tables for every length searched, and the orbit memo
+
+    std::string toString() const;
+};
+
+class CNarcissisticIndex;
+class CNarcissisticEngine;
+class CNarcissisticOrbits;
+// Each calculator is a job on the shared CNarcissisticThreadPool, with its own partitions, results and cancellation
+class CNarcissisticNumCalculator : public CNarcissisticJob
+{
+    friend class CNarcissisticBench;
 public:
     CNarcissisticNumCalculator( bool saveSettings=true );
+    explicit CNarcissisticNumCalculator( const SNarcissisticConfig& config );
     ~CNarcissisticNumCalculator();
     bool parse( int argc, char** argv );
     std::chrono::system_clock::duration run( const std::function< uint64_t( uint64_t, uint64_t ) >& pwrFunction );
@@ -81,70 +149,272 @@ public:
     uint64_t partition( const TReportFunctionType & reportFunction, bool callInLoop );
 
     void setBase( int value ) { if ( ( value < 2 ) || ( value > 36 ) ) return; fBase = value; }
-    void setNumThreads( int value ){ fNumThreads = value; }
+    // may be changed while running, partitions already running finish before a thread is retired
+    void setNumThreads( int value );
+    uint32_t maxThreads() const { return fNumThreads; }
+    void setPriority( int value );
+    void setWeight( double value );
     void setNumPerThread( uint64_t value ) { fNumPerThread = value; }
     void setByRange( bool value ){ std::get< 0 >( fNumbers ) = value; }
-    void setRange( const std::pair< uint64_t, uint64_t >& value ) { std::get< 1 >( fNumbers ) = value; }
+    void setRange( const std::pair< uint64_t, uint64_t >& value ) { std::get< 1 >( fNumbers ) = value; fRanges.clear(); } // replaces any list of ranges
+    // a multi-range job, searched by one partitioner on one set of workers, empty is the single range
+    // the ranges are normalized when set
+    void setRanges( const std::list< std::pair< uint64_t, uint64_t > >& value );
+    const std::list< std::pair< uint64_t, uint64_t > >& ranges() const { return fRanges; }
+    // the ranges a range job searches
+    std::list< std::pair< uint64_t, uint64_t > > searchRanges() const;
+    // sorted, with the empty ranges removed and the overlapping and adjacent ranges merged
+    static std::list< std::pair< uint64_t, uint64_t > > normalizeRanges( std::list< std::pair< uint64_t, uint64_t > > ranges );
+    // min:max for [min:max), separated by spaces, commas or new lines, # comments to the end of the line
+    static bool parseRanges( const std::string& text, std::list< std::pair< uint64_t, uint64_t > >& ranges, std::string& errorMsg );
+    static std::string rangesString( const std::list< std::pair< uint64_t, uint64_t > >& ranges );
     void setNumbersList( const std::list< uint64_t >& values ) { std::get< 2 >( fNumbers ) = values; }
+    void setUseIndex( bool value ){ fUseIndex = value; }
+    void setUseKnownTable( bool value ){ fUseKnownTable = value; }
+    void setEngine( const std::string& value ){ fEngineName = value; }
+    // records a timeline of the run, written as Chrome trace JSON by run()
+    void setTraceFile( const std::string& value ){ fTraceFile = value; }
+    // serves the metrics of every calculator on http://127.0.0.1:<port>/metrics while run() runs
+    void setMetricsPort( uint16_t value ){ fMetricsPort = value; }
+    // a launched job costing less than this many digit-candidates is run by partition() on the calling
+    // thread, without the pool, -1 is calibrated for this machine, 0 always uses the pool
+    void setInlineThreshold( int64_t value ){ fInlineThreshold = value; }
+    // the digit-candidates this machine checks in the time it takes to start and join a thread per core
+    static uint64_t calibratedInlineThreshold();
+    bool ranInline() const { return fRanInline; }
+
+    // orbit mode, rather than the fixed points every value is followed under F(n) = sum of its digits^power
+    // to the cycle it ends in, 0 is the normal search
+    void setOrbitPower( int value ){ fOrbitPower = value; }
+
+    // dry run, samples the engine on every digit length of the current setup, nothing is searched
+    SNarcissisticEstimate estimate();
+    // run() only prints the estimate
+    void setEstimateOnly( bool value ){ fEstimateOnly = value; }
+    int orbitPower() const { return fOrbitPower; }
+
+    // static sharding, the run only searches shard of numShards cost balanced parts of the range or list
+    // and writes what it covered and found to the shard file (CNarcissisticShard)
+    void setShard( uint32_t shard, uint32_t numShards ){ fShard = shard; fNumShards = numShards; }
+    void setShardFile( const std::string& value ){ fShardFile = value; }
+    std::string shardFile() const;
+    // run() merges the shard files and reports the whole job, rather than searching
+    void setMergeFiles( const std::list< std::string >& value ){ fMergeFiles = value; }
+    // the shard file could not be written, or the merge found the shards incomplete
+    bool shardFailed() const { return fShardFailed; }
+    std::vector< std::vector< uint64_t > > orbitCycles() const; // the cycles reached, each from its smallest member
+    std::map< uint32_t, uint64_t > orbitCycleCounts() const; // index in orbitCycles to the number of values ending in it
+    std::map< uint32_t, uint64_t > orbitStepCounts() const; // steps to reach a cycle to the number of values
+
+    // background mode, duty cycles the workers to a rate of core-seconds per second (or a percentage of all cores)
+    void setThrottleRate( double coreSecondsPerSecond ){ fThrottle.setRate( coreSecondsPerSecond ); }
+    void setThrottleCPUPercent( double percent ){ fThrottle.setCPUPercent( percent ); }
+    void setAdaptiveThrottle( bool value ){ fThrottle.setAdaptive( value ); }
+    void setIdlePriority( bool value ){ fThrottle.setIdlePriority( value ); }
+    const CNarcissisticThrottle& throttle() const { return fThrottle; }
+    // package energy of the run, sampled while polling for the finish
+    const CNarcissisticEnergy& energy() const { return fEnergy; }
+    uint64_t candidatesChecked() const { return fCandidatesChecked; }
+    std::string engineName() const; // the resolved engine once partitioned
+
+    // query modes, partitions are scheduled in ascending order and the run stops as soon as the answer is proven
+    void setFirstN( uint64_t value ){ fFirstN = value; }
+    void setNextAfter( uint64_t value ); // the range becomes ( value:2^64-1 ), first 1
+    void setTimeBudget( const std::chrono::milliseconds& value ){ fTimeBudget = value; }
+    void setCandidateBudget( uint64_t value ){ fCandidateBudget = value; }
+    bool isQuery() const { return ( fFirstN != 0 ) || ( fTimeBudget.count() != 0 ) || ( fCandidateBudget != 0 ); }
+    bool queryAnswered() const;
+    bool budgetExpired() const;
+    // every candidate in [first:second) has been checked, and all its hits are in results()
+    std::pair< uint64_t, uint64_t > coveredInterval() const;
 
     const std::list< uint64_t > & results() const{ return fNarcissisticNumbers; }
+
+    // consumers that pull results while the job runs (CNarcissisticSearch)
+    // the observer is called with the calculator locked after every partition, it must not call back into the calculator
+    void setProgressObserver( const std::function< void() >& observer );
+    // the results in [from:covered) ascending, from becomes the end of the covered interval
+    // once the job is finished every remaining result is returned
+    std::list< uint64_t > provenResults( uint64_t& from, bool finished ) const;
+    // backpressure, no new partitions are started while maxUnconsumed results have not been consumed
+    void setResultWindow( size_t maxUnconsumed ){ fResultWindow = maxUnconsumed; }
+    void resultsConsumed( size_t num );
     std::chrono::system_clock::time_point startTime() const{ return fRunTime.first; }
-    size_t numPartitions() const{ return fPartitions.size(); }
-    size_t numThreads() const { return fHandles.size(); }
+    size_t numPartitions() const;
+    size_t numThreads() const;
     bool isFinished( std::chrono::system_clock::time_point * prev );
     std::pair< std::string, bool > currentResults();
 
     std::string getRunningResults() const;
 
-    void setStopped( bool stopped ){ fStopped = stopped; }
+    // pause, resume and cancel are safe to call from any thread, running partitions react within
+    // CNarcissisticEngine::kCheckInterval candidates, a paused partition is requeued from where it stopped
+    void pause();
+    void resume();
+    void cancel(){ setStopped( true ); }
+    void setStopped( bool stopped );
+    bool isPaused() const { return fPaused; }
+    bool isStopped() const { return fStopped; }
+    // returns false if a partition was still running when the timeout expired
+    bool waitUntilIdle( const std::chrono::milliseconds& timeout );
+
+    // SIGINT cancels, SIGTSTP pauses and SIGCONT resumes the calculator running in run()
+    // SIGUSR1 adds a thread and SIGUSR2 retires one
+    static void enableSignalHandling();
+    // the average partition time, and the remaining candidates of each digit length at their measured cost
     std::pair< std::chrono::system_clock::duration, std::chrono::system_clock::duration > computeETA() const;
+    std::chrono::nanoseconds partitionPercentile( double percent ) const;
 private:
     void loadSettings();
     void saveSettings() const;
+    void handleSignals();
 
     static int getInt( int& ii, int argc, char** argv, const char* switchName, bool& aOK );
+    static uint64_t getUInt64( int& ii, int argc, char** argv, const char* switchName, bool& aOK );
+    static double getDouble( int& ii, int argc, char** argv, const char* switchName, bool& aOK );
+    static std::string getString( int& ii, int argc, char** argv, const char* switchName, bool& aOK );
+    std::pair< uint64_t, uint64_t > shardedRange() const; // the whole range the shards are cut from
+    void createEngine();
+    void reportEngineSpeedup() const;
     void dumpNumbers( const std::list< uint64_t >& numbers ) const;
     void report();
     void reportFindings();
+    void reportOrbits() const;
+    void writeShardFile();
+    std::chrono::system_clock::duration mergeShards();
     std::pair< bool, bool > checkAndAddValue( uint64_t value );
+    bool tableCovers() const;
 
     using TPartitionSet = std::tuple< bool, std::list< uint64_t >, std::pair< uint64_t, uint64_t > >;
 
-    void findNarcissistic( size_t threadNum, const TPartitionSet& currRange );
-    void findNarcissisticRange( size_t threadNum, uint64_t min, uint64_t max );
-    void findNarcissisticRange( size_t threadNum, const std::pair< uint64_t, uint64_t >& range );
-    void findNarcissisticList( size_t threadNum, const std::list< uint64_t >& values );
+    // returns true if every candidate was checked, otherwise currRange is left with the unchecked candidates
+    bool findNarcissistic( size_t threadNum, TPartitionSet& currRange );
+    // returns the first value not checked
+    uint64_t findNarcissisticRange( size_t threadNum, uint64_t min, uint64_t max );
+    uint64_t findNarcissisticRange( size_t threadNum, const std::pair< uint64_t, uint64_t >& range );
+    // returns the number of values checked
+    size_t findNarcissisticList( size_t threadNum, const std::list< uint64_t >& values );
+    // orbit mode versions of the above
+    uint64_t findOrbitsRange( size_t threadNum, const std::pair< uint64_t, uint64_t >& range );
+    void addOrbits( const std::vector< uint64_t >& stepCounts, const std::vector< uint64_t >& cycleCounts );
+    static uint64_t partitionSize( const TPartitionSet& partition );
+    static uint64_t partitionEnd( const TPartitionSet& partition );
+    uint64_t rangePartitionEnd( uint64_t curr, uint64_t end, bool wholeLength = false ) const;
+    uint64_t countRangePartitions( uint64_t min, uint64_t max ) const;
+    CNarcissisticStats::TLengthCounts partitionLengthCounts( const TPartitionSet& partition ) const;
     void reportNumPartitionsRemaining( std::chrono::system_clock::time_point& prev, bool force = false );
 
     void addNarcissisticValue( uint64_t value );
+    void updateIndex();
 
     void addPartition( const std::pair< uint64_t, uint64_t >& range );
     void addPartition( const std::list< uint64_t >& list );
-    void analyzeNextPartition( size_t threadNum );
+    bool takeNextPartition( TPartitionSet& partition, uint64_t& index, bool wholeLength = false ); // fMutex must be held
+    void partitionCompleted( uint64_t index, uint64_t endValue, uint64_t numCandidates ); // fMutex must be held
+    bool checkTimeBudget(); // fMutex must be held
+    size_t numPartitionsLocked() const; // fMutex must be held
+    std::chrono::system_clock::duration remainingTimeLocked() const; // fMutex must be held
+    void publishMetrics( bool force ); // fMutex must be held
+    void rangeChecked( uint64_t value, uint64_t numChecked ); // fMutex must be held
+    void finalizeQuery();
+    void sampleEnergy( bool finished );
+
+    bool runInlineRanges(); // false when the job needs runNextPartition()
+    bool hasWork() const override;
+    bool runNextPartition() override;
+    bool idlePriority() const override { return fThrottle.idlePriority(); }
 
     // setup
     int fBase{ 10 };
     std::tuple< bool, std::pair< uint64_t, uint64_t >, std::list< uint64_t > > fNumbers = std::make_tuple< bool, std::pair< uint64_t, uint64_t >, std::list< uint64_t > >( true, { 0, kDefaultMaxNum }, std::list< uint64_t >() );
+    std::list< std::pair< uint64_t, uint64_t > > fRanges; // normalized, empty is the single range
     uint64_t fNumPerThread{ 100 };
     int32_t fReportSeconds{ 5 };
-    uint32_t fNumThreads;
-    std::function< uint64_t( uint64_t, uint64_t ) > fPowerFunction = []( uint64_t x, uint64_t y )->uint64_t { return NUtils::power( x, y ); };
+    std::atomic< uint32_t > fNumThreads{ 0 };
+    std::function< uint64_t( uint64_t, uint64_t ) > fPowerFunction; // empty uses the engines own (overflow safe) power
+    std::string fEngineName{ "auto" };
+    bool fUseIndex{ true };
+    bool fUseKnownTable{ true };
+    std::string fTraceFile;
+    uint16_t fMetricsPort{ 0 };
+    int64_t fInlineThreshold{ -1 };
+    int fOrbitPower{ 0 };
+    bool fEstimateOnly{ false };
+    uint32_t fShard{ 0 };
+    uint32_t fNumShards{ 0 }; // 0 is not sharded
+    std::string fShardFile;
+    std::list< std::string > fMergeFiles;
+    mutable CNarcissisticThrottle fThrottle; // hasWork consults it
+    CNarcissisticEnergy fEnergy; // fMutex must be held while sampling
+    std::chrono::steady_clock::time_point fEnergySampled;
 
 
     // results
     std::list< uint64_t > fNarcissisticNumbers;
-    std::list< std::chrono::system_clock::duration > fPartitionTimes;
+    CNarcissisticStats fStats; // fixed size, updated under fMutex
+    std::shared_ptr< CNarcissisticMetrics::SJob > fMetrics; // read by scrapes without fMutex
+    std::chrono::steady_clock::time_point fMetricsPublished;
     std::pair< std::chrono::system_clock::time_point, std::chrono::system_clock::time_point > fRunTime;
 
     // used to do the thread pool
-    std::mutex fMutex;
-    std::condition_variable fConditionVariable;
-    std::vector< std::pair< std::future< void >, std::tuple< uint64_t, uint64_t, uint64_t > > > fHandles;
+    mutable std::mutex fMutex;
+    std::condition_variable fIdle;
+    int fPriority{ 0 };
+    double fWeight{ 1.0 };
+    bool fLaunched{ false };
+    bool fRanInline{ false };
+    size_t fNumActive{ 0 };
+    std::vector< bool > fSlotInUse;
+    std::vector< std::tuple< uint64_t, uint64_t, uint64_t > > fThreadProgress; // min, max, curr for each slot
 
     // computational values
     std::list< TPartitionSet > fPartitions;
+    std::list< std::pair< uint64_t, TPartitionSet > > fRequeued; // the remainders of paused partitions, by partition index
+    uint64_t fRangeCursor{ 0 }; // range partitions are created as they are needed
+    uint64_t fRangeEnd{ 0 };
+    std::list< std::pair< uint64_t, uint64_t > > fPendingRanges; // the ranges after [fRangeCursor:fRangeEnd)
+    std::list< std::pair< uint64_t, uint64_t > > fSearchedRanges; // the parts of the range not covered by the index
+    std::vector< std::tuple< uint64_t, uint64_t, uint64_t > > fRangeProgress; // min, max, checked for each of fRanges
+    size_t fNumCached{ 0 }; // results taken from the index
+    int fPartitionDigits{ 1 }; // the length a partition of fNumPerThread candidates is sized for
+
+    // query modes
+    uint64_t fFirstN{ 0 };
+    std::chrono::milliseconds fTimeBudget{ 0 };
+    uint64_t fCandidateBudget{ 0 };
+    uint64_t fCandidatesChecked{ 0 };
+    uint64_t fNextPartitionIndex{ 0 };
+    uint64_t fFrontier{ 0 }; // every partition before this index has completed
+    std::map< uint64_t, uint64_t > fCompletedAboveFrontier; // partition index to its end value
+    std::pair< uint64_t, uint64_t > fCovered{ 0, 0 };
+    bool fAnswered{ false };
+    bool fBudgetExpired{ false };
+    bool fQueryFinalized{ false };
+
+    std::unique_ptr< CNarcissisticIndex > fIndex;
+    std::unique_ptr< CNarcissisticOrbits > fOrbits; // kept between runs of the same base and power, it is a memo
+    std::map< uint32_t, uint64_t > fOrbitStepCounts;
+    std::map< uint32_t, uint64_t > fOrbitCycleCounts;
+    std::shared_ptr< CNarcissisticEngine > fEngine;
+    int fEngineNumDigits{ 0 };
     bool fSaveSettings{ true };
+    bool fUseSettings{ true }; // false when embedded, the auto engine choice is not cached either
+    std::function< void() > fProgressObserver;
+    size_t fResultWindow{ 0 };
+    size_t fNumConsumed{ 0 };
     bool fFinishedPartition{ false };
-    bool fStopped{ false };
+    std::atomic< bool > fStopped{ false };
+    std::atomic< bool > fPaused{ false };
+    std::chrono::system_clock::time_point fPauseStart;
+    std::chrono::system_clock::duration fPausedDuration{ 0 };
+    bool fIncomplete{ false };
+    bool fIndexUpdated{ false };
+
+    // sharding, the part of the job this shard searched
+    std::pair< uint64_t, uint64_t > fShardRange{ 0, 0 };
+    std::list< uint64_t > fShardValues;
+    uint64_t fShardListSize{ 0 };
+    uint64_t fShardListHash{ 0 };
+    bool fShardFailed{ false };
 };
 #endif
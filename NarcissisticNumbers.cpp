@@ -22,6 +22,7 @@
 
 #include "NarcissisticNumbers.h"
 #include "NarcissisticNumCalculator.h"
+#include "NarcissisticEngine.h"
 #include "SABUtils/utils.h"
 #include "SABUtils/SpinBox64.h"
 #include "SABUtils/SpinBox64U.h"
@@ -39,6 +40,7 @@
 #include <QProgressDialog>
 #include <QCloseEvent>
 #include <QProgressBar>
+#include <QApplication>
 
 CNarcissisticNumbers::CNarcissisticNumbers( QWidget* parent )
     : QDialog( parent ),
@@ -49,22 +51,34 @@ CNarcissisticNumbers::CNarcissisticNumbers( QWidget* parent )
     fImpl->minRange->setMaximum( CSpinBox64U::maxAllowed() );
     fImpl->numPerThread->setMaximum( CSpinBox64::maxAllowed() );
     fImpl->maxLabel->setText( tr( "Maximum: %1").arg( locale().toString( CSpinBox64U::maxAllowed() ) ) );
+    auto engines = CNarcissisticEngineRegistry::instance().names();
+    engines.push_front( "auto" );
+    for ( auto&& ii : engines )
+    {
+        fImpl->engine->addItem( QString::fromStdString( ii ) );
+        fImpl->engine->setItemData( fImpl->engine->count() - 1, QString::fromStdString( CNarcissisticEngineRegistry::instance().description( ii ) ), Qt::ToolTipRole );
+    }
     //setWindowFlags( windowFlags() & ~Qt::WindowContextHelpButtonHint );
 
     (void)connect( fImpl->byRange, &QAbstractButton::clicked, this, [this](){ slotChanged(); } );
     (void)connect( fImpl->byNumbers, &QAbstractButton::clicked, this, [ this ]() { slotChanged(); } );
+    (void)connect( fImpl->byRanges, &QAbstractButton::clicked, this, [ this ]() { slotChanged(); } );
     (void)connect( fImpl->run, &QAbstractButton::clicked, this, [ this ]() { slotRun(); } );
     (void)connect( fImpl->reset, &QAbstractButton::clicked, this, [ this ]() { slotReset(); } );
+    (void)connect( fImpl->pause, &QAbstractButton::clicked, this, [ this ]() { slotPause(); } );
+    (void)connect( fImpl->estimate, &QAbstractButton::clicked, this, [ this ]() { slotEstimate(); } );
     (void)connect( fImpl->maxRange, static_cast<void (CSpinBox64U::*)( uint64_t )>( &CSpinBox64U::valueChanged ), this, [ this ]() { slotRangeChanged(); } );
     (void)connect( fImpl->minRange, static_cast<void (CSpinBox64U::*)( uint64_t )>( &CSpinBox64U::valueChanged ), this, [ this ]() { slotRangeChanged(); } );
     (void)connect( fImpl->base, static_cast<void ( QSpinBox::* )( int )>( &QSpinBox::valueChanged ), fImpl->minRange, &CSpinBox64U::setDisplayIntegerBase );
     (void)connect( fImpl->base, static_cast<void ( QSpinBox::* )( int )>( &QSpinBox::valueChanged ), fImpl->maxRange, &CSpinBox64U::setDisplayIntegerBase ) ;
     (void)connect( fImpl->setToMax, &QAbstractButton::clicked, this, [ this ]() { slotSetToMax(); } );
+    (void)connect( fImpl->numThreads, static_cast<void ( QSpinBox::* )( int )>( &QSpinBox::valueChanged ), this, [ this ]() { slotNumThreadsChanged(); } );
 
     fImpl->numCoresLabel->setText( tr( "Number of Cores: %1" ).arg( std::thread::hardware_concurrency() ) );
     loadSettings();
     setFocus( Qt::MouseFocusReason );
     slotChanged();
+    fImpl->pause->setEnabled( false );
     fMonitorTimer = new QTimer( this );
     fMonitorTimer->setSingleShot( false );
     fMonitorTimer->setInterval( 50 );
@@ -80,9 +94,15 @@ void CNarcissisticNumbers::closeEvent( QCloseEvent * e )
 {
     if ( fCalculator && !fCalculator->isFinished( nullptr ) )
     {
+        // the running partitions react within a few ms, so this only retries if a partition is stuck
+        fCalculator->cancel();
+        if ( fCalculator->waitUntilIdle( std::chrono::milliseconds( 50 ) ) && fCalculator->isFinished( nullptr ) )
+        {
+            e->accept();
+            return;
+        }
         e->ignore();
-        fCalculator->setStopped( true );
-        QTimer::singleShot( 0, this, &QDialog::close );
+        QTimer::singleShot( 10, this, &QDialog::close );
     }
     else
         e->accept();
@@ -94,13 +114,17 @@ void CNarcissisticNumbers::loadSettings()
     fImpl->base->setValue( CNarcissisticNumCalculatorDefaults::base() );
     fImpl->numThreads->setValue( CNarcissisticNumCalculatorDefaults::numThreads() );
     fImpl->numPerThread->setValue( CNarcissisticNumCalculatorDefaults::numPerThread() );
+    fImpl->engine->setCurrentText( QString::fromStdString( CNarcissisticNumCalculatorDefaults::engine() ) );
 
-    fImpl->byRange->setChecked( CNarcissisticNumCalculatorDefaults::byRange() );
+    auto byRanges = CNarcissisticNumCalculatorDefaults::byRange() && CNarcissisticNumCalculatorDefaults::byRanges();
+    fImpl->byRange->setChecked( CNarcissisticNumCalculatorDefaults::byRange() && !byRanges );
     fImpl->byNumbers->setChecked( !CNarcissisticNumCalculatorDefaults::byRange() );
+    fImpl->byRanges->setChecked( byRanges );
     fImpl->minRange->setValue( CNarcissisticNumCalculatorDefaults::range().first );
     fImpl->maxRange->setValue( CNarcissisticNumCalculatorDefaults::range().second );
 
     setNumbersList( CNarcissisticNumCalculatorDefaults::numbersList()  );
+    fImpl->rangeList->setText( QString::fromStdString( CNarcissisticNumCalculator::rangesString( CNarcissisticNumCalculatorDefaults::rangesList() ) ) );
 }
 
 void CNarcissisticNumbers::saveSettings() const
@@ -109,10 +133,15 @@ void CNarcissisticNumbers::saveSettings() const
     CNarcissisticNumCalculatorDefaults::setBase( fImpl->base->value() );
     CNarcissisticNumCalculatorDefaults::setNumThreads( fImpl->numThreads->value() );
     CNarcissisticNumCalculatorDefaults::setNumPerThread( fImpl->numPerThread->value() );
+    CNarcissisticNumCalculatorDefaults::setEngine( fImpl->engine->currentText().toStdString() );
 
-    CNarcissisticNumCalculatorDefaults::setByRange( fImpl->byRange->isChecked() );
+    CNarcissisticNumCalculatorDefaults::setByRange( !fImpl->byNumbers->isChecked() );
     CNarcissisticNumCalculatorDefaults::setRange( std::make_pair( fImpl->minRange->value(), fImpl->maxRange->value() ) );
     CNarcissisticNumCalculatorDefaults::setNumbersList( getNumbersList() );
+    CNarcissisticNumCalculatorDefaults::setByRanges( fImpl->byRanges->isChecked() );
+    std::list< std::pair< uint64_t, uint64_t > > ranges;
+    if ( getRangesList( ranges ) )
+        CNarcissisticNumCalculatorDefaults::setRangesList( ranges );
 }
 
 void CNarcissisticNumbers::setNumbersList( const std::list< uint64_t >& numbers )
@@ -137,11 +166,36 @@ std::list< uint64_t > CNarcissisticNumbers::getNumbersList() const
     return numbers;
 }
 
+bool CNarcissisticNumbers::getRangesList( std::list< std::pair< uint64_t, uint64_t > >& ranges, QString* errorMsg ) const
+{
+    std::string msg;
+    auto aOK = CNarcissisticNumCalculator::parseRanges( fImpl->rangeList->text().toStdString(), ranges, msg );
+    if ( errorMsg )
+        *errorMsg = QString::fromStdString( msg );
+    return aOK;
+}
+
+bool CNarcissisticNumbers::validateRanges()
+{
+    if ( !fImpl->byRanges->isChecked() )
+        return true;
+
+    std::list< std::pair< uint64_t, uint64_t > > ranges;
+    QString errorMsg;
+    if ( !getRangesList( ranges, &errorMsg ) || ranges.empty() )
+    {
+        QMessageBox::warning( this, tr( "List of Ranges" ), errorMsg.isEmpty() ? tr( "Enter at least one range as min:max" ) : tr( "Invalid range list, %1" ).arg( errorMsg ) );
+        return false;
+    }
+    return true;
+}
+
 void CNarcissisticNumbers::slotChanged()
 {
     fImpl->minRange->setEnabled( fImpl->byRange->isChecked() );
     fImpl->maxRange->setEnabled( fImpl->byRange->isChecked() );
     fImpl->numList->setEnabled( fImpl->byNumbers->isChecked() );
+    fImpl->rangeList->setEnabled( fImpl->byRanges->isChecked() );
 }
 
 void CNarcissisticNumbers::slotReset()
@@ -152,6 +206,9 @@ void CNarcissisticNumbers::slotReset()
 
 void CNarcissisticNumbers::slotRun()
 {
+    if ( !validateRanges() )
+        return;
+
     fCalculator.reset( nullptr );
     fNumPartitions = 0;
     fFinishedCount = 0;
@@ -160,12 +217,7 @@ void CNarcissisticNumbers::slotRun()
     fCalculator.reset( new CNarcissisticNumCalculator( false ) );
 
     fCalculator->init();
-    fCalculator->setBase( fImpl->base->value() );
-    fCalculator->setNumThreads( fImpl->numThreads->value() );
-    fCalculator->setNumPerThread( fImpl->numPerThread->value() );
-    fCalculator->setByRange( fImpl->byRange->isChecked() );
-    fCalculator->setRange( std::make_pair( fImpl->minRange->value(), fImpl->maxRange->value() ) );
-    fCalculator->setNumbersList( getNumbersList() );
+    configure( fCalculator.get() );
 
     slotShowResults();
     if ( !fProgress )
@@ -225,6 +277,55 @@ void CNarcissisticNumbers::slotRun()
     }
 }
 
+void CNarcissisticNumbers::configure( CNarcissisticNumCalculator* calculator ) const
+{
+    calculator->setBase( fImpl->base->value() );
+    calculator->setNumThreads( fImpl->numThreads->value() );
+    calculator->setNumPerThread( fImpl->numPerThread->value() );
+    calculator->setEngine( fImpl->engine->currentText().toStdString() );
+    calculator->setRange( std::make_pair( fImpl->minRange->value(), fImpl->maxRange->value() ) ); // clears the ranges, so first
+    std::list< std::pair< uint64_t, uint64_t > > ranges;
+    if ( fImpl->byRanges->isChecked() )
+        getRangesList( ranges );
+    calculator->setRanges( ranges ); // selects range mode
+    calculator->setByRange( !fImpl->byNumbers->isChecked() );
+    calculator->setNumbersList( getNumbersList() );
+}
+
+void CNarcissisticNumbers::slotEstimate()
+{
+    if ( !validateRanges() )
+        return;
+
+    // a dry run takes well under a second, even for the full range in base 2
+    QApplication::setOverrideCursor( Qt::WaitCursor );
+    CNarcissisticNumCalculator calculator( false );
+    configure( &calculator );
+    auto estimate = calculator.estimate();
+    QApplication::restoreOverrideCursor();
+
+    fImpl->results->setText( QString::fromStdString( estimate.toString() ) );
+}
+
+void CNarcissisticNumbers::slotNumThreadsChanged()
+{
+    // applied live, the retired threads finish their current partition first
+    if ( fCalculator && !fCalculator->isFinished( nullptr ) )
+        fCalculator->setNumThreads( fImpl->numThreads->value() );
+}
+
+void CNarcissisticNumbers::slotPause()
+{
+    if ( !fCalculator )
+        return;
+
+    if ( fCalculator->isPaused() )
+        fCalculator->resume();
+    else
+        fCalculator->pause();
+    fImpl->pause->setText( fCalculator->isPaused() ? tr( "Resume" ) : tr( "Pause" ) );
+}
+
 void CNarcissisticNumbers::slotShowResults()
 {
     std::string results;
@@ -269,16 +370,23 @@ void CNarcissisticNumbers::slotShowResults()
 void CNarcissisticNumbers::updateUI( bool finished )
 {
     fImpl->base->setEnabled( finished );
-    fImpl->numThreads->setEnabled( finished );
     fImpl->numPerThread->setEnabled( finished );
+    fImpl->engine->setEnabled( finished );
     fImpl->byRange->setEnabled( finished );
     fImpl->byNumbers->setEnabled( finished );
+    fImpl->byRanges->setEnabled( finished );
     fImpl->minRange->setEnabled( finished );
     fImpl->maxRange->setEnabled( finished );
     fImpl->numList->setEnabled( finished );
+    fImpl->rangeList->setEnabled( finished );
     fImpl->run->setEnabled( finished );
+    fImpl->estimate->setEnabled( finished );
+    fImpl->pause->setEnabled( !finished );
     if ( finished )
+    {
+        fImpl->pause->setText( tr( "Pause" ) );
         slotChanged();
+    }
 }
 
 
@@ -303,4 +411,5 @@ void CNarcissisticNumbers::slotSetToMax()
 {
     fImpl->minRange->setValue( 0 );
     fImpl->maxRange->setValue( CSpinBox64U::maxAllowed() );
+    slotEstimate(); // the full range can take centuries
 }
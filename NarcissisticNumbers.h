@@ -54,10 +54,17 @@ public slots:
     void slotShowResults();
     void slotRangeChanged();
     void slotSetToMax();
+    void slotPause();
+    void slotEstimate();
+    void slotNumThreadsChanged();
 private:
     void updateUI( bool finished );
+    void configure( CNarcissisticNumCalculator* calculator ) const;
     void setNumbersList( const std::list< uint64_t >& numbers );
     std::list< uint64_t > getNumbersList() const;
+    // false, with the reason, when the text is not a list of ranges
+    bool getRangesList( std::list< std::pair< uint64_t, uint64_t > >& ranges, QString* errorMsg = nullptr ) const;
+    bool validateRanges();
 
     void loadSettings();
     void saveSettings() const;
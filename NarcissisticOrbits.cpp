@@ -0,0 +1,143 @@
+// The MIT License( MIT )
+//
+// Copyright( c ) 2020 Scott Aron Bloom
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sub-license, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "NarcissisticOrbits.h"
+#include "NarcissisticEngine.h"
+
+#include <algorithm>
+#include <limits>
+
+uint64_t CNarcissisticOrbits::domainSize( int base, int power )
+{
+    // m digit values map to at most m * (b-1)^k, once that is below b^(m-1) every value
+    // with m or more digits maps to a smaller value
+    auto maxDigitPower = CNarcissisticEngine::powerSat( base - 1, power );
+    for ( uint64_t m = 1; m <= 64; ++m )
+    {
+        auto firstValue = CNarcissisticEngine::powerSat( base, m - 1 );
+        if ( firstValue == std::numeric_limits< uint64_t >::max() )
+            return 0;
+        if ( CNarcissisticEngine::mulSat( m, maxDigitPower ) < firstValue )
+            return std::max( firstValue, CNarcissisticEngine::addSat( CNarcissisticEngine::mulSat( m - 1, maxDigitPower ), 1 ) );
+    }
+    return 0;
+}
+
+bool CNarcissisticOrbits::supported( int base, int power )
+{
+    auto domain = domainSize( base, power );
+    return domain && ( domain <= kMaxDomain );
+}
+
+CNarcissisticOrbits::CNarcissisticOrbits( int base, int power ) :
+    fBase( base ),
+    fPower( power ),
+    fDomain( domainSize( base, power ) )
+{
+    for ( int digit = 0; digit < fBase; ++digit )
+        fDigitPowers.push_back( CNarcissisticEngine::powerSat( digit, power ) );
+
+    fMemo.reset( new std::atomic< uint32_t >[ fDomain ] );
+    for ( uint64_t ii = 0; ii < fDomain; ++ii )
+        fMemo[ ii ].store( 0, std::memory_order_relaxed );
+}
+
+uint64_t CNarcissisticOrbits::digitPowerSum( uint64_t value ) const
+{
+    uint64_t sum = 0;
+    for ( auto curr = value; curr; curr /= fBase )
+        sum = CNarcissisticEngine::addSat( sum, fDigitPowers[ curr % fBase ] );
+    return sum;
+}
+
+uint32_t CNarcissisticOrbits::memoValue( uint32_t steps, uint32_t cycle )
+{
+    return ( ( cycle + 1 ) << 16 ) | steps;
+}
+
+void CNarcissisticOrbits::memoize( uint64_t value, uint32_t steps, uint32_t cycle )
+{
+    // values with too long a tail are resolved again when met, which is correct just slower
+    if ( ( steps <= kMaxMemoSteps ) && ( cycle <= kMaxMemoCycles ) )
+        fMemo[ value ].store( memoValue( steps, cycle ), std::memory_order_release );
+}
+
+std::pair< uint32_t, uint32_t > CNarcissisticOrbits::resolve( uint64_t value )
+{
+    // above the domain F is decreasing, so the walk gets into the domain without ever being in a cycle
+    uint32_t outsideSteps = 0;
+    for ( ; value >= fDomain; ++outsideSteps )
+        value = digitPowerSum( value );
+
+    // walk until a memoized value or a repeat, the chain is only memoized once fully resolved
+    std::vector< uint64_t > path;
+    uint32_t steps = 0;
+    uint32_t cycle = 0;
+    for ( auto curr = value; ; curr = digitPowerSum( curr ) )
+    {
+        auto memo = fMemo[ curr ].load( std::memory_order_acquire );
+        if ( memo )
+        {
+            steps = memo & 0xFFFF;
+            cycle = ( memo >> 16 ) - 1;
+            break;
+        }
+
+        auto pos = std::find( path.begin(), path.end(), curr );
+        if ( pos != path.end() )
+        {
+            cycle = addCycle( std::vector< uint64_t >( pos, path.end() ) );
+            for ( auto ii = pos; ii != path.end(); ++ii )
+                memoize( *ii, 0, cycle );
+            path.erase( pos, path.end() );
+            steps = 0;
+            break;
+        }
+        path.push_back( curr );
+    }
+
+    for ( auto ii = path.rbegin(); ii != path.rend(); ++ii )
+        memoize( *ii, ++steps, cycle );
+    return std::make_pair( steps + outsideSteps, cycle );
+}
+
+uint32_t CNarcissisticOrbits::addCycle( std::vector< uint64_t > members )
+{
+    std::rotate( members.begin(), std::min_element( members.begin(), members.end() ), members.end() );
+
+    std::unique_lock< std::mutex > lock( fMutex );
+    auto pos = fCycleIndex.find( members.front() );
+    if ( pos != fCycleIndex.end() )
+        return ( *pos ).second;
+
+    auto retVal = static_cast< uint32_t >( fCycles.size() );
+    fCycleIndex[ members.front() ] = retVal;
+    fCycles.push_back( std::move( members ) );
+    return retVal;
+}
+
+std::vector< std::vector< uint64_t > > CNarcissisticOrbits::cycles() const
+{
+    std::unique_lock< std::mutex > lock( fMutex );
+    return fCycles;
+}
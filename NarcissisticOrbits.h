@@ -0,0 +1,82 @@
+// The MIT License( MIT )
+//
+// Copyright( c ) 2020 Scott Aron Bloom
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sub-license, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#ifndef __NARCISSISTICORBITS_H
+#define __NARCISSISTICORBITS_H
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+// Orbits of the digit power map F(n) = sum of d_i^k for a fixed power k
+// F maps [0:domainSize) into itself, and every n above it to a smaller value, so every orbit ends in
+// a cycle inside the domain. The resolved orbits are memoized in a dense table over the domain that
+// the workers share without a lock, only a newly found cycle takes the mutex
+// The fixed points with k digits are the narcissistic numbers of length k
+class CNarcissisticOrbits
+{
+public:
+    static const uint64_t kMaxDomain{ 1ULL << 25 }; // 128MB of memo
+
+    // 0 when the domain does not fit in 64 bits
+    static uint64_t domainSize( int base, int power );
+    // the domain is bounded and its memo fits, the calculator refuses to run otherwise
+    static bool supported( int base, int power );
+
+    CNarcissisticOrbits( int base, int power );
+
+    int base() const { return fBase; }
+    int power() const { return fPower; }
+    uint64_t domain() const { return fDomain; }
+
+    uint64_t digitPowerSum( uint64_t value ) const;
+
+    // the steps from value to the first member of its cycle, and the index of the cycle
+    // thread safe, every value on a resolved chain in the domain is memoized
+    std::pair< uint32_t, uint32_t > resolve( uint64_t value );
+
+    // each cycle starts from its smallest member, in the order they were found
+    std::vector< std::vector< uint64_t > > cycles() const;
+private:
+    static const uint32_t kMaxMemoSteps{ 0xFFFF };
+    static const uint32_t kMaxMemoCycles{ 0xFFFE };
+    static uint32_t memoValue( uint32_t steps, uint32_t cycle );
+
+    uint32_t addCycle( std::vector< uint64_t > members );
+    void memoize( uint64_t value, uint32_t steps, uint32_t cycle );
+
+    int fBase{ 10 };
+    int fPower{ 1 };
+    uint64_t fDomain{ 0 };
+    std::vector< uint64_t > fDigitPowers; // fDigitPowers[ d ] = d^k
+    std::unique_ptr< std::atomic< uint32_t >[] > fMemo; // ( cycle + 1 ) << 16 | steps, 0 when unresolved
+
+    mutable std::mutex fMutex;
+    std::vector< std::vector< uint64_t > > fCycles;
+    std::map< uint64_t, uint32_t > fCycleIndex; // smallest member to index in fCycles
+};
+#endif
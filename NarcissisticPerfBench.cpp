@@ -0,0 +1,512 @@
+// The MIT License( MIT )
+//
+// Copyright( c ) 2020 Scott Aron Bloom
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sub-license, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+// Benchmark harness reporting hardware counters for calculator runs or single engines
+//
+// Usage: NarcissisticPerfBench [-mode calculator|kernel] [-engine <name>[,<name>...]] [-base <b>] [-min <n>] [-max <n>]
+//                              [-num_threads <n>[,<n>...]] [-num_per_thread <n>] [-repeat <n>] [-format csv|json] [-out <file>]
+//                              [-rank seconds|joules]
+//
+// calculator mode runs the full calculator on the shared thread pool (index and known table disabled),
+// the counters of each pool worker are only enabled while it runs a partition.
+// kernel mode splits the range evenly over its own threads, each calling the engine directly.
+//
+// One row is reported per thread plus a total row, per candidate values are reported whenever the
+// number of candidates a thread checked is known.  Counters that can not be opened are reported
+// empty (csv) or null (json), the wall time is always reported.
+//
+// A list of engines or thread counts sweeps every combination.  The total rows carry the package energy
+// from RAPL (joules, per million candidates and average watts) when the powercap counters are readable,
+// -rank prints the combinations ordered by the median seconds or joules to stderr.
+
+#include "NarcissisticNumCalculator.h"
+#include "NarcissisticEngine.h"
+#include "NarcissisticPerfCounters.h"
+#include "NarcissisticEnergy.h"
+#include "NarcissisticThreadPool.h"
+
+#include <QCoreApplication>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+namespace
+{
+    struct SResult
+    {
+        int fRun{ 0 };
+        std::string fEngine; // resolved
+        int fNumThreads{ 0 };
+        std::string fThread;
+        uint64_t fCandidates{ 0 }; // 0 when not known
+        double fSeconds{ 0.0 };
+        CNarcissisticPerfCounters::SCounts fCounts;
+        double fJoules{ -1.0 }; // total rows only, negative when not known
+    };
+
+    class CBenchmark
+    {
+    public:
+        bool parse( int argc, char** argv )
+        {
+            for ( int ii = 1; ii < argc; ++ii )
+            {
+                auto hasValue = ( ii + 1 ) < argc;
+                if ( hasValue && ( strcmp( argv[ ii ], "-mode" ) == 0 ) )
+                    fMode = argv[ ++ii ];
+                else if ( hasValue && ( strcmp( argv[ ii ], "-engine" ) == 0 ) )
+                    fEngines = split( argv[ ++ii ] );
+                else if ( hasValue && ( strcmp( argv[ ii ], "-base" ) == 0 ) )
+                    fBase = std::min( 36, std::max( 2, atoi( argv[ ++ii ] ) ) );
+                else if ( hasValue && ( strcmp( argv[ ii ], "-min" ) == 0 ) )
+                    fMin = std::stoull( argv[ ++ii ] );
+                else if ( hasValue && ( strcmp( argv[ ii ], "-max" ) == 0 ) )
+                    fMax = std::stoull( argv[ ++ii ] );
+                else if ( hasValue && ( strcmp( argv[ ii ], "-num_threads" ) == 0 ) )
+                {
+                    fNumThreads.clear();
+                    for ( auto&& jj : split( argv[ ++ii ] ) )
+                        fNumThreads.push_back( std::max( 1, atoi( jj.c_str() ) ) );
+                }
+                else if ( hasValue && ( strcmp( argv[ ii ], "-num_per_thread" ) == 0 ) )
+                    fNumPerThread = std::max< uint64_t >( 1, std::stoull( argv[ ++ii ] ) );
+                else if ( hasValue && ( strcmp( argv[ ii ], "-repeat" ) == 0 ) )
+                    fRepeat = std::max( 1, atoi( argv[ ++ii ] ) );
+                else if ( hasValue && ( strcmp( argv[ ii ], "-format" ) == 0 ) )
+                    fFormat = argv[ ++ii ];
+                else if ( hasValue && ( strcmp( argv[ ii ], "-out" ) == 0 ) )
+                    fOutFile = argv[ ++ii ];
+                else if ( hasValue && ( strcmp( argv[ ii ], "-rank" ) == 0 ) )
+                    fRank = argv[ ++ii ];
+                else
+                {
+                    std::cerr << "unknown switch: '" << argv[ ii ] << "'\n";
+                    return false;
+                }
+            }
+            if ( ( fMode != "calculator" ) && ( fMode != "kernel" ) )
+            {
+                std::cerr << "-mode must be calculator or kernel\n";
+                return false;
+            }
+            if ( ( fFormat != "csv" ) && ( fFormat != "json" ) )
+            {
+                std::cerr << "-format must be csv or json\n";
+                return false;
+            }
+            if ( !fRank.empty() && ( fRank != "seconds" ) && ( fRank != "joules" ) )
+            {
+                std::cerr << "-rank must be seconds or joules\n";
+                return false;
+            }
+            if ( fEngines.empty() || fNumThreads.empty() )
+            {
+                std::cerr << "-engine and -num_threads need at least one value\n";
+                return false;
+            }
+            for ( auto&& ii : fEngines )
+            {
+                if ( !CNarcissisticEngineRegistry::instance().hasEngine( ii ) )
+                {
+                    std::cerr << "unknown engine: '" << ii << "'\n";
+                    return false;
+                }
+            }
+            if ( fMax <= fMin )
+            {
+                std::cerr << "-max must be greater than -min\n";
+                return false;
+            }
+            return true;
+        }
+
+        int run()
+        {
+            {
+                CNarcissisticPerfCounters probe;
+                if ( !probe.anyAvailable() || !probe.errorMsg().empty() )
+                    std::cerr << "Warning: not all performance counters are available - " << probe.errorMsg() << "\n";
+                CNarcissisticEnergy energy;
+                if ( !energy.available() )
+                    std::cerr << "Warning: energy is not available - " << energy.errorMsg() << "\n";
+            }
+
+            for ( auto&& engine : fEngines )
+            {
+                for ( auto&& numThreads : fNumThreads )
+                {
+                    for ( int ii = 0; ii < fRepeat; ++ii )
+                    {
+                        if ( fMode == "kernel" )
+                            runKernel( ii, engine, numThreads );
+                        else
+                            runCalculator( ii, engine, numThreads );
+                    }
+                }
+            }
+            if ( !fRank.empty() )
+                rank();
+
+            if ( fOutFile.empty() )
+            {
+                write( std::cout );
+                return 0;
+            }
+
+            std::ofstream oss( fOutFile );
+            if ( !oss )
+            {
+                std::cerr << "Could not open '" << fOutFile << "' for writing\n";
+                return 1;
+            }
+            write( oss );
+            return 0;
+        }
+    private:
+        static std::vector< std::string > split( const std::string& value )
+        {
+            std::vector< std::string > retVal;
+            std::istringstream iss( value );
+            std::string curr;
+            while ( std::getline( iss, curr, ',' ) )
+            {
+                if ( !curr.empty() )
+                    retVal.push_back( curr );
+            }
+            return retVal;
+        }
+
+        void runKernel( int run, const std::string& engineName, int numThreads )
+        {
+            auto engine = CNarcissisticEngineRegistry::instance().create( engineName, fBase, CNarcissisticEngine::computeNumDigits( fMax - 1, fBase ) );
+
+            std::vector< SResult > results( numThreads );
+            auto numPerThread = ( fMax - fMin ) / numThreads;
+            CNarcissisticEnergy energy;
+            auto start = std::chrono::steady_clock::now();
+            std::vector< std::thread > threads;
+            for ( int ii = 0; ii < numThreads; ++ii )
+            {
+                auto min = fMin + ii * numPerThread;
+                auto max = ( ii == ( numThreads - 1 ) ) ? fMax : ( min + numPerThread );
+                threads.emplace_back(
+                    [ engine, min, max, &result = results[ ii ] ]()
+                    {
+                        CNarcissisticPerfCounters counters;
+                        uint64_t numFound = 0;
+                        auto start = std::chrono::steady_clock::now();
+                        counters.start();
+                        engine->findInRange( min, max, [ &numFound ]( uint64_t ) { numFound++; }, []( uint64_t ) { return true; } );
+                        counters.stop();
+                        result.fSeconds = std::chrono::duration< double >( std::chrono::steady_clock::now() - start ).count();
+                        result.fCounts = counters.read();
+                        result.fCandidates = max - min;
+                    } );
+            }
+            for ( auto&& ii : threads )
+                ii.join();
+            auto seconds = std::chrono::duration< double >( std::chrono::steady_clock::now() - start ).count();
+            energy.sample(); // a single sample, the counters wrap only after many minutes at full load
+
+            addResults( run, engine->name(), numThreads, results, seconds, energy );
+        }
+
+        void runCalculator( int run, const std::string& engineName, int numThreads )
+        {
+            std::mutex mutex;
+            std::map< size_t, std::pair< std::unique_ptr< CNarcissisticPerfCounters >, std::chrono::steady_clock::duration > > workers;
+            std::map< size_t, std::chrono::steady_clock::time_point > started;
+
+            // the counters must be opened on the worker they measure
+            auto&& pool = CNarcissisticThreadPool::instance();
+            pool.setPartitionObserver(
+                [ &mutex, &workers, &started ]( size_t workerNum, bool starting )
+                {
+                    std::unique_lock< std::mutex > lock( mutex );
+                    auto&& worker = workers[ workerNum ];
+                    if ( !worker.first )
+                        worker.first = std::make_unique< CNarcissisticPerfCounters >();
+                    if ( starting )
+                    {
+                        started[ workerNum ] = std::chrono::steady_clock::now();
+                        worker.first->start();
+                    }
+                    else
+                    {
+                        worker.first->stop();
+                        worker.second += std::chrono::steady_clock::now() - started[ workerNum ];
+                    }
+                } );
+
+            double seconds = 0.0;
+            std::string resolvedEngine;
+            CNarcissisticEnergy energy;
+            {
+                CNarcissisticNumCalculator calculator( false );
+                calculator.setBase( fBase );
+                calculator.setNumThreads( numThreads );
+                calculator.setNumPerThread( fNumPerThread );
+                calculator.setByRange( true );
+                calculator.setRange( std::make_pair( fMin, fMax ) );
+                calculator.setEngine( engineName );
+                calculator.setUseIndex( false );
+                calculator.setUseKnownTable( false );
+                seconds = std::chrono::duration< double >( calculator.run() ).count();
+                resolvedEngine = calculator.engineName();
+                energy = calculator.energy(); // sampled while the calculator polled for the finish
+            }
+            pool.setPartitionObserver( CNarcissisticThreadPool::TPartitionObserver() );
+
+            std::vector< SResult > results;
+            for ( auto&& ii : workers )
+            {
+                SResult result;
+                result.fThread = "worker" + std::to_string( ii.first );
+                result.fSeconds = std::chrono::duration< double >( ii.second.second ).count();
+                result.fCounts = ii.second.first->read();
+                results.push_back( result );
+            }
+            addResults( run, resolvedEngine, numThreads, results, seconds, energy );
+        }
+
+        void addResults( int run, const std::string& engine, int numThreads, std::vector< SResult >& results, double seconds, const CNarcissisticEnergy& energy )
+        {
+            SResult total;
+            total.fRun = run;
+            total.fEngine = engine;
+            total.fNumThreads = numThreads;
+            total.fThread = "total";
+            total.fCandidates = fMax - fMin;
+            total.fSeconds = seconds;
+            if ( energy.available() )
+                total.fJoules = energy.joules();
+            for ( size_t ii = 0; ii < results.size(); ++ii )
+            {
+                results[ ii ].fRun = run;
+                results[ ii ].fEngine = engine;
+                results[ ii ].fNumThreads = numThreads;
+                if ( results[ ii ].fThread.empty() )
+                    results[ ii ].fThread = "thread" + std::to_string( ii );
+                total.fCounts += results[ ii ].fCounts;
+                fResults.push_back( results[ ii ] );
+            }
+            fResults.push_back( total );
+        }
+
+        // the median of the total rows of each engine and thread count, best first
+        void rank() const
+        {
+            struct SConfig
+            {
+                std::vector< double > fSeconds;
+                std::vector< double > fJoules;
+            };
+            std::map< std::pair< std::string, int >, SConfig > configs;
+            bool hasEnergy = true;
+            for ( auto&& ii : fResults )
+            {
+                if ( ii.fThread != "total" )
+                    continue;
+                auto&& config = configs[ std::make_pair( ii.fEngine, ii.fNumThreads ) ];
+                config.fSeconds.push_back( ii.fSeconds );
+                if ( ii.fJoules < 0 )
+                    hasEnergy = false;
+                else
+                    config.fJoules.push_back( ii.fJoules );
+            }
+
+            auto byJoules = ( fRank == "joules" );
+            if ( byJoules && !hasEnergy )
+            {
+                std::cerr << "Energy is not available, ranking by seconds\n";
+                byJoules = false;
+            }
+
+            auto median = []( std::vector< double > values )
+            {
+                if ( values.empty() )
+                    return -1.0;
+                std::sort( values.begin(), values.end() );
+                return values[ values.size() / 2 ];
+            };
+            std::vector< std::tuple< double, double, std::string, int > > ranked; // seconds, joules, engine, threads
+            for ( auto&& ii : configs )
+                ranked.emplace_back( median( ii.second.fSeconds ), median( ii.second.fJoules ), ii.first.first, ii.first.second );
+            std::stable_sort( ranked.begin(), ranked.end(),
+                [ byJoules ]( const auto& lhs, const auto& rhs )
+                {
+                    return byJoules ? ( std::get< 1 >( lhs ) < std::get< 1 >( rhs ) ) : ( std::get< 0 >( lhs ) < std::get< 0 >( rhs ) );
+                } );
+
+            auto numCandidates = static_cast< double >( fMax - fMin );
+            std::cerr << "Ranked by " << ( byJoules ? "joules" : "seconds" ) << " (median of " << fRepeat << " run" << ( fRepeat == 1 ? "" : "s" ) << "):\n";
+            int pos = 1;
+            for ( auto&& ii : ranked )
+            {
+                std::cerr << std::setw( 3 ) << pos++ << ". " << std::get< 2 >( ii ) << " - " << std::get< 3 >( ii ) << " threads - " << std::get< 0 >( ii ) << " s";
+                if ( std::get< 1 >( ii ) >= 0 )
+                {
+                    std::cerr << " - " << std::get< 1 >( ii ) << " J - " << std::get< 1 >( ii ) * 1e6 / numCandidates << " J/M candidates";
+                    if ( std::get< 0 >( ii ) > 0 )
+                        std::cerr << " - " << std::get< 1 >( ii ) / std::get< 0 >( ii ) << " W";
+                }
+                std::cerr << "\n";
+            }
+        }
+
+        std::list< std::pair< std::string, std::string > > columns( const SResult& result ) const
+        {
+            std::list< std::pair< std::string, std::string > > retVal;
+            auto&& values = result.fCounts.fValues;
+            auto&& valid = result.fCounts.fValid;
+            auto format = []( double value )
+            {
+                std::ostringstream oss;
+                oss << value;
+                return oss.str();
+            };
+
+            retVal.emplace_back( "mode", fMode );
+            retVal.emplace_back( "engine", result.fEngine );
+            retVal.emplace_back( "base", std::to_string( fBase ) );
+            retVal.emplace_back( "min", std::to_string( fMin ) );
+            retVal.emplace_back( "max", std::to_string( fMax ) );
+            retVal.emplace_back( "num_threads", std::to_string( result.fNumThreads ) );
+            retVal.emplace_back( "run", std::to_string( result.fRun ) );
+            retVal.emplace_back( "thread", result.fThread );
+            retVal.emplace_back( "candidates", result.fCandidates ? std::to_string( result.fCandidates ) : std::string() );
+            retVal.emplace_back( "seconds", format( result.fSeconds ) );
+            for ( int ii = 0; ii < CNarcissisticPerfCounters::eNumCounters; ++ii )
+                retVal.emplace_back( CNarcissisticPerfCounters::counterName( static_cast< CNarcissisticPerfCounters::ECounter >( ii ) ), valid[ ii ] ? std::to_string( values[ ii ] ) : std::string() );
+
+            auto hasIPC = valid[ CNarcissisticPerfCounters::eCycles ] && valid[ CNarcissisticPerfCounters::eInstructions ] && values[ CNarcissisticPerfCounters::eCycles ];
+            retVal.emplace_back( "ipc", hasIPC ? format( static_cast< double >( values[ CNarcissisticPerfCounters::eInstructions ] ) / values[ CNarcissisticPerfCounters::eCycles ] ) : std::string() );
+            for ( int ii = 0; ii < CNarcissisticPerfCounters::eNumCounters; ++ii )
+            {
+                auto name = std::string( CNarcissisticPerfCounters::counterName( static_cast< CNarcissisticPerfCounters::ECounter >( ii ) ) ) + "_per_candidate";
+                auto hasValue = valid[ ii ] && result.fCandidates;
+                retVal.emplace_back( name, hasValue ? format( static_cast< double >( values[ ii ] ) / result.fCandidates ) : std::string() );
+            }
+            auto hasJoules = ( result.fJoules >= 0 );
+            retVal.emplace_back( "joules", hasJoules ? format( result.fJoules ) : std::string() );
+            retVal.emplace_back( "joules_per_mcandidate", ( hasJoules && result.fCandidates ) ? format( result.fJoules * 1e6 / result.fCandidates ) : std::string() );
+            retVal.emplace_back( "watts", ( hasJoules && ( result.fSeconds > 0 ) ) ? format( result.fJoules / result.fSeconds ) : std::string() );
+            return retVal;
+        }
+
+        void write( std::ostream& oss ) const
+        {
+            if ( fFormat == "csv" )
+            {
+                bool first = true;
+                for ( auto&& ii : fResults )
+                {
+                    auto cols = columns( ii );
+                    if ( first )
+                    {
+                        std::string sep;
+                        for ( auto&& jj : cols )
+                        {
+                            oss << sep << jj.first;
+                            sep = ",";
+                        }
+                        oss << "\n";
+                        first = false;
+                    }
+                    std::string sep;
+                    for ( auto&& jj : cols )
+                    {
+                        oss << sep << jj.second;
+                        sep = ",";
+                    }
+                    oss << "\n";
+                }
+                return;
+            }
+
+            // the string columns never need escaping, they are engine names and fixed words
+            const std::set< std::string > stringColumns = { "mode", "engine", "thread" };
+            oss << "[\n";
+            std::string rowSep;
+            for ( auto&& ii : fResults )
+            {
+                oss << rowSep << "    { ";
+                std::string sep;
+                for ( auto&& jj : columns( ii ) )
+                {
+                    oss << sep << "\"" << jj.first << "\": ";
+                    if ( stringColumns.find( jj.first ) != stringColumns.end() )
+                        oss << "\"" << jj.second << "\"";
+                    else if ( jj.second.empty() )
+                        oss << "null";
+                    else
+                        oss << jj.second;
+                    sep = ", ";
+                }
+                oss << " }";
+                rowSep = ",\n";
+            }
+            oss << "\n]\n";
+        }
+
+        std::string fMode{ "calculator" };
+        std::vector< std::string > fEngines{ "auto" };
+        int fBase{ 10 };
+        uint64_t fMin{ 0 };
+        uint64_t fMax{ 10000000 };
+        std::vector< int > fNumThreads{ static_cast< int >( std::max( 1U, std::thread::hardware_concurrency() ) ) };
+        uint64_t fNumPerThread{ 100000 };
+        int fRepeat{ 1 };
+        std::string fFormat{ "csv" };
+        std::string fOutFile;
+        std::string fRank;
+        std::list< SResult > fResults;
+    };
+}
+
+int main( int argc, char** argv )
+{
+    QCoreApplication appl( argc, argv ); // the calculator reads its defaults via QSettings
+    appl.setOrganizationDomain( "http://towel42.com" );
+    appl.setOrganizationName( "Scott Aron Bloom" );
+    appl.setApplicationName( "Narcissistic Number Calculator" );
+
+    CBenchmark benchmark;
+    if ( !benchmark.parse( argc, argv ) )
+        return 1;
+    return benchmark.run();
+}
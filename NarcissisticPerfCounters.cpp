@@ -0,0 +1,186 @@
+// The MIT License( MIT )
+//
+// Copyright( c ) 2020 Scott Aron Bloom
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sub-license, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "NarcissisticPerfCounters.h"
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#endif
+
+const char* CNarcissisticPerfCounters::counterName( ECounter counter )
+{
+    switch ( counter )
+    {
+        case eCycles: return "cycles";
+        case eInstructions: return "instructions";
+        case eBranchMisses: return "branch_misses";
+        case eL1DMisses: return "l1d_misses";
+        case eLLCMisses: return "llc_misses";
+        case eContextSwitches: return "context_switches";
+        default: return "";
+    }
+}
+
+CNarcissisticPerfCounters::SCounts& CNarcissisticPerfCounters::SCounts::operator+=( const SCounts& rhs )
+{
+    for ( size_t ii = 0; ii < eNumCounters; ++ii )
+    {
+        fValues[ ii ] += rhs.fValues[ ii ];
+        fValid[ ii ] = fValid[ ii ] || rhs.fValid[ ii ];
+    }
+    return *this;
+}
+
+#ifdef __linux__
+namespace
+{
+    void setupAttr( CNarcissisticPerfCounters::ECounter counter, perf_event_attr& attr )
+    {
+        memset( &attr, 0, sizeof( attr ) );
+        attr.size = sizeof( attr );
+        attr.type = PERF_TYPE_HARDWARE;
+        switch ( counter )
+        {
+            case CNarcissisticPerfCounters::eCycles:
+                attr.config = PERF_COUNT_HW_CPU_CYCLES;
+                break;
+            case CNarcissisticPerfCounters::eInstructions:
+                attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+                break;
+            case CNarcissisticPerfCounters::eBranchMisses:
+                attr.config = PERF_COUNT_HW_BRANCH_MISSES;
+                break;
+            case CNarcissisticPerfCounters::eL1DMisses:
+                attr.type = PERF_TYPE_HW_CACHE;
+                attr.config = PERF_COUNT_HW_CACHE_L1D | ( PERF_COUNT_HW_CACHE_OP_READ << 8 ) | ( PERF_COUNT_HW_CACHE_RESULT_MISS << 16 );
+                break;
+            case CNarcissisticPerfCounters::eLLCMisses:
+                attr.type = PERF_TYPE_HW_CACHE;
+                attr.config = PERF_COUNT_HW_CACHE_LL | ( PERF_COUNT_HW_CACHE_OP_READ << 8 ) | ( PERF_COUNT_HW_CACHE_RESULT_MISS << 16 );
+                break;
+            case CNarcissisticPerfCounters::eContextSwitches:
+                attr.type = PERF_TYPE_SOFTWARE;
+                attr.config = PERF_COUNT_SW_CONTEXT_SWITCHES;
+                break;
+            default:
+                break;
+        }
+        attr.disabled = 1;
+        attr.exclude_kernel = 1; // allowed with perf_event_paranoid <= 2
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    }
+}
+#endif
+
+CNarcissisticPerfCounters::CNarcissisticPerfCounters()
+{
+    fFDs.fill( -1 );
+#ifdef __linux__
+    for ( int ii = 0; ii < eNumCounters; ++ii )
+    {
+        perf_event_attr attr;
+        setupAttr( static_cast< ECounter >( ii ), attr );
+        fFDs[ ii ] = static_cast< int >( syscall( __NR_perf_event_open, &attr, 0, -1, -1, 0 ) ); // this thread, any cpu
+        if ( ( fFDs[ ii ] < 0 ) && fErrorMsg.empty() )
+        {
+            fErrorMsg = std::string( counterName( static_cast< ECounter >( ii ) ) ) + ": " + strerror( errno );
+            if ( ( errno == EACCES ) || ( errno == EPERM ) )
+                fErrorMsg += " (see /proc/sys/kernel/perf_event_paranoid)";
+        }
+    }
+#else
+    fErrorMsg = "performance counters are only supported on linux";
+#endif
+}
+
+CNarcissisticPerfCounters::~CNarcissisticPerfCounters()
+{
+#ifdef __linux__
+    for ( auto&& ii : fFDs )
+    {
+        if ( ii >= 0 )
+            close( ii );
+    }
+#endif
+}
+
+bool CNarcissisticPerfCounters::anyAvailable() const
+{
+    for ( auto&& ii : fFDs )
+    {
+        if ( ii >= 0 )
+            return true;
+    }
+    return false;
+}
+
+void CNarcissisticPerfCounters::start()
+{
+#ifdef __linux__
+    for ( auto&& ii : fFDs )
+    {
+        if ( ii >= 0 )
+            ioctl( ii, PERF_EVENT_IOC_ENABLE, 0 );
+    }
+#endif
+}
+
+void CNarcissisticPerfCounters::stop()
+{
+#ifdef __linux__
+    for ( auto&& ii : fFDs )
+    {
+        if ( ii >= 0 )
+            ioctl( ii, PERF_EVENT_IOC_DISABLE, 0 );
+    }
+#endif
+}
+
+CNarcissisticPerfCounters::SCounts CNarcissisticPerfCounters::read() const
+{
+    SCounts retVal;
+#ifdef __linux__
+    for ( int ii = 0; ii < eNumCounters; ++ii )
+    {
+        if ( fFDs[ ii ] < 0 )
+            continue;
+
+        uint64_t values[ 3 ] = { 0, 0, 0 }; // value, time enabled, time running
+        if ( ::read( fFDs[ ii ], values, sizeof( values ) ) != sizeof( values ) )
+            continue;
+
+        auto value = values[ 0 ];
+        if ( ( values[ 2 ] != 0 ) && ( values[ 2 ] < values[ 1 ] ) )
+            value = static_cast< uint64_t >( static_cast< double >( value ) * values[ 1 ] / values[ 2 ] );
+        retVal.fValues[ ii ] = value;
+        retVal.fValid[ ii ] = true;
+    }
+#endif
+    return retVal;
+}
@@ -0,0 +1,77 @@
+// The MIT License( MIT )
+//
+// Copyright( c ) 2020 Scott Aron Bloom
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sub-license, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#ifndef __NARCISSISTICPERFCOUNTERS_H
+#define __NARCISSISTICPERFCOUNTERS_H
+
+#include <array>
+#include <cstdint>
+#include <string>
+
+// Hardware and software counters for the thread that created the object, via perf_event_open on linux
+// Every counter is opened on its own, so a counter the kernel (or perf_event_paranoid) refuses only
+// loses that counter. On other platforms nothing is available.
+class CNarcissisticPerfCounters
+{
+public:
+    enum ECounter
+    {
+        eCycles,
+        eInstructions,
+        eBranchMisses,
+        eL1DMisses,
+        eLLCMisses,
+        eContextSwitches,
+        eNumCounters
+    };
+    static const char* counterName( ECounter counter );
+
+    struct SCounts
+    {
+        std::array< uint64_t, eNumCounters > fValues{};
+        std::array< bool, eNumCounters > fValid{};
+
+        SCounts& operator+=( const SCounts& rhs );
+    };
+
+    CNarcissisticPerfCounters(); // the counters are created stopped
+    ~CNarcissisticPerfCounters();
+
+    CNarcissisticPerfCounters( const CNarcissisticPerfCounters& ) = delete;
+    CNarcissisticPerfCounters& operator=( const CNarcissisticPerfCounters& ) = delete;
+
+    bool available( ECounter counter ) const { return fFDs[ counter ] >= 0; }
+    bool anyAvailable() const;
+    const std::string& errorMsg() const { return fErrorMsg; }
+
+    // counting accumulates over every start/stop pair
+    void start();
+    void stop();
+
+    // values are scaled when the kernel multiplexed a counter, can be read from any thread
+    SCounts read() const;
+private:
+    std::array< int, eNumCounters > fFDs;
+    std::string fErrorMsg;
+};
+#endif
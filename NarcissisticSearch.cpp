@@ -0,0 +1,108 @@
+// The MIT License( MIT )
+//
+// Copyright( c ) 2020 Scott Aron Bloom
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sub-license, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "NarcissisticSearch.h"
+#include "NarcissisticThreadPool.h"
+
+#include <chrono>
+
+CNarcissisticSearch::CNarcissisticSearch( const SNarcissisticConfig& config )
+{
+    auto lclConfig = config;
+    lclConfig.fNumbers.sort(); // ascending partitions, so the covered interval grows from the smallest value
+    fCalculator.reset( new CNarcissisticNumCalculator( lclConfig ) );
+    fNextValue = lclConfig.fByRange ? lclConfig.fRange.first : ( lclConfig.fNumbers.empty() ? 0 : lclConfig.fNumbers.front() );
+    fCalculator->setProgressObserver(
+        [ this ]()
+        {
+            std::lock_guard< std::mutex > lock( fMutex );
+            fGeneration++;
+            fChanged.notify_all();
+        } );
+}
+
+CNarcissisticSearch::~CNarcissisticSearch()
+{
+    cancel();
+    fCalculator.reset();
+}
+
+void CNarcissisticSearch::start()
+{
+    if ( fStarted )
+        return;
+    fStarted = true;
+    fCalculator->launch( CNarcissisticNumCalculator::TReportFunctionType(), false );
+    fCalculator->partition( CNarcissisticNumCalculator::TReportFunctionType(), false );
+}
+
+void CNarcissisticSearch::cancel()
+{
+    fDone = true;
+    if ( !fStarted )
+        return;
+    fCalculator->cancel();
+    while ( !fCalculator->waitUntilIdle( std::chrono::milliseconds( 100 ) ) )
+        ;
+}
+
+bool CNarcissisticSearch::next( uint64_t& value )
+{
+    start();
+    while ( fReady.empty() )
+    {
+        if ( fDone || fCalculator->isStopped() )
+            return false;
+
+        uint64_t generation = 0;
+        {
+            std::lock_guard< std::mutex > lock( fMutex );
+            generation = fGeneration;
+        }
+
+        // never call the calculator with fMutex held, the observer takes it with the calculator locked
+        auto finished = fCalculator->isFinished( nullptr );
+        auto proven = fCalculator->provenResults( fNextValue, finished );
+        fReady.insert( fReady.end(), proven.begin(), proven.end() );
+        if ( !fReady.empty() )
+            break;
+        if ( finished )
+        {
+            fDone = true;
+            return false;
+        }
+
+        std::unique_lock< std::mutex > lock( fMutex );
+        fChanged.wait_for( lock, std::chrono::milliseconds( 100 ), [ this, generation ]() { return fGeneration != generation; } );
+    }
+
+    value = fReady.front();
+    fReady.pop_front();
+    fCalculator->resultsConsumed( 1 );
+    return true;
+}
+
+std::pair< uint64_t, uint64_t > CNarcissisticSearch::coveredInterval() const
+{
+    return fCalculator->coveredInterval();
+}
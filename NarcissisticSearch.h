@@ -0,0 +1,102 @@
+// The MIT License( MIT )
+//
+// Copyright( c ) 2020 Scott Aron Bloom
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sub-license, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#ifndef __NARCISSISTICSEARCH_H
+#define __NARCISSISTICSEARCH_H
+
+#include "NarcissisticNumCalculator.h"
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <iterator>
+#include <memory>
+#include <mutex>
+
+// The embeddable interface, a pull based generator of the narcissistic numbers of a configuration
+// Values are produced in ascending order as soon as every partition below them has completed.
+// The workers are held back once config.fMaxBuffered results are waiting to be consumed, and
+// destroying the search (or cancel) stops the remaining work
+//
+//     CNarcissisticSearch search( config );
+//     for ( auto&& value : search )
+//         if ( enough( value ) )
+//             break;
+class CNarcissisticSearch
+{
+public:
+    class CIterator
+    {
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = uint64_t;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const uint64_t*;
+        using reference = const uint64_t&;
+
+        CIterator() {}
+        explicit CIterator( CNarcissisticSearch* search ) : fSearch( search ) { advance(); }
+
+        reference operator*() const { return fValue; }
+        pointer operator->() const { return &fValue; }
+        CIterator& operator++() { advance(); return *this; }
+        bool operator==( const CIterator& rhs ) const { return fSearch == rhs.fSearch; }
+        bool operator!=( const CIterator& rhs ) const { return fSearch != rhs.fSearch; }
+    private:
+        void advance() { if ( fSearch && !fSearch->next( fValue ) ) fSearch = nullptr; }
+        CNarcissisticSearch* fSearch{ nullptr };
+        uint64_t fValue{ 0 };
+    };
+
+    explicit CNarcissisticSearch( const SNarcissisticConfig& config );
+    ~CNarcissisticSearch();
+    CNarcissisticSearch( const CNarcissisticSearch& ) = delete;
+    CNarcissisticSearch& operator=( const CNarcissisticSearch& ) = delete;
+
+    // single pass, begin starts the search the first time
+    CIterator begin() { return CIterator( this ); }
+    CIterator end() { return CIterator(); }
+
+    // blocks until the next value is proven, returns false once every value has been returned or the search is cancelled
+    bool next( uint64_t& value );
+    void cancel();
+
+    bool isStarted() const { return fStarted; }
+    // every value in [first:second) has been returned or is waiting to be
+    std::pair< uint64_t, uint64_t > coveredInterval() const;
+    const CNarcissisticNumCalculator& calculator() const { return *fCalculator; }
+private:
+    void start();
+
+    // declared before the calculator, its observer uses them until it is destroyed
+    std::mutex fMutex;
+    std::condition_variable fChanged;
+    uint64_t fGeneration{ 0 };
+
+    std::unique_ptr< CNarcissisticNumCalculator > fCalculator;
+    std::deque< uint64_t > fReady;
+    uint64_t fNextValue{ 0 }; // everything below has been moved to fReady
+    bool fStarted{ false };
+    bool fDone{ false };
+};
+#endif
@@ -0,0 +1,359 @@
+// The MIT License( MIT )
+//
+// Copyright( c ) 2020 Scott Aron Bloom
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sub-license, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "NarcissisticShard.h"
+#include "NarcissisticEngine.h"
+
+#include <QFile>
+#include <QSaveFile>
+#include <QString>
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <map>
+#include <sstream>
+
+namespace
+{
+    const char kMagic[ 8 ] = { 'N', 'A', 'R', 'C', 'S', 'H', 'R', 'D' };
+    const uint32_t kVersion = 1;
+
+    // [curr:lengthEnd) all have the same number of digits
+    uint64_t lengthEnd( uint64_t curr, uint64_t max, int base, int& numDigits )
+    {
+        numDigits = CNarcissisticEngine::computeNumDigits( curr, base );
+        auto retVal = CNarcissisticEngine::powerSat( base, numDigits );
+        return ( retVal == std::numeric_limits< uint64_t >::max() ) ? max : std::min( max, retVal );
+    }
+
+    long double rangeCost( uint64_t min, uint64_t max, int base )
+    {
+        long double retVal = 0;
+        for ( auto curr = min; curr < max; )
+        {
+            int numDigits = 0;
+            auto end = lengthEnd( curr, max, base, numDigits );
+            retVal += static_cast< long double >( end - curr ) * numDigits;
+            curr = end;
+        }
+        return retVal;
+    }
+}
+
+uint64_t CNarcissisticShard::shardBoundary( uint64_t min, uint64_t max, int base, long double cost )
+{
+    long double soFar = 0;
+    for ( auto curr = min; curr < max; )
+    {
+        int numDigits = 0;
+        auto end = lengthEnd( curr, max, base, numDigits );
+        auto segmentCost = static_cast< long double >( end - curr ) * numDigits;
+        if ( ( soFar + segmentCost ) >= cost )
+        {
+            auto offset = static_cast< uint64_t >( ( cost - soFar ) / numDigits );
+            return std::min( end, curr + std::min( offset, end - curr ) );
+        }
+        soFar += segmentCost;
+        curr = end;
+    }
+    return max;
+}
+
+CNarcissisticShard::TInterval CNarcissisticShard::shardRange( uint64_t min, uint64_t max, int base, uint32_t shard, uint32_t numShards )
+{
+    if ( ( max <= min ) || ( shard >= numShards ) )
+        return std::make_pair( min, min );
+
+    // both neighbours compute the shared boundary from the same expression, so the shards always tile
+    auto total = rangeCost( min, max, base );
+    auto first = ( shard == 0 ) ? min : shardBoundary( min, max, base, total * shard / numShards );
+    auto second = ( ( shard + 1 ) == numShards ) ? max : shardBoundary( min, max, base, total * ( shard + 1 ) / numShards );
+    return std::make_pair( first, second );
+}
+
+std::list< uint64_t > CNarcissisticShard::shardValues( std::list< uint64_t > values, int base, uint32_t shard, uint32_t numShards )
+{
+    values.sort();
+    values.unique();
+    if ( shard >= numShards )
+        return {};
+
+    long double total = 0;
+    for ( auto&& ii : values )
+        total += CNarcissisticEngine::computeNumDigits( ii, base );
+
+    auto lo = total * shard / numShards;
+    auto hi = total * ( shard + 1 ) / numShards;
+    bool last = ( shard + 1 ) == numShards;
+
+    // each value goes to the shard holding the middle of its cost, which keeps short lists balanced
+    std::list< uint64_t > retVal;
+    long double soFar = 0;
+    for ( auto&& ii : values )
+    {
+        auto cost = CNarcissisticEngine::computeNumDigits( ii, base );
+        auto middle = soFar + cost / 2.0L;
+        if ( ( middle >= lo ) && ( last || ( middle < hi ) ) )
+            retVal.push_back( ii );
+        soFar += cost;
+    }
+    return retVal;
+}
+
+uint64_t CNarcissisticShard::listHash( const std::list< uint64_t >& values )
+{
+    uint64_t retVal = 0xcbf29ce484222325ULL;
+    for ( auto&& ii : values )
+    {
+        for ( int byte = 0; byte < 8; ++byte )
+        {
+            retVal ^= ( ii >> ( 8 * byte ) ) & 0xFF;
+            retVal *= 0x100000001b3ULL;
+        }
+    }
+    return retVal;
+}
+
+std::string CNarcissisticShard::defaultFileName( uint32_t shard, uint32_t numShards )
+{
+    return "narcissistic-shard-" + std::to_string( shard ) + "-of-" + std::to_string( numShards ) + ".dat";
+}
+
+bool CNarcissisticShard::SResult::write( const std::string& fileName, std::string& errorMsg ) const
+{
+    QSaveFile file( QString::fromStdString( fileName ) );
+    if ( !file.open( QIODevice::WriteOnly ) )
+    {
+        errorMsg = "Could not open '" + fileName + "' for writing";
+        return false;
+    }
+
+    SHeader header;
+    std::memset( &header, 0, sizeof( header ) );
+    std::memcpy( header.fMagic, kMagic, sizeof( kMagic ) );
+    header.fVersion = kVersion;
+    header.fBase = static_cast< uint32_t >( fBase );
+    header.fShard = fShard;
+    header.fNumShards = fNumShards;
+    header.fByRange = fByRange ? 1 : 0;
+    header.fRangeMin = fRange.first;
+    header.fRangeMax = fRange.second;
+    header.fListSize = fListSize;
+    header.fListHash = fListHash;
+    header.fCoveredMin = fCovered.first;
+    header.fCoveredMax = fCovered.second;
+    header.fRunNanos = fRunNanos;
+    header.fNumChecked = fChecked.size();
+    header.fNumFound = fFound.size();
+    file.write( reinterpret_cast< const char* >( &header ), sizeof( header ) );
+    if ( !fChecked.empty() )
+        file.write( reinterpret_cast< const char* >( fChecked.data() ), fChecked.size() * sizeof( uint64_t ) );
+    if ( !fFound.empty() )
+        file.write( reinterpret_cast< const char* >( fFound.data() ), fFound.size() * sizeof( uint64_t ) );
+    if ( !file.commit() )
+    {
+        errorMsg = "Could not write '" + fileName + "'";
+        return false;
+    }
+    return true;
+}
+
+bool CNarcissisticShard::SResult::read( const std::string& fileName, std::string& errorMsg )
+{
+    QFile file( QString::fromStdString( fileName ) );
+    if ( !file.open( QIODevice::ReadOnly ) )
+    {
+        errorMsg = "Could not open '" + fileName + "'";
+        return false;
+    }
+
+    SHeader header;
+    if ( ( file.read( reinterpret_cast< char* >( &header ), sizeof( header ) ) != static_cast< qint64 >( sizeof( header ) ) )
+        || ( std::memcmp( header.fMagic, kMagic, sizeof( kMagic ) ) != 0 ) )
+    {
+        errorMsg = "'" + fileName + "' is not a shard result file";
+        return false;
+    }
+    if ( header.fVersion != kVersion )
+    {
+        errorMsg = "'" + fileName + "' is shard file version " + std::to_string( header.fVersion ) + ", expected " + std::to_string( kVersion );
+        return false;
+    }
+    auto expectedSize = sizeof( header ) + ( header.fNumChecked + header.fNumFound ) * sizeof( uint64_t );
+    if ( static_cast< uint64_t >( file.size() ) != expectedSize )
+    {
+        errorMsg = "'" + fileName + "' is truncated or corrupt";
+        return false;
+    }
+
+    fShard = header.fShard;
+    fNumShards = header.fNumShards;
+    fBase = static_cast< int >( header.fBase );
+    fByRange = header.fByRange != 0;
+    fRange = std::make_pair( header.fRangeMin, header.fRangeMax );
+    fListSize = header.fListSize;
+    fListHash = header.fListHash;
+    fCovered = std::make_pair( header.fCoveredMin, header.fCoveredMax );
+    fRunNanos = header.fRunNanos;
+    fChecked.resize( header.fNumChecked );
+    fFound.resize( header.fNumFound );
+    if ( !fChecked.empty() )
+        file.read( reinterpret_cast< char* >( fChecked.data() ), fChecked.size() * sizeof( uint64_t ) );
+    if ( !fFound.empty() )
+        file.read( reinterpret_cast< char* >( fFound.data() ), fFound.size() * sizeof( uint64_t ) );
+    return true;
+}
+
+bool CNarcissisticShard::merge( const std::list< std::string >& fileNames, SResult& merged, std::string& errorMsg )
+{
+    if ( fileNames.empty() )
+    {
+        errorMsg = "No shard files to merge";
+        return false;
+    }
+
+    std::map< uint32_t, std::pair< std::string, SResult > > shards;
+    for ( auto&& fileName : fileNames )
+    {
+        SResult curr;
+        if ( !curr.read( fileName, errorMsg ) )
+            return false;
+
+        if ( shards.empty() )
+            merged = curr;
+        else if ( ( curr.fBase != merged.fBase ) || ( curr.fByRange != merged.fByRange ) || ( curr.fNumShards != merged.fNumShards )
+            || ( curr.fByRange ? ( curr.fRange != merged.fRange ) : ( ( curr.fListSize != merged.fListSize ) || ( curr.fListHash != merged.fListHash ) ) ) )
+        {
+            errorMsg = "'" + fileName + "' is from a different job than '" + shards.begin()->second.first + "'";
+            return false;
+        }
+        if ( curr.fShard >= curr.fNumShards )
+        {
+            errorMsg = "'" + fileName + "' has an invalid shard number";
+            return false;
+        }
+        auto pos = shards.find( curr.fShard );
+        if ( pos != shards.end() )
+        {
+            errorMsg = "Shard " + std::to_string( curr.fShard ) + " is in both '" + ( *pos ).second.first + "' and '" + fileName + "'";
+            return false;
+        }
+        shards[ curr.fShard ] = std::make_pair( fileName, std::move( curr ) );
+    }
+
+    for ( uint32_t ii = 0; ii < merged.fNumShards; ++ii )
+    {
+        if ( shards.find( ii ) == shards.end() )
+        {
+            errorMsg = "Shard " + std::to_string( ii ) + " of " + std::to_string( merged.fNumShards ) + " is missing";
+            return false;
+        }
+    }
+
+    merged.fShard = 0;
+    merged.fChecked.clear();
+    merged.fFound.clear();
+    merged.fRunNanos = 0;
+    for ( auto&& ii : shards )
+    {
+        auto&& curr = ii.second.second;
+        for ( auto&& jj : curr.fFound )
+        {
+            bool covered = curr.fByRange ? ( ( jj >= curr.fCovered.first ) && ( jj < curr.fCovered.second ) ) : std::binary_search( curr.fChecked.begin(), curr.fChecked.end(), jj );
+            if ( !covered )
+            {
+                errorMsg = "'" + ii.second.first + "' reports " + std::to_string( jj ) + " which it did not check";
+                return false;
+            }
+        }
+        merged.fChecked.insert( merged.fChecked.end(), curr.fChecked.begin(), curr.fChecked.end() );
+        merged.fFound.insert( merged.fFound.end(), curr.fFound.begin(), curr.fFound.end() );
+        merged.fRunNanos = std::max( merged.fRunNanos, curr.fRunNanos );
+    }
+
+    if ( merged.fByRange )
+    {
+        // ordered by the start of their coverage, the shards must tile the range
+        std::list< std::pair< TInterval, uint32_t > > covered;
+        for ( auto&& ii : shards )
+            covered.emplace_back( ii.second.second.fCovered, ii.first );
+        covered.sort();
+
+        auto curr = merged.fRange.first;
+        uint32_t prevShard = 0;
+        bool first = true;
+        for ( auto&& ii : covered )
+        {
+            auto interval = ii.first;
+            std::ostringstream oss;
+            if ( interval.first > curr )
+                oss << "[" << curr << ":" << interval.first << ") is not covered" << ( first ? "" : ( " between shard " + std::to_string( prevShard ) + " and" ) ) << " shard " << ii.second;
+            else if ( interval.first < curr )
+                oss << "Shards " << prevShard << " and " << ii.second << " overlap on [" << interval.first << ":" << std::min( curr, interval.second ) << ")";
+            if ( !oss.str().empty() )
+            {
+                errorMsg = oss.str();
+                return false;
+            }
+            curr = std::max( curr, interval.second );
+            prevShard = ii.second;
+            first = false;
+        }
+        if ( curr != merged.fRange.second )
+        {
+            std::ostringstream oss;
+            if ( curr < merged.fRange.second )
+                oss << "[" << curr << ":" << merged.fRange.second << ") is not covered after shard " << prevShard;
+            else
+                oss << "Shard " << prevShard << " covers [" << merged.fRange.second << ":" << curr << ") beyond the range";
+            errorMsg = oss.str();
+            return false;
+        }
+        merged.fCovered = merged.fRange;
+    }
+    else
+    {
+        std::sort( merged.fChecked.begin(), merged.fChecked.end() );
+        auto duplicate = std::adjacent_find( merged.fChecked.begin(), merged.fChecked.end() );
+        if ( duplicate != merged.fChecked.end() )
+        {
+            errorMsg = std::to_string( *duplicate ) + " was checked by more than one shard";
+            return false;
+        }
+        if ( merged.fChecked.size() != merged.fListSize )
+        {
+            errorMsg = std::to_string( merged.fChecked.size() ) + " values were checked, but the list has " + std::to_string( merged.fListSize ) + " different values";
+            return false;
+        }
+        if ( listHash( std::list< uint64_t >( merged.fChecked.begin(), merged.fChecked.end() ) ) != merged.fListHash )
+        {
+            errorMsg = "The values checked by the shards are not the values of the list";
+            return false;
+        }
+    }
+
+    std::sort( merged.fFound.begin(), merged.fFound.end() );
+    merged.fFound.erase( std::unique( merged.fFound.begin(), merged.fFound.end() ), merged.fFound.end() );
+    return true;
+}
@@ -0,0 +1,96 @@
+// The MIT License( MIT )
+//
+// Copyright( c ) 2020 Scott Aron Bloom
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sub-license, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#ifndef __NARCISSISTICSHARD_H
+#define __NARCISSISTICSHARD_H
+
+#include <cstdint>
+#include <list>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Static sharding for scheduler array jobs, shard i of N is computed from the configuration alone
+// so the shards never need to talk to each other. Every shard writes a result file recording what
+// it covered and what it found, and merge() checks the files tile the job exactly before combining them
+class CNarcissisticShard
+{
+public:
+    using TInterval = std::pair< uint64_t, uint64_t >; // [first:second)
+
+    // the part of [min:max) for the shard, the cost of a candidate is its number of digits
+    // the shards tile [min:max) in order
+    static TInterval shardRange( uint64_t min, uint64_t max, int base, uint32_t shard, uint32_t numShards );
+    // the values of the list for the shard, the list is sorted and duplicates are removed first
+    static std::list< uint64_t > shardValues( std::list< uint64_t > values, int base, uint32_t shard, uint32_t numShards );
+    // FNV-1a over the sorted unique list, identifies the list a shard was cut from
+    static uint64_t listHash( const std::list< uint64_t >& values );
+
+    static std::string defaultFileName( uint32_t shard, uint32_t numShards );
+
+    struct SResult
+    {
+        uint32_t fShard{ 0 };
+        uint32_t fNumShards{ 1 };
+        int fBase{ 10 };
+        bool fByRange{ true };
+        TInterval fRange{ 0, 0 }; // the whole job, range mode
+        uint64_t fListSize{ 0 }; // the whole job, list mode
+        uint64_t fListHash{ 0 };
+        TInterval fCovered{ 0, 0 }; // the shards part of the range
+        std::vector< uint64_t > fChecked; // the shards part of the list, sorted
+        std::vector< uint64_t > fFound; // sorted
+        uint64_t fRunNanos{ 0 };
+
+        bool write( const std::string& fileName, std::string& errorMsg ) const;
+        bool read( const std::string& fileName, std::string& errorMsg );
+    };
+
+    // validates that the shards are from the same job, that every shard is present once and that
+    // their coverage has no gaps or overlaps, merged is the whole job with every value found
+    static bool merge( const std::list< std::string >& fileNames, SResult& merged, std::string& errorMsg );
+private:
+    // the first value of [min:max) where the cost of the values before it reaches cost
+    static uint64_t shardBoundary( uint64_t min, uint64_t max, int base, long double cost );
+
+    struct SHeader
+    {
+        char fMagic[ 8 ];
+        uint32_t fVersion;
+        uint32_t fBase;
+        uint32_t fShard;
+        uint32_t fNumShards;
+        uint32_t fByRange;
+        uint32_t fReserved;
+        uint64_t fRangeMin;
+        uint64_t fRangeMax;
+        uint64_t fListSize;
+        uint64_t fListHash;
+        uint64_t fCoveredMin;
+        uint64_t fCoveredMax;
+        uint64_t fRunNanos;
+        uint64_t fNumChecked; // followed by fNumChecked values then fNumFound values
+        uint64_t fNumFound;
+    };
+};
+#endif
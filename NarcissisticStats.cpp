@@ -0,0 +1,169 @@
+// The MIT License( MIT )
+//
+// Copyright( c ) 2020 Scott Aron Bloom
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sub-license, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "NarcissisticStats.h"
+#include "NarcissisticEngine.h"
+
+#include <algorithm>
+#include <limits>
+
+CNarcissisticStats::TLengthCounts CNarcissisticStats::countRange( uint64_t min, uint64_t max, int base )
+{
+    TLengthCounts retVal{};
+    for ( auto curr = min; curr < max; )
+    {
+        // every value up to b^k has k digits
+        auto numDigits = CNarcissisticEngine::computeNumDigits( curr, base );
+        auto lengthEnd = CNarcissisticEngine::powerSat( base, numDigits );
+        lengthEnd = ( lengthEnd == std::numeric_limits< uint64_t >::max() ) ? max : std::min( max, lengthEnd );
+        retVal[ numDigits ] += lengthEnd - curr;
+        curr = lengthEnd;
+    }
+    return retVal;
+}
+
+CNarcissisticStats::TLengthCounts CNarcissisticStats::countValues( const std::list< uint64_t >& values, int base )
+{
+    TLengthCounts retVal{};
+    for ( auto&& ii : values )
+        retVal[ CNarcissisticEngine::computeNumDigits( ii, base ) ]++;
+    return retVal;
+}
+
+void CNarcissisticStats::clear()
+{
+    *this = CNarcissisticStats();
+}
+
+void CNarcissisticStats::addRemaining( const TLengthCounts& counts )
+{
+    for ( size_t ii = 0; ii < counts.size(); ++ii )
+        fRemaining[ ii ] += counts[ ii ];
+}
+
+void CNarcissisticStats::recordPartition( const std::chrono::steady_clock::duration& busy, const TLengthCounts& checked )
+{
+    auto nanos = static_cast< uint64_t >( std::max< int64_t >( 0, std::chrono::duration_cast< std::chrono::nanoseconds >( busy ).count() ) );
+    fHistogram[ bucketIndex( nanos ) ]++;
+    fMin = fNumPartitions ? std::min( fMin, nanos ) : nanos;
+    fMax = std::max( fMax, nanos );
+    fNumPartitions++;
+    fTotalNanos += nanos;
+
+    auto seconds = nanos / 1e9;
+    fBusySeconds += seconds;
+
+    // a partition may span lengths, the time is shared by the (count * digits) cost of each
+    double totalWeight = 0.0;
+    for ( size_t ii = 0; ii < checked.size(); ++ii )
+        totalWeight += static_cast< double >( checked[ ii ] ) * ii;
+    for ( size_t ii = 0; ii < checked.size(); ++ii )
+    {
+        if ( !checked[ ii ] )
+            continue;
+        if ( totalWeight > 0.0 )
+            fLengthSeconds[ ii ] += seconds * checked[ ii ] * ii / totalWeight;
+        fLengthCandidates[ ii ] += checked[ ii ];
+        fRemaining[ ii ] -= std::min( fRemaining[ ii ], checked[ ii ] );
+    }
+}
+
+std::chrono::nanoseconds CNarcissisticStats::mean() const
+{
+    return std::chrono::nanoseconds( fNumPartitions ? ( fTotalNanos / fNumPartitions ) : 0 );
+}
+
+std::chrono::nanoseconds CNarcissisticStats::percentile( double percent ) const
+{
+    if ( !fNumPartitions )
+        return std::chrono::nanoseconds( 0 );
+
+    auto target = static_cast< uint64_t >( fNumPartitions * std::min( 100.0, std::max( 0.0, percent ) ) / 100.0 );
+    uint64_t seen = 0;
+    for ( size_t ii = 0; ii < fHistogram.size(); ++ii )
+    {
+        seen += fHistogram[ ii ];
+        if ( seen > target )
+            return std::chrono::nanoseconds( std::min( fMax, std::max( fMin, bucketValue( ii ) ) ) );
+    }
+    return std::chrono::nanoseconds( fMax );
+}
+
+size_t CNarcissisticStats::bucketIndex( uint64_t nanos )
+{
+    if ( nanos < kNumSubBuckets )
+        return static_cast< size_t >( nanos );
+
+    int msb = 63;
+    while ( !( nanos & ( 1ULL << msb ) ) )
+        msb--;
+    auto subBucket = ( nanos >> ( msb - kSubBucketBits ) ) & ( kNumSubBuckets - 1 );
+    return static_cast< size_t >( ( msb - kSubBucketBits + 1 ) * kNumSubBuckets + subBucket );
+}
+
+uint64_t CNarcissisticStats::bucketValue( size_t index )
+{
+    if ( index < kNumSubBuckets )
+        return index;
+
+    auto shift = static_cast< int >( index / kNumSubBuckets ) - 1;
+    auto subBucket = static_cast< uint64_t >( index % kNumSubBuckets );
+    auto low = ( kNumSubBuckets + subBucket ) << shift;
+    return low + ( ( 1ULL << shift ) >> 1 );
+}
+
+double CNarcissisticStats::secondsPerCandidate( int numDigits ) const
+{
+    if ( ( numDigits >= 0 ) && ( numDigits <= kMaxDigits ) && fLengthCandidates[ numDigits ] )
+        return fLengthSeconds[ numDigits ] / fLengthCandidates[ numDigits ];
+
+    // the cost of a candidate grows linearly with its digits
+    int nearest = -1;
+    for ( int ii = 1; ii <= kMaxDigits; ++ii )
+    {
+        if ( fLengthCandidates[ ii ] && ( ( nearest < 0 ) || ( std::abs( ii - numDigits ) < std::abs( nearest - numDigits ) ) ) )
+            nearest = ii;
+    }
+    if ( nearest < 0 )
+        return 0.0;
+    return ( fLengthSeconds[ nearest ] / fLengthCandidates[ nearest ] ) * numDigits / nearest;
+}
+
+double CNarcissisticStats::remainingCost() const
+{
+    double retVal = 0.0;
+    for ( int ii = 1; ii <= kMaxDigits; ++ii )
+    {
+        if ( fRemaining[ ii ] )
+            retVal += fRemaining[ ii ] * secondsPerCandidate( ii );
+    }
+    return retVal;
+}
+
+uint64_t CNarcissisticStats::remainingCandidates() const
+{
+    uint64_t retVal = 0;
+    for ( auto&& ii : fRemaining )
+        retVal += ii;
+    return retVal;
+}
@@ -0,0 +1,82 @@
+// The MIT License( MIT )
+//
+// Copyright( c ) 2020 Scott Aron Bloom
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sub-license, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#ifndef __NARCISSISTICSTATS_H
+#define __NARCISSISTICSTATS_H
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <list>
+
+// Streaming statistics for a run, the memory used is fixed no matter how many partitions are run
+//   - an HDR style log-linear histogram of the partition times (16 sub-buckets per power of 2, ~6% precision)
+//   - the measured cost per candidate for each digit length
+//   - the candidates remaining for each digit length
+// Not thread safe, the calculator updates it under its own lock
+class CNarcissisticStats
+{
+public:
+    static const int kMaxDigits{ 64 };
+    using TLengthCounts = std::array< uint64_t, kMaxDigits + 1 >; // indexed by the number of digits
+
+    static TLengthCounts countRange( uint64_t min, uint64_t max, int base ); // [min:max)
+    static TLengthCounts countValues( const std::list< uint64_t >& values, int base );
+
+    void clear();
+
+    void addRemaining( const TLengthCounts& counts );
+    // busy is the time spent checking the candidates, they are removed from the remaining counts
+    void recordPartition( const std::chrono::steady_clock::duration& busy, const TLengthCounts& checked );
+
+    uint64_t numPartitions() const { return fNumPartitions; }
+    std::chrono::nanoseconds mean() const;
+    std::chrono::nanoseconds percentile( double percent ) const;
+    std::chrono::nanoseconds min() const { return std::chrono::nanoseconds( fNumPartitions ? fMin : 0 ); }
+    std::chrono::nanoseconds max() const { return std::chrono::nanoseconds( fMax ); }
+    double busySeconds() const { return fBusySeconds; }
+
+    // measured for the length when possible, otherwise scaled by length from the nearest measured length
+    // returns 0 if nothing has been measured
+    double secondsPerCandidate( int numDigits ) const;
+    // the busy seconds needed to check every remaining candidate, divided by the concurrency gives the ETA
+    double remainingCost() const;
+    uint64_t remainingCandidates() const;
+private:
+    static const int kSubBucketBits{ 4 };
+    static const int kNumSubBuckets{ 1 << kSubBucketBits };
+    static size_t bucketIndex( uint64_t nanos );
+    static uint64_t bucketValue( size_t index ); // the middle of the bucket
+
+    std::array< uint64_t, 64 * kNumSubBuckets > fHistogram{};
+    uint64_t fNumPartitions{ 0 };
+    uint64_t fTotalNanos{ 0 };
+    uint64_t fMin{ 0 };
+    uint64_t fMax{ 0 };
+    double fBusySeconds{ 0.0 };
+
+    std::array< double, kMaxDigits + 1 > fLengthSeconds{};
+    TLengthCounts fLengthCandidates{};
+    TLengthCounts fRemaining{};
+};
+#endif
@@ -0,0 +1,723 @@
+// Generated by NarcissisticTableGenerator, do not edit.
+//
+// Every narcissistic number below 2^64 for each base with a complete table.
+
+#ifndef __NARCISSISTICTABLE_H
+#define __NARCISSISTICTABLE_H
+
+#include <cstdint>
+#include <cstddef>
+
+namespace NNarcissisticTable
+{
+    constexpr uint64_t kBase2[] =
+    {
+        0ULL, 1ULL,
+    };
+
+    constexpr uint64_t kBase3[] =
+    {
+        0ULL, 1ULL, 2ULL, 5ULL,
+        8ULL, 17ULL,
+    };
+
+    constexpr uint64_t kBase4[] =
+    {
+        0ULL, 1ULL, 2ULL, 3ULL,
+        28ULL, 29ULL, 35ULL, 43ULL,
+        55ULL, 62ULL, 83ULL, 243ULL,
+    };
+
+    constexpr uint64_t kBase5[] =
+    {
+        0ULL, 1ULL, 2ULL, 3ULL,
+        4ULL, 13ULL, 18ULL, 28ULL,
+        118ULL, 289ULL, 353ULL, 419ULL,
+        4890ULL, 4891ULL, 9113ULL, 1874374ULL,
+        338749352ULL, 2415951874ULL,
+    };
+
+    constexpr uint64_t kBase6[] =
+    {
+        0ULL, 1ULL, 2ULL, 3ULL,
+        4ULL, 5ULL, 99ULL, 190ULL,
+        2292ULL, 2293ULL, 2324ULL, 3432ULL,
+        3433ULL, 6197ULL, 36140ULL, 269458ULL,
+        391907ULL, 10067135ULL, 2510142206ULL, 2511720147ULL,
+        3866632806ULL, 3866632807ULL, 3930544834ULL, 4953134588ULL,
+        5018649129ULL, 6170640875ULL, 124246559501ULL, 4595333541803ULL,
+        5341093125744ULL, 5341093125745ULL, 19418246235419ULL,
+    };
+
+    constexpr uint64_t kBase7[] =
+    {
+        0ULL, 1ULL, 2ULL, 3ULL,
+        4ULL, 5ULL, 6ULL, 10ULL,
+        25ULL, 32ULL, 45ULL, 133ULL,
+        134ULL, 152ULL, 250ULL, 3190ULL,
+        3222ULL, 3612ULL, 3613ULL, 4183ULL,
+        9286ULL, 35411ULL, 191334ULL, 193393ULL,
+        376889ULL, 535069ULL, 794376ULL, 8094840ULL,
+        10883814ULL, 16219922ULL, 20496270ULL, 32469576ULL,
+        34403018ULL, 416002778ULL, 416352977ULL, 420197083ULL,
+        725781499ULL, 1500022495ULL, 15705029375ULL, 15705029376ULL,
+        28700208851ULL, 970930659537ULL, 972004335826ULL, 1003624386355ULL,
+        1443220146575ULL, 1504283967871ULL, 2352056093102ULL, 36940082141157ULL,
+        51612024946703ULL, 52323166511954ULL, 102340463411217ULL, 1847703627580701ULL,
+        2514834742553772ULL, 3123368686057682ULL, 132116164569671440ULL, 3984625384955273973ULL,
+        4008396591708493297ULL, 4798127097158078159ULL, 4798127097158078160ULL, 5528252581301500133ULL,
+    };
+
+    constexpr uint64_t kBase8[] =
+    {
+        0ULL, 1ULL, 2ULL, 3ULL,
+        4ULL, 5ULL, 6ULL, 7ULL,
+        20ULL, 52ULL, 92ULL, 133ULL,
+        307ULL, 432ULL, 433ULL, 16819ULL,
+        17864ULL, 17865ULL, 24583ULL, 25639ULL,
+        212419ULL, 906298ULL, 906426ULL, 938811ULL,
+        1122179ULL, 2087646ULL, 3821955ULL, 13606405ULL,
+        40695508ULL, 423056951ULL, 637339524ULL, 6710775966ULL,
+        13892162580ULL, 32298119799ULL, 97095152738ULL, 98250308556ULL,
+        98317417420ULL, 125586038802ULL, 208198418654ULL, 303865139807ULL,
+        497577637886ULL, 66627168170123ULL, 66627168235658ULL, 4998382669357032ULL,
+        4998382669357033ULL, 5190196317533094ULL, 22836489425312227ULL, 23446124043229664ULL,
+        23446124043229665ULL, 23464924977222355ULL, 24055210066546108ULL, 24055210067070396ULL,
+        57033449858814311ULL, 57033725899507007ULL, 167186253795085291ULL, 402810430791374316ULL,
+        3418993385062038719ULL,
+    };
+
+    constexpr uint64_t kBase9[] =
+    {
+        0ULL, 1ULL, 2ULL, 3ULL,
+        4ULL, 5ULL, 6ULL, 7ULL,
+        8ULL, 41ULL, 50ULL, 126ULL,
+        127ULL, 468ULL, 469ULL, 1824ULL,
+        8052ULL, 8295ULL, 9857ULL, 1198372ULL,
+        3357009ULL, 3357010ULL, 6287267ULL, 156608073ULL,
+        156608074ULL, 403584750ULL, 403584751ULL, 586638974ULL,
+        3302332571ULL, 42256814922ULL, 42256814923ULL, 114842637961ULL,
+        155896317510ULL, 552468844242ULL, 552468844243ULL, 647871937482ULL,
+        686031429775ULL, 686033024097ULL, 1212041747339ULL, 320659684133768ULL,
+        2717892501113815ULL, 4756225997157666ULL, 6774649666149786ULL, 37860400025315399ULL,
+        157971147790033100ULL,
+    };
+
+    constexpr uint64_t kBase10[] =
+    {
+        0ULL, 1ULL, 2ULL, 3ULL,
+        4ULL, 5ULL, 6ULL, 7ULL,
+        8ULL, 9ULL, 153ULL, 370ULL,
+        371ULL, 407ULL, 1634ULL, 8208ULL,
+        9474ULL, 54748ULL, 92727ULL, 93084ULL,
+        548834ULL, 1741725ULL, 4210818ULL, 9800817ULL,
+        9926315ULL, 24678050ULL, 24678051ULL, 88593477ULL,
+        146511208ULL, 472335975ULL, 534494836ULL, 912985153ULL,
+        4679307774ULL, 32164049650ULL, 32164049651ULL, 40028394225ULL,
+        42678290603ULL, 44708635679ULL, 49388550606ULL, 82693916578ULL,
+        94204591914ULL, 28116440335967ULL, 4338281769391370ULL, 4338281769391371ULL,
+        21897142587612075ULL, 35641594208964132ULL, 35875699062250035ULL, 1517841543307505039ULL,
+        3289582984443187032ULL, 4498128791164624869ULL, 4929273885928088826ULL,
+    };
+
+    constexpr uint64_t kBase11[] =
+    {
+        0ULL, 1ULL, 2ULL, 3ULL,
+        4ULL, 5ULL, 6ULL, 7ULL,
+        8ULL, 9ULL, 10ULL, 61ULL,
+        72ULL, 126ULL, 370ULL, 855ULL,
+        1161ULL, 1216ULL, 1280ULL, 10657ULL,
+        16841ULL, 16842ULL, 17864ULL, 17865ULL,
+        36949ULL, 36950ULL, 63684ULL, 66324ULL,
+        71217ULL, 90120ULL, 99594ULL, 99595ULL,
+        141424ULL, 157383ULL, 1165098ULL, 1165099ULL,
+        5611015ULL, 11959539ULL, 46478562ULL, 203821954ULL,
+        210315331ULL, 397800208ULL, 826098079ULL, 1308772162ULL,
+        1399714480ULL, 1410315438ULL, 1488546263ULL, 1576015136ULL,
+        2295894300ULL, 10203085980ULL, 13644164324ULL, 14642680876ULL,
+        24623149627ULL, 24631806603ULL, 24691225226ULL, 180672308259ULL,
+        704720016374ULL, 704720016375ULL, 718838467190ULL, 789245913572ULL,
+        1571878240854ULL, 10041625107200ULL, 10659775840397ULL, 10758019747082ULL,
+        15303766893939ULL, 16282640834531ULL, 22665013641335ULL, 23189867175992ULL,
+        23189867175993ULL, 105995971449078ULL, 209631054021956ULL, 2000063211403250ULL,
+        100483748184868383ULL, 102537499253899419ULL, 116978333330886614ULL, 121679930162910555ULL,
+        204521375126007494ULL, 235857297934104296ULL, 252536716783382525ULL, 333605480940812008ULL,
+        1339681967633704305ULL, 1605474601558754606ULL, 2189587263229807960ULL, 2488246003311410359ULL,
+        3470235282060240528ULL,
+    };
+
+    constexpr uint64_t kBase12[] =
+    {
+        0ULL, 1ULL, 2ULL, 3ULL,
+        4ULL, 5ULL, 6ULL, 7ULL,
+        8ULL, 9ULL, 10ULL, 11ULL,
+        29ULL, 125ULL, 811ULL, 944ULL,
+        1539ULL, 28733ULL, 193084ULL, 887690ULL,
+        2536330ULL, 6884751ULL, 17116683ULL, 5145662993ULL,
+        25022977605ULL, 39989277598ULL, 294245206529ULL, 301149802206ULL,
+        394317605931ULL, 429649124722ULL, 446779986586ULL, 711421780089ULL,
+        721162130247ULL, 735725761386ULL, 735902948576ULL, 70817772425475ULL,
+        430058466583655ULL, 769821410145671ULL, 9605568799734822ULL, 10605598214906078ULL,
+        14607333160784459ULL, 17415207127386123ULL, 104671842713017735ULL,
+    };
+
+    constexpr uint64_t kBase13[] =
+    {
+        0ULL, 1ULL, 2ULL, 3ULL,
+        4ULL, 5ULL, 6ULL, 7ULL,
+        8ULL, 9ULL, 10ULL, 11ULL,
+        12ULL, 17ULL, 45ULL, 85ULL,
+        98ULL, 136ULL, 160ULL, 793ULL,
+        794ULL, 854ULL, 1968ULL, 8194ULL,
+        62481ULL, 167544ULL, 167545ULL, 294094ULL,
+        320375ULL, 323612ULL, 325471ULL, 325713ULL,
+        350131ULL, 365914ULL, 2412003ULL, 4861352ULL,
+        21710514ULL, 43757311ULL, 43757312ULL, 46299414ULL,
+        51798568ULL, 52994053ULL, 292770723ULL, 300912578ULL,
+        919399061ULL, 2534491838ULL, 8210231338ULL, 9562958114ULL,
+        16037735724ULL, 65535897228ULL, 1110247745052ULL, 120648998466431ULL,
+        128671169832746ULL, 138109441404563ULL, 219098777100917ULL, 247190425105357ULL,
+        269901742967323ULL, 3333169721569716ULL, 9600381542153383ULL, 13742948175144875ULL,
+        20202474374808469ULL, 20207695342495691ULL, 32472151343516250ULL, 35342729623795289ULL,
+        61826476373416649ULL, 234639889148958539ULL, 1051469860986797436ULL, 2369125637084589814ULL,
+        3262877268277256303ULL, 5455819881833775357ULL, 5473835284872605156ULL, 7399371705329888879ULL,
+    };
+
+    constexpr uint64_t kBase14[] =
+    {
+        0ULL, 1ULL, 2ULL, 3ULL,
+        4ULL, 5ULL, 6ULL, 7ULL,
+        8ULL, 9ULL, 10ULL, 11ULL,
+        12ULL, 13ULL, 244ULL, 793ULL,
+        282007ULL, 10362564ULL, 1445712420ULL, 29546248981ULL,
+        164159496751ULL, 342515735622ULL, 359057049845ULL, 216210334578515ULL,
+        324075236456868ULL, 338527182572746ULL, 338609726265795ULL, 382789516519507ULL,
+        435198066019184ULL, 526088332647250ULL, 561958311295394ULL, 731510079816071ULL,
+        3053504360400014ULL, 72986582009685430ULL, 195513988604452936ULL, 2929077810233410395ULL,
+        9293738634995373874ULL, 9293738634995373875ULL, 13693152885437696288ULL,
+    };
+
+    constexpr uint64_t kBase15[] =
+    {
+        0ULL, 1ULL, 2ULL, 3ULL,
+        4ULL, 5ULL, 6ULL, 7ULL,
+        8ULL, 9ULL, 10ULL, 11ULL,
+        12ULL, 13ULL, 14ULL, 113ULL,
+        128ULL, 2755ULL, 3052ULL, 5059ULL,
+        49074ULL, 49089ULL, 386862ULL, 413951ULL,
+        517902ULL, 15219156ULL, 18605333ULL, 38009273ULL,
+        40082196ULL, 40310423ULL, 40868227ULL, 47527794ULL,
+        100128060ULL, 100128061ULL, 100128188ULL, 104189152ULL,
+        105464820ULL, 105464821ULL, 118412452ULL, 143980258ULL,
+        201745410ULL, 201745411ULL, 1263463237ULL, 1875861153ULL,
+        6220552009ULL, 27089282277ULL, 204305730054ULL, 4660526675644ULL,
+        7921900551253ULL, 162175626229962ULL, 411617045649890ULL, 458777157703511ULL,
+        898892069826768ULL, 927376546054234ULL, 1715459125467464ULL, 1715529893089840ULL,
+        27830219609114780ULL, 709752074008490887ULL, 4757879285016172805ULL,
+    };
+
+    constexpr uint64_t kBase16[] =
+    {
+        0ULL, 1ULL, 2ULL, 3ULL,
+        4ULL, 5ULL, 6ULL, 7ULL,
+        8ULL, 9ULL, 10ULL, 11ULL,
+        12ULL, 13ULL, 14ULL, 15ULL,
+        342ULL, 371ULL, 520ULL, 584ULL,
+        645ULL, 1189ULL, 1456ULL, 1457ULL,
+        1547ULL, 1611ULL, 2240ULL, 2241ULL,
+        2458ULL, 2729ULL, 2755ULL, 3240ULL,
+        3689ULL, 3744ULL, 3745ULL, 47314ULL,
+        79225ULL, 177922ULL, 177954ULL, 368764ULL,
+        369788ULL, 786656ULL, 786657ULL, 787680ULL,
+        787681ULL, 811239ULL, 812263ULL, 819424ULL,
+        819425ULL, 820448ULL, 820449ULL, 909360ULL,
+        909361ULL, 910384ULL, 910385ULL, 964546ULL,
+        1028202ULL, 1029226ULL, 1032822ULL, 9954347ULL,
+        15390779ULL, 35832320ULL, 35832321ULL, 232092270ULL,
+        249895860ULL, 13003083010ULL, 14149331047ULL, 19525142744ULL,
+        21715384850ULL, 24319117998ULL, 25975482595ULL, 47015425483ULL,
+        54999621646ULL, 54999622158ULL, 57710164042ULL, 57777180365ULL,
+        64889892233ULL, 65894799324ULL, 1029284916427ULL, 39156173278052ULL,
+        67931807662807ULL, 115645236369127ULL, 358058946284214ULL, 571495534127796ULL,
+        1610578592578517ULL, 1937492243081947ULL, 1937492310190811ULL, 2367190235652149ULL,
+        3607260802530963ULL, 3908639208812629ULL, 1035985780130445675ULL, 1035985781204187499ULL,
+        12025452866161354180ULL,
+    };
+
+    constexpr uint64_t kBase17[] =
+    {
+        0ULL, 1ULL, 2ULL, 3ULL,
+        4ULL, 5ULL, 6ULL, 7ULL,
+        8ULL, 9ULL, 10ULL, 11ULL,
+        12ULL, 13ULL, 14ULL, 15ULL,
+        16ULL, 40ULL, 58ULL, 145ULL,
+        162ULL, 245ULL, 261ULL, 1456ULL,
+        36354ULL, 2369380ULL, 3510400ULL, 12184274ULL,
+        12184275ULL, 372311587ULL, 393788701ULL, 24462020950ULL,
+        740517590524ULL, 2002710374101ULL, 10423530442067ULL, 391338431584201ULL,
+        9811012276709365ULL, 128719468057472599ULL, 128719468057472600ULL,
+    };
+
+    constexpr uint64_t kBase18[] =
+    {
+        0ULL, 1ULL, 2ULL, 3ULL,
+        4ULL, 5ULL, 6ULL, 7ULL,
+        8ULL, 9ULL, 10ULL, 11ULL,
+        12ULL, 13ULL, 14ULL, 15ULL,
+        16ULL, 17ULL, 80ULL, 117ULL,
+        225ULL, 260ULL, 5337ULL, 24017088ULL,
+        55250208488ULL, 71266242364ULL, 90912234414ULL, 2143773176125ULL,
+        8968523928930ULL, 8968523928931ULL, 27374216775724ULL, 996917647408070ULL,
+        12014942055032385ULL, 16113609510761605ULL, 227923862603969903ULL, 274100089738851915ULL,
+    };
+
+    constexpr uint64_t kBase19[] =
+    {
+        0ULL, 1ULL, 2ULL, 3ULL,
+        4ULL, 5ULL, 6ULL, 7ULL,
+        8ULL, 9ULL, 10ULL, 11ULL,
+        12ULL, 13ULL, 14ULL, 15ULL,
+        16ULL, 17ULL, 18ULL, 181ULL,
+        200ULL, 513ULL, 514ULL, 863ULL,
+        1968ULL, 2413ULL, 2414ULL, 2540ULL,
+        5939ULL, 87922ULL, 107828ULL, 282899ULL,
+        1397217ULL, 1473803ULL, 2432219ULL, 67799133ULL,
+        275426470ULL, 275426471ULL, 479297018ULL, 741930660ULL,
+        795011177ULL, 4345596067ULL, 12150903525ULL, 16146139525ULL,
+        16205572836ULL, 16619265828ULL, 51486533336ULL, 51486533337ULL,
+        123934783293ULL, 218876292722ULL, 240368426558ULL, 11194248543461ULL,
+        13742167183559ULL, 43211020343708ULL, 46107720518425ULL, 64572727711018ULL,
+        77999433703595ULL, 92636384978513ULL, 92763413685466ULL, 92763413685467ULL,
+        101345451843534ULL, 103322830800528ULL, 103333711676500ULL, 422021103940888ULL,
+        12201668804494400ULL, 14717799158672726ULL, 26328093210660257ULL, 39559268948578602ULL,
+        337187488836139228ULL, 389020155937490806ULL, 551546393289665819ULL, 1214114814910814481ULL,
+        3856200310173641409ULL, 8128165833899771113ULL, 8514060562252191313ULL,
+    };
+
+    constexpr uint64_t kBase20[] =
+    {
+        0ULL, 1ULL, 2ULL, 3ULL,
+        4ULL, 5ULL, 6ULL, 7ULL,
+        8ULL, 9ULL, 10ULL, 11ULL,
+        12ULL, 13ULL, 14ULL, 15ULL,
+        16ULL, 17ULL, 18ULL, 19ULL,
+        2413ULL, 53808ULL, 760400ULL, 760401ULL,
+        45661018ULL, 62470211ULL, 619939142ULL, 14613048357ULL,
+        1421043363262183ULL, 48470736648305918ULL, 514822672411130775ULL,
+    };
+
+    constexpr uint64_t kBase21[] =
+    {
+        0ULL, 1ULL, 2ULL, 3ULL,
+        4ULL, 5ULL, 6ULL, 7ULL,
+        8ULL, 9ULL, 10ULL, 11ULL,
+        12ULL, 13ULL, 14ULL, 15ULL,
+        16ULL, 17ULL, 18ULL, 19ULL,
+        20ULL, 26ULL, 136ULL, 221ULL,
+        242ULL, 325ULL, 425ULL, 5075ULL,
+        5615ULL, 69523ULL, 188928ULL, 279393ULL,
+        404126ULL, 852216ULL, 921693ULL, 1514215ULL,
+        1560401ULL, 1900011ULL, 2395008ULL, 2395009ULL,
+        2656737ULL, 20572410ULL, 45673059ULL, 643372860ULL,
+        20663829222ULL, 91237265057ULL, 129092357717ULL, 172203124955ULL,
+        210368674635ULL, 210368674636ULL, 305747148801ULL, 460975456485ULL,
+        566674176390ULL, 566674176391ULL, 578032110713ULL, 782947474064ULL,
+        247125162813015ULL, 67722152650315924ULL, 82725693172498894ULL, 92291621006779865ULL,
+        95127892386235938ULL, 105518045289739008ULL, 128898814874690022ULL, 151294004002268542ULL,
+        152789340072232622ULL, 2986299681195434415ULL, 2986299681195434416ULL,
+    };
+
+    constexpr uint64_t kBase22[] =
+    {
+        0ULL, 1ULL, 2ULL, 3ULL,
+        4ULL, 5ULL, 6ULL, 7ULL,
+        8ULL, 9ULL, 10ULL, 11ULL,
+        12ULL, 13ULL, 14ULL, 15ULL,
+        16ULL, 17ULL, 18ULL, 19ULL,
+        20ULL, 21ULL, 97ULL, 405ULL,
+        514ULL, 1701ULL, 3718ULL, 3719ULL,
+        3887ULL, 4654ULL, 5824ULL, 6167ULL,
+        6418ULL, 6591ULL, 8021ULL, 9736ULL,
+        170768ULL, 365640ULL, 365641ULL, 1111775ULL,
+        4235344ULL, 4872057ULL, 28456196ULL, 278468480ULL,
+        409252551ULL, 537447168ULL, 763329330ULL, 908084614ULL,
+        988262896ULL, 1061087029ULL, 1545120950ULL, 1668891348ULL,
+        1758271361ULL, 1838488003ULL, 1920236393ULL, 2190472412ULL,
+        2302918953ULL, 2335200837ULL, 37137495588ULL, 655194708953ULL,
+        1112128332320ULL, 195364672317396ULL, 2153841045275321ULL, 5142193180978696ULL,
+        7802945006156856ULL, 23704953575541517ULL, 32803274260449523ULL, 52184653943178228ULL,
+        61068343301950650ULL, 61490256577754668ULL, 68176015095213593ULL, 86759690317255528ULL,
+        93947678342274251ULL, 99833482564255597ULL, 117941952951445497ULL, 129392925843551499ULL,
+        162844743942677316ULL, 163655616980050756ULL, 163655616980050757ULL, 173243027750951499ULL,
+        206324653215642935ULL, 232260267924755230ULL, 248259417978605802ULL, 257262433372862301ULL,
+        440985511462894494ULL,
+    };
+
+    constexpr uint64_t kBase23[] =
+    {
+        0ULL, 1ULL, 2ULL, 3ULL,
+        4ULL, 5ULL, 6ULL, 7ULL,
+        8ULL, 9ULL, 10ULL, 11ULL,
+        12ULL, 13ULL, 14ULL, 15ULL,
+        16ULL, 17ULL, 18ULL, 19ULL,
+        20ULL, 21ULL, 22ULL, 53ULL,
+        125ULL, 265ULL, 288ULL, 424ULL,
+        490ULL, 738ULL, 3718ULL, 9009ULL,
+        11648ULL, 185027ULL, 407914ULL, 4208207ULL,
+        6220885ULL, 34423267ULL, 983247897ULL, 63592172581ULL,
+        678555833118ULL, 1342089541083ULL, 27914876299228ULL, 39319942277527ULL,
+        136169236907439ULL, 155686110514402ULL, 264423081149687ULL, 419208949325396ULL,
+        420745246413462ULL, 420745246413463ULL, 442973914703679ULL, 573679141537665ULL,
+        584858357286182ULL, 584858357286183ULL, 597931987238364ULL, 605999732323779ULL,
+        653068392778377ULL, 771312646565003ULL, 800110560411354ULL, 818480509805448ULL,
+        818480509805449ULL, 885698054157701ULL, 943997426274735ULL, 5376211243710903ULL,
+        8604504249727670ULL, 19125326798446229ULL, 842761838394519399ULL, 1691873558324489365ULL,
+        8491201703345517361ULL,
+    };
+
+    constexpr uint64_t kBase24[] =
+    {
+        0ULL, 1ULL, 2ULL, 3ULL,
+        4ULL, 5ULL, 6ULL, 7ULL,
+        8ULL, 9ULL, 10ULL, 11ULL,
+        12ULL, 13ULL, 14ULL, 15ULL,
+        16ULL, 17ULL, 18ULL, 19ULL,
+        20ULL, 21ULL, 22ULL, 23ULL,
+        11080ULL, 4404191131ULL, 26773538197998ULL, 751505717327601773ULL,
+    };
+
+    constexpr uint64_t kBase25[] =
+    {
+        0ULL, 1ULL, 2ULL, 3ULL,
+        4ULL, 5ULL, 6ULL, 7ULL,
+        8ULL, 9ULL, 10ULL, 11ULL,
+        12ULL, 13ULL, 14ULL, 15ULL,
+        16ULL, 17ULL, 18ULL, 19ULL,
+        20ULL, 21ULL, 22ULL, 23ULL,
+        24ULL, 313ULL, 338ULL, 855ULL,
+        3500ULL, 3501ULL, 4466ULL, 4782ULL,
+        5425ULL, 5426ULL, 5642ULL, 5767ULL,
+        7568ULL, 12286ULL, 13365ULL, 14707ULL,
+        15280ULL, 72609ULL, 247507ULL, 3724865ULL,
+        4482059ULL, 5698630ULL, 232584666ULL, 918146253ULL,
+        1282735150ULL, 1282735151ULL, 2824940244ULL, 5874277841ULL,
+        5932179884ULL, 86258166307ULL, 87865465666ULL, 127877750181ULL,
+        142593019271ULL, 321699864087ULL, 734498666639ULL, 1790492518307ULL,
+        2719520987282ULL, 2885828034494ULL, 3326493399827ULL, 32196881928372ULL,
+        86921439591972ULL, 164895919167264ULL, 766909150605144ULL, 1654566728268552ULL,
+        1688943008041233ULL, 658614877019954509ULL,
+    };
+
+    constexpr uint64_t kBase26[] =
+    {
+        0ULL, 1ULL, 2ULL, 3ULL,
+        4ULL, 5ULL, 6ULL, 7ULL,
+        8ULL, 9ULL, 10ULL, 11ULL,
+        12ULL, 13ULL, 14ULL, 15ULL,
+        16ULL, 17ULL, 18ULL, 19ULL,
+        20ULL, 21ULL, 22ULL, 23ULL,
+        24ULL, 25ULL, 5425ULL, 587742ULL,
+        1023791ULL, 745070625ULL, 2701641254505ULL, 3274003371727ULL,
+        4291824053367ULL, 22503207366076ULL, 2183819185619084ULL, 2183819185619085ULL,
+        22059568114235845ULL, 26145823354100278ULL, 58019824261958036ULL, 529981717753829394ULL,
+        2384076067170538813ULL,
+    };
+
+    constexpr uint64_t kBase27[] =
+    {
+        0ULL, 1ULL, 2ULL, 3ULL,
+        4ULL, 5ULL, 6ULL, 7ULL,
+        8ULL, 9ULL, 10ULL, 11ULL,
+        12ULL, 13ULL, 14ULL, 15ULL,
+        16ULL, 17ULL, 18ULL, 19ULL,
+        20ULL, 21ULL, 22ULL, 23ULL,
+        24ULL, 25ULL, 26ULL, 90ULL,
+        146ULL, 365ULL, 392ULL, 605ULL,
+        657ULL, 1737ULL, 90624ULL, 148194ULL,
+        832688ULL, 1948860ULL, 1948861ULL, 6822333ULL,
+        6822334ULL, 8714243ULL, 10845970ULL, 12582263ULL,
+        158179117316ULL, 5872859099024ULL, 109270834803173ULL, 3838213542858687ULL,
+        23792768433574360ULL, 82514847508159923ULL, 181088051676007063ULL, 351057703130398053ULL,
+        1106502122360888141ULL, 1537022657728166824ULL, 1608179688622727396ULL, 1668631790859226994ULL,
+        1669045323662715321ULL, 1825293877778269245ULL, 2064403831893396830ULL, 2524793692943542228ULL,
+        2615529458384871374ULL, 2665829575967935832ULL, 2721815748954742614ULL, 2721815748956336937ULL,
+        3468599483804143061ULL, 3494234772091960429ULL, 3657740343210350848ULL, 3688615702947327168ULL,
+        3982995445854357821ULL,
+    };
+
+    constexpr uint64_t kBase28[] =
+    {
+        0ULL, 1ULL, 2ULL, 3ULL,
+        4ULL, 5ULL, 6ULL, 7ULL,
+        8ULL, 9ULL, 10ULL, 11ULL,
+        12ULL, 13ULL, 14ULL, 15ULL,
+        16ULL, 17ULL, 18ULL, 19ULL,
+        20ULL, 21ULL, 22ULL, 23ULL,
+        24ULL, 25ULL, 26ULL, 27ULL,
+        180ULL, 628ULL, 3537ULL, 7588ULL,
+        7589ULL, 7859ULL, 11331ULL, 1546063ULL,
+        1891110ULL, 2049884ULL, 3835677ULL, 4131327ULL,
+        7276568ULL, 252905315ULL, 281259138ULL, 404463595ULL,
+        1033398761ULL, 9311683103ULL, 12481913145ULL, 197745497701ULL,
+        3272578312993ULL, 3721936515223ULL, 8201873872393ULL, 831816588229039ULL,
+        2634597941191061ULL, 3911240022584501ULL, 3955229649196611ULL, 1021318823924233498ULL,
+        1336298713905527349ULL,
+    };
+
+    constexpr uint64_t kBase29[] =
+    {
+        0ULL, 1ULL, 2ULL, 3ULL,
+        4ULL, 5ULL, 6ULL, 7ULL,
+        8ULL, 9ULL, 10ULL, 11ULL,
+        12ULL, 13ULL, 14ULL, 15ULL,
+        16ULL, 17ULL, 18ULL, 19ULL,
+        20ULL, 21ULL, 22ULL, 23ULL,
+        24ULL, 25ULL, 26ULL, 27ULL,
+        28ULL, 421ULL, 450ULL, 3466ULL,
+        4221ULL, 7588ULL, 9358ULL, 12636ULL,
+        13824ULL, 199089ULL, 278179ULL, 589291700ULL,
+        2628802917ULL, 4659860251ULL, 6243201457ULL, 6713178117ULL,
+        6807166381ULL, 10397119585ULL, 10397119586ULL, 10415210013ULL,
+        12010516057ULL, 12843479719ULL, 12843479720ULL, 12897684365ULL,
+        13185187179ULL, 15643547492ULL, 15986396957ULL, 17100714294ULL,
+        1133906615615ULL, 6708658878314ULL, 323650681537850ULL, 237863843499982374ULL,
+        484893397652385715ULL, 2525821537214004310ULL, 2712437645377523893ULL, 2833233347799538485ULL,
+        3571299667922319206ULL, 4402639701786848502ULL, 4760966148901277031ULL, 4760966148901277032ULL,
+        5702583031439128524ULL, 5702583031439128525ULL, 6127962838720839667ULL, 6746628001132366792ULL,
+        6751760530323146690ULL, 6991495491747170196ULL, 7297514244034325420ULL, 7555888912973430271ULL,
+        8109709125681055826ULL, 8109709125681055827ULL, 8998501779947179712ULL, 9922664690717644505ULL,
+    };
+
+    constexpr uint64_t kBase30[] =
+    {
+        0ULL, 1ULL, 2ULL, 3ULL,
+        4ULL, 5ULL, 6ULL, 7ULL,
+        8ULL, 9ULL, 10ULL, 11ULL,
+        12ULL, 13ULL, 14ULL, 15ULL,
+        16ULL, 17ULL, 18ULL, 19ULL,
+        20ULL, 21ULL, 22ULL, 23ULL,
+        24ULL, 25ULL, 26ULL, 27ULL,
+        28ULL, 29ULL, 68ULL, 848ULL,
+        14840ULL, 17451ULL, 301299ULL, 227177852802ULL,
+        545969204083323ULL, 13592851128073513ULL, 202445372785859655ULL, 478530008087598853ULL,
+    };
+
+    constexpr uint64_t kBase31[] =
+    {
+        0ULL, 1ULL, 2ULL, 3ULL,
+        4ULL, 5ULL, 6ULL, 7ULL,
+        8ULL, 9ULL, 10ULL, 11ULL,
+        12ULL, 13ULL, 14ULL, 15ULL,
+        16ULL, 17ULL, 18ULL, 19ULL,
+        20ULL, 21ULL, 22ULL, 23ULL,
+        24ULL, 25ULL, 26ULL, 27ULL,
+        28ULL, 29ULL, 30ULL, 37ULL,
+        325ULL, 481ULL, 512ULL, 666ULL,
+        936ULL, 1002ULL, 1126ULL, 2330ULL,
+        3114ULL, 8793ULL, 10261ULL, 10262ULL,
+        10592ULL, 23085ULL, 26244ULL, 26515ULL,
+        334194ULL, 1436697ULL, 3056485ULL, 3235718ULL,
+        3235719ULL, 3235749ULL, 3235750ULL, 3310693ULL,
+        3310724ULL, 3916706ULL, 6212032ULL, 6839160ULL,
+        6860336ULL, 9030904ULL, 9955560ULL, 10546801ULL,
+        12477201ULL, 14096501ULL, 14617901ULL, 15591303ULL,
+        15591334ULL, 15785603ULL, 15785604ULL, 16973001ULL,
+        17259151ULL, 19265477ULL, 19265478ULL, 19489603ULL,
+        19862733ULL, 22271635ULL, 27114793ULL, 27479837ULL,
+        27479868ULL, 76184275ULL, 516301708ULL, 8077242877ULL,
+        10380235217ULL, 18970185691ULL, 694970977701ULL, 717530789347ULL,
+        1031401825228ULL, 2218774563362ULL, 3871108240888ULL, 6364480578326ULL,
+        7022468201168ULL, 7023572695161ULL, 7717859809685ULL, 7733292300179ULL,
+        8660040934492ULL, 10714207560940ULL, 10714207560941ULL, 11104376987711ULL,
+        11104376987712ULL, 12134314403330ULL, 12367733031775ULL, 12532029999697ULL,
+        12730858902579ULL, 13658859790566ULL, 16498254874762ULL, 16832300948959ULL,
+        20907335363802ULL, 21489524537103ULL, 21835041518421ULL, 21939825935089ULL,
+        25646207033004ULL, 26249844840469ULL, 8302292957097567ULL, 8302292957097568ULL,
+        8355915926532688ULL, 22724467803586419ULL, 24446246627457156ULL, 121087073538090854ULL,
+        974831854731191865ULL, 1161422464200180166ULL, 1755717344589179909ULL, 1875845743579718959ULL,
+        2662173277364560196ULL, 2925681375731562778ULL, 4226514185002505965ULL, 6512118593135705710ULL,
+        6539053602822659244ULL, 7667867336097324868ULL, 8054669341484070012ULL, 9483279648552792957ULL,
+        10263493740254156340ULL, 10361222684002141942ULL, 10937559376247728971ULL, 11405981456945755870ULL,
+        12506159454439926020ULL, 13358912951649368066ULL, 13641622045582317342ULL, 14138124026099889463ULL,
+        16547248203479101470ULL, 17386543233717395174ULL, 17951937935196414436ULL, 18175978677328522248ULL,
+    };
+
+    constexpr uint64_t kBase32[] =
+    {
+        0ULL, 1ULL, 2ULL, 3ULL,
+        4ULL, 5ULL, 6ULL, 7ULL,
+        8ULL, 9ULL, 10ULL, 11ULL,
+        12ULL, 13ULL, 14ULL, 15ULL,
+        16ULL, 17ULL, 18ULL, 19ULL,
+        20ULL, 21ULL, 22ULL, 23ULL,
+        24ULL, 25ULL, 26ULL, 27ULL,
+        28ULL, 29ULL, 30ULL, 31ULL,
+        205ULL, 400ULL, 656ULL, 845ULL,
+        10261ULL, 65552ULL, 69904ULL, 779538ULL,
+        1004643ULL, 457248091ULL, 457510171ULL, 26150464390ULL,
+        537303089793172ULL, 1559898134952086ULL, 1559906724886678ULL, 18052644817757984ULL,
+        18052644817757985ULL, 18157280428738767ULL, 18157280432933071ULL,
+    };
+
+    constexpr uint64_t kBase33[] =
+    {
+        0ULL, 1ULL, 2ULL, 3ULL,
+        4ULL, 5ULL, 6ULL, 7ULL,
+        8ULL, 9ULL, 10ULL, 11ULL,
+        12ULL, 13ULL, 14ULL, 15ULL,
+        16ULL, 17ULL, 18ULL, 19ULL,
+        20ULL, 21ULL, 22ULL, 23ULL,
+        24ULL, 25ULL, 26ULL, 27ULL,
+        28ULL, 29ULL, 30ULL, 31ULL,
+        32ULL, 109ULL, 245ULL, 545ULL,
+        578ULL, 872ULL, 1000ULL, 1457ULL,
+        10502ULL, 28567ULL, 29917ULL, 145219ULL,
+        495538ULL, 959859ULL, 5943413ULL, 7306619ULL,
+        12064393ULL, 21069205ULL, 25401695ULL, 299691284ULL,
+        391723491ULL, 610863357ULL, 4136566338051980ULL, 209087573775498323ULL,
+        643070807830079029ULL,
+    };
+
+    constexpr uint64_t kBase34[] =
+    {
+        0ULL, 1ULL, 2ULL, 3ULL,
+        4ULL, 5ULL, 6ULL, 7ULL,
+        8ULL, 9ULL, 10ULL, 11ULL,
+        12ULL, 13ULL, 14ULL, 15ULL,
+        16ULL, 17ULL, 18ULL, 19ULL,
+        20ULL, 21ULL, 22ULL, 23ULL,
+        24ULL, 25ULL, 26ULL, 27ULL,
+        28ULL, 29ULL, 30ULL, 31ULL,
+        32ULL, 33ULL, 356ULL, 832ULL,
+        6369ULL, 11989ULL, 13498ULL, 13499ULL,
+        13895ULL, 23552ULL, 23628089ULL, 37040299ULL,
+        38493282ULL, 41134598ULL, 42468451ULL, 810788522ULL,
+        942750122ULL, 1299032033ULL, 3559213421ULL, 4439843485556ULL,
+        11454466263699ULL, 64729962150973ULL, 2327276662300978ULL, 6765292891519825ULL,
+        12726631866296158ULL, 12726631866296159ULL, 16044194369384642ULL, 19847404035089624ULL,
+        19847404035089625ULL, 26994334681937265ULL, 37051678534555481ULL, 43265827060211990ULL,
+        47283679827116832ULL, 48305560791193360ULL, 49398834268152034ULL, 53639283281921536ULL,
+        54484906544855190ULL, 64051616335582597ULL, 68725506408751848ULL, 69788331210068292ULL,
+    };
+
+    constexpr uint64_t kBase35[] =
+    {
+        0ULL, 1ULL, 2ULL, 3ULL,
+        4ULL, 5ULL, 6ULL, 7ULL,
+        8ULL, 9ULL, 10ULL, 11ULL,
+        12ULL, 13ULL, 14ULL, 15ULL,
+        16ULL, 17ULL, 18ULL, 19ULL,
+        20ULL, 21ULL, 22ULL, 23ULL,
+        24ULL, 25ULL, 26ULL, 27ULL,
+        28ULL, 29ULL, 30ULL, 31ULL,
+        32ULL, 33ULL, 34ULL, 613ULL,
+        648ULL, 10240ULL, 13498ULL, 879648ULL,
+        1479009ULL, 3020268ULL, 291464275ULL, 927422564ULL,
+        1317106363ULL, 53651089686ULL, 56403092013ULL, 760137161253ULL,
+        1056478282916ULL, 692268021107924ULL, 1892256294588900ULL, 9503718957824933ULL,
+        28443526875169970ULL, 987267752497755494ULL, 1399209108977033587ULL,
+    };
+
+    constexpr uint64_t kBase36[] =
+    {
+        0ULL, 1ULL, 2ULL, 3ULL,
+        4ULL, 5ULL, 6ULL, 7ULL,
+        8ULL, 9ULL, 10ULL, 11ULL,
+        12ULL, 13ULL, 14ULL, 15ULL,
+        16ULL, 17ULL, 18ULL, 19ULL,
+        20ULL, 21ULL, 22ULL, 23ULL,
+        24ULL, 25ULL, 26ULL, 27ULL,
+        28ULL, 29ULL, 30ULL, 31ULL,
+        32ULL, 33ULL, 34ULL, 35ULL,
+        5489ULL, 11160ULL, 11161ULL, 21672ULL,
+        21673ULL, 27566ULL, 30086ULL, 2490026ULL,
+        4340742ULL, 10686334ULL, 11029701ULL, 19011376ULL,
+        30617023ULL, 39644956ULL, 48896274ULL, 48904050ULL,
+        57360548ULL, 59560927ULL, 8983082112ULL, 14170485115ULL,
+        14179587341ULL, 15377154537ULL, 19818940582ULL, 19821767998ULL,
+        36124948564ULL, 54105036451ULL, 56339007427ULL, 57753955689ULL,
+        74506545437ULL, 77470125743ULL, 610364896802ULL, 908029377190ULL,
+        71886521803473ULL, 81537966596467ULL,
+    };
+
+    struct STable
+    {
+        const uint64_t* fValues;
+        size_t fSize;
+    };
+
+    constexpr STable kTables[] =
+    {
+        { nullptr, 0 }, { nullptr, 0 },
+        { kBase2, sizeof( kBase2 ) / sizeof( uint64_t ) },
+        { kBase3, sizeof( kBase3 ) / sizeof( uint64_t ) },
+        { kBase4, sizeof( kBase4 ) / sizeof( uint64_t ) },
+        { kBase5, sizeof( kBase5 ) / sizeof( uint64_t ) },
+        { kBase6, sizeof( kBase6 ) / sizeof( uint64_t ) },
+        { kBase7, sizeof( kBase7 ) / sizeof( uint64_t ) },
+        { kBase8, sizeof( kBase8 ) / sizeof( uint64_t ) },
+        { kBase9, sizeof( kBase9 ) / sizeof( uint64_t ) },
+        { kBase10, sizeof( kBase10 ) / sizeof( uint64_t ) },
+        { kBase11, sizeof( kBase11 ) / sizeof( uint64_t ) },
+        { kBase12, sizeof( kBase12 ) / sizeof( uint64_t ) },
+        { kBase13, sizeof( kBase13 ) / sizeof( uint64_t ) },
+        { kBase14, sizeof( kBase14 ) / sizeof( uint64_t ) },
+        { kBase15, sizeof( kBase15 ) / sizeof( uint64_t ) },
+        { kBase16, sizeof( kBase16 ) / sizeof( uint64_t ) },
+        { kBase17, sizeof( kBase17 ) / sizeof( uint64_t ) },
+        { kBase18, sizeof( kBase18 ) / sizeof( uint64_t ) },
+        { kBase19, sizeof( kBase19 ) / sizeof( uint64_t ) },
+        { kBase20, sizeof( kBase20 ) / sizeof( uint64_t ) },
+        { kBase21, sizeof( kBase21 ) / sizeof( uint64_t ) },
+        { kBase22, sizeof( kBase22 ) / sizeof( uint64_t ) },
+        { kBase23, sizeof( kBase23 ) / sizeof( uint64_t ) },
+        { kBase24, sizeof( kBase24 ) / sizeof( uint64_t ) },
+        { kBase25, sizeof( kBase25 ) / sizeof( uint64_t ) },
+        { kBase26, sizeof( kBase26 ) / sizeof( uint64_t ) },
+        { kBase27, sizeof( kBase27 ) / sizeof( uint64_t ) },
+        { kBase28, sizeof( kBase28 ) / sizeof( uint64_t ) },
+        { kBase29, sizeof( kBase29 ) / sizeof( uint64_t ) },
+        { kBase30, sizeof( kBase30 ) / sizeof( uint64_t ) },
+        { kBase31, sizeof( kBase31 ) / sizeof( uint64_t ) },
+        { kBase32, sizeof( kBase32 ) / sizeof( uint64_t ) },
+        { kBase33, sizeof( kBase33 ) / sizeof( uint64_t ) },
+        { kBase34, sizeof( kBase34 ) / sizeof( uint64_t ) },
+        { kBase35, sizeof( kBase35 ) / sizeof( uint64_t ) },
+        { kBase36, sizeof( kBase36 ) / sizeof( uint64_t ) },
+    };
+
+    constexpr bool hasTable( int base )
+    {
+        return ( base >= 2 ) && ( base <= 36 ) && ( kTables[ base ].fValues != nullptr );
+    }
+
+    constexpr const uint64_t* begin( int base ) { return hasTable( base ) ? kTables[ base ].fValues : nullptr; }
+    constexpr const uint64_t* end( int base ) { return hasTable( base ) ? ( kTables[ base ].fValues + kTables[ base ].fSize ) : nullptr; }
+
+    // first value in the table for base that is >= value
+    constexpr const uint64_t* lowerBound( uint64_t value, int base )
+    {
+        auto first = begin( base );
+        auto count = end( base ) - first;
+        while ( count > 0 )
+        {
+            auto step = count / 2;
+            if ( first[ step ] < value )
+            {
+                first += step + 1;
+                count -= step + 1;
+            }
+            else
+                count = step;
+        }
+        return first;
+    }
+
+    // only meaningful when hasTable( base )
+    constexpr bool isNarcissistic( uint64_t value, int base )
+    {
+        auto pos = lowerBound( value, base );
+        return hasTable( base ) && ( pos != end( base ) ) && ( *pos == value );
+    }
+}
+#endif
@@ -0,0 +1,476 @@
+// The MIT License( MIT )
+//
+// Copyright( c ) 2020 Scott Aron Bloom
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sub-license, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// Offline generator for NarcissisticTable.h
+//
+// Every narcissistic number in base b with k digits is the digit power sum of some
+// multiset of k digits.  Rather than checking every value below 2^64, the generator
+// enumerates the multisets (with pruning on the reachable sum interval and on the
+// leading digits that interval forces) and checks if the power sum has the same digits.
+//
+// Usage: NarcissisticTableGenerator [-out <header>] [-state <file>] [-num_threads <n>] [-min_base <b>] [-max_base <b>]
+//
+// Each (base, digits, leading digit count) task is appended to the state file when it
+// completes, a restarted generator skips all tasks already recorded there.  The header
+// is only written once every task for a base has completed.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+namespace
+{
+    const uint64_t kOverflow = std::numeric_limits< uint64_t >::max();
+
+    uint64_t addSat( uint64_t lhs, uint64_t rhs )
+    {
+        if ( ( lhs == kOverflow ) || ( rhs == kOverflow ) || ( lhs > kOverflow - rhs ) )
+            return kOverflow;
+        return lhs + rhs;
+    }
+
+    uint64_t mulSat( uint64_t lhs, uint64_t rhs )
+    {
+        if ( ( lhs == kOverflow ) || ( rhs == kOverflow ) )
+            return kOverflow;
+        if ( lhs && ( rhs > ( kOverflow - 1 ) / lhs ) )
+            return kOverflow;
+        return lhs * rhs;
+    }
+
+    uint64_t powerSat( uint64_t x, int y )
+    {
+        uint64_t retVal = 1;
+        for ( int ii = 0; ii < y; ++ii )
+            retVal = mulSat( retVal, x );
+        return retVal;
+    }
+
+    // number of digits needed to represent 2^64-1
+    int maxDigits( int base )
+    {
+        int retVal = 0;
+        for ( auto value = kOverflow; value; value /= base )
+            retVal++;
+        return retVal;
+    }
+
+    struct STask
+    {
+        int fBase;
+        int fNumDigits;
+        int fTopCount; // the count of the digit base-1
+
+        std::string key() const
+        {
+            std::ostringstream oss;
+            oss << fBase << " " << fNumDigits << " " << fTopCount;
+            return oss.str();
+        }
+    };
+
+    // finds all narcissistic numbers for a base and digit count
+    class CMultisetSearch
+    {
+    public:
+        CMultisetSearch( int base, int numDigits ) :
+            fBase( base ),
+            fNumDigits( numDigits ),
+            fPowers( base ),
+            fCounts( base, 0 )
+        {
+            for ( int ii = 0; ii < base; ++ii )
+                fPowers[ ii ] = powerSat( ii, numDigits );
+            fLow = ( numDigits == 1 ) ? 0 : powerSat( base, numDigits - 1 );
+            fHigh = powerSat( base, numDigits );
+            fHigh = ( fHigh == kOverflow ) ? ( kOverflow - 1 ) : ( fHigh - 1 );
+        }
+
+        std::vector< uint64_t > run( int topCount )
+        {
+            fFound.clear();
+            if ( topCount > fNumDigits )
+                return fFound;
+
+            auto topDigit = fBase - 1;
+            fCounts[ topDigit ] = topCount;
+            auto sum = mulSat( fPowers[ topDigit ], topCount );
+            if ( sum != kOverflow )
+                recurse( topDigit - 1, fNumDigits - topCount, sum );
+            fCounts[ topDigit ] = 0;
+            std::sort( fFound.begin(), fFound.end() );
+            return fFound;
+        }
+    private:
+        // digits above 'digit' have been decided, sum is their power sum
+        void recurse( int digit, int remaining, uint64_t sum )
+        {
+            if ( !feasible( digit, remaining, sum ) )
+                return;
+
+            if ( digit == 0 || remaining == 0 )
+            {
+                fCounts[ 0 ] = remaining;
+                check( sum );
+                fCounts[ 0 ] = 0;
+                return;
+            }
+
+            for ( int count = remaining; count >= 0; --count )
+            {
+                auto curr = addSat( sum, mulSat( fPowers[ digit ], count ) );
+                if ( curr == kOverflow || curr > fHigh )
+                    continue;
+                fCounts[ digit ] = count;
+                recurse( digit - 1, remaining - count, curr );
+            }
+            fCounts[ digit ] = 0;
+        }
+
+        // digits [0:digit] are still undecided with remaining slots
+        bool feasible( int digit, int remaining, uint64_t sum )
+        {
+            auto maxAdd = ( digit >= 0 ) ? mulSat( fPowers[ digit ], remaining ) : 0;
+            auto low = std::max( sum, fLow );
+            auto high = std::min( addSat( sum, maxAdd ), fHigh );
+            if ( low > high )
+                return false;
+
+            // the digits shared by every value in [low:high] must be in the multiset
+            int lowDigits[ 64 ];
+            int highDigits[ 64 ];
+            toDigits( low, lowDigits );
+            toDigits( high, highDigits );
+
+            int need[ 36 ] = { 0 };
+            int undecided = 0;
+            for ( int ii = fNumDigits - 1; ii >= 0; --ii )
+            {
+                if ( lowDigits[ ii ] != highDigits[ ii ] )
+                    break;
+                auto curr = lowDigits[ ii ];
+                if ( curr > digit )
+                {
+                    if ( ++need[ curr ] > fCounts[ curr ] )
+                        return false;
+                }
+                else if ( ++undecided > remaining )
+                    return false;
+            }
+            return true;
+        }
+
+        void toDigits( uint64_t value, int* digits ) const
+        {
+            for ( int ii = 0; ii < fNumDigits; ++ii )
+            {
+                digits[ ii ] = static_cast< int >( value % fBase );
+                value /= fBase;
+            }
+        }
+
+        void check( uint64_t sum )
+        {
+            if ( ( sum < fLow ) || ( sum > fHigh ) )
+                return;
+
+            int counts[ 36 ] = { 0 };
+            auto value = sum;
+            for ( int ii = 0; ii < fNumDigits; ++ii )
+            {
+                counts[ value % fBase ]++;
+                value /= fBase;
+            }
+            for ( int ii = 0; ii < fBase; ++ii )
+            {
+                if ( counts[ ii ] != fCounts[ ii ] )
+                    return;
+            }
+            fFound.push_back( sum );
+        }
+
+        int fBase;
+        int fNumDigits;
+        uint64_t fLow{ 0 };
+        uint64_t fHigh{ 0 };
+        std::vector< uint64_t > fPowers;
+        std::vector< int > fCounts;
+        std::vector< uint64_t > fFound;
+    };
+
+    // 2^64-1 is excluded from the multiset search (it doubles as the overflow marker)
+    bool isMaxNarcissistic( int base )
+    {
+        auto numDigits = maxDigits( base );
+        uint64_t sum = 0;
+        for ( auto value = kOverflow; value; value /= base )
+        {
+            auto term = powerSat( value % base, numDigits ); // 2^64-1 is not a perfect power
+            if ( ( term == kOverflow ) || ( sum > kOverflow - term ) )
+                return false;
+            sum += term;
+        }
+        return sum == kOverflow;
+    }
+
+    class CGenerator
+    {
+    public:
+        bool parse( int argc, char** argv )
+        {
+            for ( int ii = 1; ii < argc; ++ii )
+            {
+                auto hasValue = ( ii + 1 ) < argc;
+                if ( hasValue && ( strcmp( argv[ ii ], "-out" ) == 0 ) )
+                    fOutFile = argv[ ++ii ];
+                else if ( hasValue && ( strcmp( argv[ ii ], "-state" ) == 0 ) )
+                    fStateFile = argv[ ++ii ];
+                else if ( hasValue && ( strcmp( argv[ ii ], "-num_threads" ) == 0 ) )
+                    fNumThreads = std::max( 1, atoi( argv[ ++ii ] ) );
+                else if ( hasValue && ( strcmp( argv[ ii ], "-min_base" ) == 0 ) )
+                    fMinBase = std::max( 2, atoi( argv[ ++ii ] ) );
+                else if ( hasValue && ( strcmp( argv[ ii ], "-max_base" ) == 0 ) )
+                    fMaxBase = std::min( 36, atoi( argv[ ++ii ] ) );
+                else
+                {
+                    std::cerr << "unknown switch: '" << argv[ ii ] << "'\n";
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        int run()
+        {
+            loadState();
+
+            std::vector< STask > tasks;
+            for ( int base = fMinBase; base <= fMaxBase; ++base )
+            {
+                for ( int numDigits = 1; numDigits <= maxDigits( base ); ++numDigits )
+                {
+                    for ( int topCount = 0; topCount <= numDigits; ++topCount )
+                    {
+                        STask task{ base, numDigits, topCount };
+                        if ( fCompleted.find( task.key() ) == fCompleted.end() )
+                            tasks.push_back( task );
+                    }
+                }
+            }
+            // largest digit counts first, they are the long poles
+            std::stable_sort( tasks.begin(), tasks.end(), []( const STask& lhs, const STask& rhs ) { return std::make_pair( lhs.fNumDigits, lhs.fBase ) > std::make_pair( rhs.fNumDigits, rhs.fBase ); } );
+
+            std::cout << "Tasks remaining: " << tasks.size() << " Threads: " << fNumThreads << std::endl;
+
+            std::atomic< size_t > next{ 0 };
+            std::vector< std::thread > threads;
+            for ( int ii = 0; ii < fNumThreads; ++ii )
+            {
+                threads.emplace_back(
+                    [ this, &tasks, &next ]()
+                    {
+                        for ( auto curr = next++; curr < tasks.size(); curr = next++ )
+                            runTask( tasks[ curr ] );
+                    } );
+            }
+            for ( auto&& ii : threads )
+                ii.join();
+
+            return writeHeader() ? 0 : 1;
+        }
+    private:
+        void runTask( const STask& task )
+        {
+            auto start = std::chrono::steady_clock::now();
+            auto found = CMultisetSearch( task.fBase, task.fNumDigits ).run( task.fTopCount );
+            auto seconds = std::chrono::duration< double >( std::chrono::steady_clock::now() - start ).count();
+
+            std::lock_guard< std::mutex > lock( fMutex );
+            fCompleted.insert( task.key() );
+            for ( auto&& ii : found )
+                fFound[ task.fBase ].insert( ii );
+
+            std::ofstream oss( fStateFile, std::ios::app );
+            oss << task.key();
+            for ( auto&& ii : found )
+                oss << " " << ii;
+            oss << std::endl;
+
+            if ( seconds > 1.0 )
+                std::cout << "Base: " << task.fBase << " Digits: " << task.fNumDigits << " Top Count: " << task.fTopCount << " - " << seconds << "s" << std::endl;
+        }
+
+        void loadState()
+        {
+            std::ifstream iss( fStateFile );
+            std::string line;
+            while ( std::getline( iss, line ) )
+            {
+                std::istringstream lineStream( line );
+                STask task{ 0, 0, 0 };
+                if ( !( lineStream >> task.fBase >> task.fNumDigits >> task.fTopCount ) )
+                    continue;
+                fCompleted.insert( task.key() );
+                uint64_t value;
+                while ( lineStream >> value )
+                    fFound[ task.fBase ].insert( value );
+            }
+        }
+
+        bool baseComplete( int base ) const
+        {
+            for ( int numDigits = 1; numDigits <= maxDigits( base ); ++numDigits )
+            {
+                for ( int topCount = 0; topCount <= numDigits; ++topCount )
+                {
+                    if ( fCompleted.find( STask{ base, numDigits, topCount }.key() ) == fCompleted.end() )
+                        return false;
+                }
+            }
+            return true;
+        }
+
+        bool writeHeader() const
+        {
+            std::ofstream oss( fOutFile );
+            if ( !oss )
+            {
+                std::cerr << "Could not open '" << fOutFile << "' for writing\n";
+                return false;
+            }
+
+            oss
+                << "// Generated by NarcissisticTableGenerator, do not edit.\n"
+                << "//\n"
+                << "// Every narcissistic number below 2^64 for each base with a complete table.\n\n"
+                << "#ifndef __NARCISSISTICTABLE_H\n"
+                << "#define __NARCISSISTICTABLE_H\n\n"
+                << "#include <cstdint>\n"
+                << "#include <cstddef>\n\n"
+                << "namespace NNarcissisticTable\n"
+                << "{\n";
+
+            std::set< int > completeBases;
+            for ( int base = 2; base <= 36; ++base )
+            {
+                auto pos = fFound.find( base );
+                if ( !baseComplete( base ) )
+                    continue;
+                completeBases.insert( base );
+
+                std::set< uint64_t > values;
+                if ( pos != fFound.end() )
+                    values = ( *pos ).second;
+                if ( isMaxNarcissistic( base ) )
+                    values.insert( kOverflow );
+
+                oss << "    constexpr uint64_t kBase" << base << "[] =\n    {";
+                size_t ii = 0;
+                for ( auto&& value : values )
+                {
+                    oss << ( ( ii % 4 ) ? " " : "\n        " ) << value << "ULL,";
+                    ii++;
+                }
+                oss << "\n    };\n\n";
+            }
+
+            oss << "    struct STable\n    {\n        const uint64_t* fValues;\n        size_t fSize;\n    };\n\n";
+            oss << "    constexpr STable kTables[] =\n    {\n        { nullptr, 0 }, { nullptr, 0 },\n";
+            for ( int base = 2; base <= 36; ++base )
+            {
+                if ( completeBases.find( base ) == completeBases.end() )
+                    oss << "        { nullptr, 0 },\n";
+                else
+                    oss << "        { kBase" << base << ", sizeof( kBase" << base << " ) / sizeof( uint64_t ) },\n";
+            }
+            oss << "    };\n\n";
+
+            oss
+                << "    constexpr bool hasTable( int base )\n"
+                << "    {\n"
+                << "        return ( base >= 2 ) && ( base <= 36 ) && ( kTables[ base ].fValues != nullptr );\n"
+                << "    }\n\n"
+                << "    constexpr const uint64_t* begin( int base ) { return hasTable( base ) ? kTables[ base ].fValues : nullptr; }\n"
+                << "    constexpr const uint64_t* end( int base ) { return hasTable( base ) ? ( kTables[ base ].fValues + kTables[ base ].fSize ) : nullptr; }\n\n"
+                << "    // first value in the table for base that is >= value\n"
+                << "    constexpr const uint64_t* lowerBound( uint64_t value, int base )\n"
+                << "    {\n"
+                << "        auto first = begin( base );\n"
+                << "        auto count = end( base ) - first;\n"
+                << "        while ( count > 0 )\n"
+                << "        {\n"
+                << "            auto step = count / 2;\n"
+                << "            if ( first[ step ] < value )\n"
+                << "            {\n"
+                << "                first += step + 1;\n"
+                << "                count -= step + 1;\n"
+                << "            }\n"
+                << "            else\n"
+                << "                count = step;\n"
+                << "        }\n"
+                << "        return first;\n"
+                << "    }\n\n"
+                << "    // only meaningful when hasTable( base )\n"
+                << "    constexpr bool isNarcissistic( uint64_t value, int base )\n"
+                << "    {\n"
+                << "        auto pos = lowerBound( value, base );\n"
+                << "        return hasTable( base ) && ( pos != end( base ) ) && ( *pos == value );\n"
+                << "    }\n"
+                << "}\n"
+                << "#endif\n";
+
+            std::cout << "Wrote tables for " << completeBases.size() << " bases to '" << fOutFile << "'" << std::endl;
+            return true;
+        }
+
+        std::string fOutFile{ "NarcissisticTable.h" };
+        std::string fStateFile{ "NarcissisticTable.state" };
+        int fNumThreads{ static_cast< int >( std::max( 1U, std::thread::hardware_concurrency() ) ) };
+        int fMinBase{ 2 };
+        int fMaxBase{ 36 };
+
+        std::mutex fMutex;
+        std::set< std::string > fCompleted;
+        std::map< int, std::set< uint64_t > > fFound;
+    };
+}
+
+int main( int argc, char** argv )
+{
+    CGenerator generator;
+    if ( !generator.parse( argc, argv ) )
+        return 1;
+    return generator.run();
+}
@@ -0,0 +1,239 @@
+// The MIT License( MIT )
+//
+// Copyright( c ) 2020 Scott Aron Bloom
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sub-license, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "NarcissisticThreadPool.h"
+#include "NarcissisticTrace.h"
+
+#include <algorithm>
+#include <chrono>
+#include <string>
+
+namespace
+{
+    thread_local bool sIdleOnly = false;
+}
+
+CNarcissisticThreadPool& CNarcissisticThreadPool::instance()
+{
+    static CNarcissisticThreadPool sPool;
+    return sPool;
+}
+
+CNarcissisticThreadPool::CNarcissisticThreadPool()
+{
+    ensureWorkers( std::max( 1U, std::thread::hardware_concurrency() ) );
+}
+
+CNarcissisticThreadPool::~CNarcissisticThreadPool()
+{
+    {
+        std::unique_lock< std::mutex > lock( fMutex );
+        fStopping = true;
+    }
+    fWorkAvailable.notify_all();
+    for ( auto&& ii : fWorkers )
+    {
+        if ( ii.joinable() )
+            ii.join();
+    }
+}
+
+void CNarcissisticThreadPool::ensureWorkers( size_t numWorkers )
+{
+    // the workers stuck at idle priority are not counted
+    for ( auto numNormal = numNormalWorkers(); numNormal < numWorkers; ++numNormal )
+    {
+        fIdleOnly.push_back( false );
+        fWorkers.emplace_back( &CNarcissisticThreadPool::workerLoop, this, fWorkers.size() );
+    }
+}
+
+size_t CNarcissisticThreadPool::numNormalWorkers() const
+{
+    return std::count( fIdleOnly.begin(), fIdleOnly.end(), false );
+}
+
+void CNarcissisticThreadPool::setWorkerIdleOnly()
+{
+    sIdleOnly = true;
+}
+
+void CNarcissisticThreadPool::addJob( CNarcissisticJob* job, int priority, double weight, size_t maxConcurrency )
+{
+    {
+        std::unique_lock< std::mutex > lock( fMutex );
+        if ( findJob( job ) )
+            return;
+
+        SJobInfo info;
+        info.fJob = job;
+        info.fPriority = priority;
+        info.fWeight = std::max( weight, 0.001 );
+        info.fMaxConcurrency = std::max< size_t >( maxConcurrency, 1 );
+        // start level with the least served job, so a new job neither starves nor is starved
+        if ( !fJobs.empty() )
+            info.fServed = std::min_element( fJobs.begin(), fJobs.end(), []( const SJobInfo& lhs, const SJobInfo& rhs ) { return lhs.fServed < rhs.fServed; } )->fServed;
+        fJobs.push_back( info );
+
+        ensureWorkers( info.fMaxConcurrency );
+    }
+    fWorkAvailable.notify_all();
+}
+
+void CNarcissisticThreadPool::removeJob( CNarcissisticJob* job )
+{
+    std::unique_lock< std::mutex > lock( fMutex );
+    auto info = findJob( job );
+    if ( !info )
+        return;
+
+    info->fRemoving = true;
+    fJobIdle.wait( lock, [ info ]() { return info->fActive == 0; } );
+    fJobs.remove_if( [ job ]( const SJobInfo& ii ) { return ii.fJob == job; } );
+}
+
+void CNarcissisticThreadPool::setPriority( CNarcissisticJob* job, int priority )
+{
+    {
+        std::unique_lock< std::mutex > lock( fMutex );
+        if ( auto info = findJob( job ) )
+            info->fPriority = priority;
+    }
+    fWorkAvailable.notify_all();
+}
+
+void CNarcissisticThreadPool::setWeight( CNarcissisticJob* job, double weight )
+{
+    std::unique_lock< std::mutex > lock( fMutex );
+    if ( auto info = findJob( job ) )
+        info->fWeight = std::max( weight, 0.001 );
+}
+
+void CNarcissisticThreadPool::setMaxConcurrency( CNarcissisticJob* job, size_t maxConcurrency )
+{
+    {
+        std::unique_lock< std::mutex > lock( fMutex );
+        auto info = findJob( job );
+        if ( !info )
+            return;
+        info->fMaxConcurrency = std::max< size_t >( maxConcurrency, 1 );
+        ensureWorkers( info->fMaxConcurrency );
+    }
+    fWorkAvailable.notify_all();
+}
+
+void CNarcissisticThreadPool::notify()
+{
+    fWorkAvailable.notify_all();
+}
+
+void CNarcissisticThreadPool::setPartitionObserver( const TPartitionObserver& observer )
+{
+    std::unique_lock< std::mutex > lock( fMutex );
+    fPartitionObserver = observer;
+}
+
+size_t CNarcissisticThreadPool::numWorkers() const
+{
+    std::unique_lock< std::mutex > lock( fMutex );
+    return fWorkers.size();
+}
+
+size_t CNarcissisticThreadPool::numActive( const CNarcissisticJob* job ) const
+{
+    std::unique_lock< std::mutex > lock( fMutex );
+    auto info = findJob( job );
+    return info ? info->fActive : 0;
+}
+
+CNarcissisticThreadPool::SJobInfo* CNarcissisticThreadPool::findJob( const CNarcissisticJob* job )
+{
+    for ( auto&& ii : fJobs )
+    {
+        if ( ii.fJob == job )
+            return &ii;
+    }
+    return nullptr;
+}
+
+const CNarcissisticThreadPool::SJobInfo* CNarcissisticThreadPool::findJob( const CNarcissisticJob* job ) const
+{
+    return const_cast< CNarcissisticThreadPool* >( this )->findJob( job );
+}
+
+CNarcissisticThreadPool::SJobInfo* CNarcissisticThreadPool::nextJob( bool idleOnly )
+{
+    SJobInfo* retVal = nullptr;
+    for ( auto&& ii : fJobs )
+    {
+        if ( ii.fRemoving || ( ii.fActive >= ii.fMaxConcurrency ) || ( idleOnly && !ii.fJob->idlePriority() ) || !ii.fJob->hasWork() )
+            continue;
+        if ( !retVal
+            || ( ii.fPriority > retVal->fPriority )
+            || ( ( ii.fPriority == retVal->fPriority ) && ( ii.fServed < retVal->fServed ) ) )
+        {
+            retVal = &ii;
+        }
+    }
+    return retVal;
+}
+
+void CNarcissisticThreadPool::workerLoop( size_t workerNum )
+{
+    CNarcissisticTrace::instance().setThreadName( "worker " + std::to_string( workerNum ) );
+    std::unique_lock< std::mutex > lock( fMutex );
+    auto idleStart = std::chrono::steady_clock::now();
+    while ( true )
+    {
+        SJobInfo* info = nullptr;
+        // hasWork is polled as well, a job may run out of (or gain) work without notifying
+        fWorkAvailable.wait_for( lock, std::chrono::milliseconds( 100 ), [ this, &info, workerNum ]() { return fStopping || ( ( info = nextJob( fIdleOnly[ workerNum ] ) ) != nullptr ); } );
+        if ( fStopping )
+            return;
+        if ( !info )
+            continue;
+        if ( CNarcissisticTrace::instance().enabled() )
+            CNarcissisticTrace::instance().record( CNarcissisticTrace::EKind::eWait, "wait", idleStart, std::chrono::steady_clock::now() );
+
+        info->fActive++;
+        auto observer = fPartitionObserver;
+        lock.unlock();
+
+        if ( observer )
+            observer( workerNum, true );
+        auto start = std::chrono::steady_clock::now();
+        info->fJob->runNextPartition();
+        auto seconds = std::chrono::duration< double >( std::chrono::steady_clock::now() - start ).count();
+        if ( observer )
+            observer( workerNum, false );
+
+        lock.lock();
+        info->fServed += seconds / info->fWeight;
+        info->fActive--;
+        if ( info->fActive == 0 )
+            fJobIdle.notify_all();
+        // a thread started here would inherit the idle priority, the replacement is started by the next addJob
+        if ( sIdleOnly )
+            fIdleOnly[ workerNum ] = true;
+        idleStart = std::chrono::steady_clock::now();
+    }
+}
@@ -0,0 +1,111 @@
+// The MIT License( MIT )
+//
+// Copyright( c ) 2020 Scott Aron Bloom
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sub-license, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef __NARCISSISTICTHREADPOOL_H
+#define __NARCISSISTICTHREADPOOL_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// A unit of work scheduled on the pool one partition at a time
+class CNarcissisticJob
+{
+public:
+    virtual ~CNarcissisticJob() {}
+
+    // called with the pool lock held, must not call back into the pool
+    virtual bool hasWork() const = 0;
+
+    // called on a pool worker, runs a single partition
+    // returns false if there was no partition available
+    virtual bool runNextPartition() = 0;
+
+    // the partitions run at idle priority, the only work given to a worker stuck at idle priority
+    virtual bool idlePriority() const { return false; }
+};
+
+// Process wide pool of persistent workers shared by all the running jobs
+// The highest priority job with work is run next, jobs of the same priority
+// share the workers by weight (the job with the least weighted run time goes next)
+class CNarcissisticThreadPool
+{
+public:
+    static CNarcissisticThreadPool& instance();
+    ~CNarcissisticThreadPool();
+
+    void addJob( CNarcissisticJob* job, int priority, double weight, size_t maxConcurrency );
+    // blocks until none of the jobs partitions are running
+    void removeJob( CNarcissisticJob* job );
+
+    void setPriority( CNarcissisticJob* job, int priority );
+    void setWeight( CNarcissisticJob* job, double weight );
+    void setMaxConcurrency( CNarcissisticJob* job, size_t maxConcurrency );
+
+    // wakes the workers, called when a job has new partitions
+    void notify();
+
+    // called on the worker before and after every partition, used to attribute per thread measurements
+    using TPartitionObserver = std::function< void( size_t workerNum, bool starting ) >;
+    void setPartitionObserver( const TPartitionObserver& observer );
+
+    size_t numWorkers() const;
+    size_t numActive( const CNarcissisticJob* job ) const;
+
+    // called on a worker that could not restore its scheduling priority after an idle priority partition,
+    // the worker only runs idle priority jobs from then on, and is replaced when the next job is added
+    static void setWorkerIdleOnly();
+private:
+    CNarcissisticThreadPool();
+
+    struct SJobInfo
+    {
+        CNarcissisticJob* fJob{ nullptr };
+        int fPriority{ 0 };
+        double fWeight{ 1.0 };
+        size_t fMaxConcurrency{ 1 };
+        size_t fActive{ 0 };
+        double fServed{ 0.0 }; // seconds run, divided by the weight
+        bool fRemoving{ false };
+    };
+
+    void workerLoop( size_t workerNum );
+    void ensureWorkers( size_t numWorkers );
+    SJobInfo* findJob( const CNarcissisticJob* job );
+    const SJobInfo* findJob( const CNarcissisticJob* job ) const;
+    SJobInfo* nextJob( bool idleOnly );
+    size_t numNormalWorkers() const;
+
+    mutable std::mutex fMutex;
+    std::condition_variable fWorkAvailable;
+    std::condition_variable fJobIdle;
+    std::list< SJobInfo > fJobs;
+    std::vector< std::thread > fWorkers;
+    std::vector< bool > fIdleOnly; // per worker
+    TPartitionObserver fPartitionObserver;
+    bool fStopping{ false };
+};
+#endif
@@ -0,0 +1,237 @@
+// The MIT License( MIT )
+//
+// Copyright( c ) 2020 Scott Aron Bloom
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sub-license, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "NarcissisticThrottle.h"
+#include "NarcissisticThreadPool.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <thread>
+
+#ifdef _WIN32
+#include <windows.h>
+#elif defined( __linux__ )
+#include <sched.h>
+#endif
+
+namespace
+{
+    const std::chrono::seconds kAdaptInterval{ 1 };
+    const double kMaxBurstSeconds = 0.5;
+    const double kPressureThreshold = 10.0; // percent of the time some task was stalled on the cpu
+
+    double numCores()
+    {
+        return static_cast< double >( std::max( 1U, std::thread::hardware_concurrency() ) );
+    }
+}
+
+CNarcissisticThrottle::CNarcissisticThrottle()
+{
+    start();
+}
+
+void CNarcissisticThrottle::setRate( double coreSecondsPerSecond )
+{
+    std::unique_lock< std::mutex > lock( fMutex );
+    fRate = std::max( 0.0, coreSecondsPerSecond );
+    fEffectiveRate = fRate;
+}
+
+void CNarcissisticThrottle::setCPUPercent( double percent )
+{
+    setRate( numCores() * percent / 100.0 );
+}
+
+double CNarcissisticThrottle::currentRate() const
+{
+    std::unique_lock< std::mutex > lock( fMutex );
+    return fEffectiveRate;
+}
+
+void CNarcissisticThrottle::start()
+{
+    std::unique_lock< std::mutex > lock( fMutex );
+    fLastRefill = fLastAdapt = std::chrono::steady_clock::now();
+    fTokens = 0.0;
+    fIntervalCandidates = 0;
+    fEffectiveRate = fRate;
+    fLevels.clear();
+}
+
+void CNarcissisticThrottle::stop()
+{
+    std::unique_lock< std::mutex > lock( fMutex );
+    if ( enabled() && fIntervalCandidates )
+        recordLevel( std::chrono::steady_clock::now() );
+}
+
+bool CNarcissisticThrottle::mayRun()
+{
+    if ( !enabled() )
+        return true;
+
+    std::unique_lock< std::mutex > lock( fMutex );
+    refill( std::chrono::steady_clock::now() );
+    return fTokens >= 0.0;
+}
+
+void CNarcissisticThrottle::consumed( const std::chrono::steady_clock::duration& busy, uint64_t numCandidates )
+{
+    // the files are read before taking the lock, at most once per adapt interval
+    auto now = std::chrono::steady_clock::now();
+    double load = -1.0;
+    double pressure = 0.0;
+    if ( enabled() && fAdaptive && adaptDue( now ) )
+    {
+        load = systemLoad();
+        pressure = cpuPressure();
+    }
+
+    std::unique_lock< std::mutex > lock( fMutex );
+    fIntervalCandidates += numCandidates;
+    if ( !enabled() )
+        return;
+    refill( now );
+    fTokens -= std::chrono::duration< double >( busy ).count();
+    adapt( now, load, pressure );
+}
+
+bool CNarcissisticThrottle::adaptDue( const std::chrono::steady_clock::time_point& now ) const
+{
+    std::unique_lock< std::mutex > lock( fMutex );
+    return ( now - fLastAdapt ) >= kAdaptInterval;
+}
+
+void CNarcissisticThrottle::refill( const std::chrono::steady_clock::time_point& now )
+{
+    auto elapsed = std::chrono::duration< double >( now - fLastRefill ).count();
+    fLastRefill = now;
+    fTokens = std::min( fTokens + elapsed * fEffectiveRate, kMaxBurstSeconds * fEffectiveRate );
+}
+
+void CNarcissisticThrottle::adapt( const std::chrono::steady_clock::time_point& now, double load, double pressure )
+{
+    if ( ( now - fLastAdapt ) < kAdaptInterval )
+        return;
+
+    recordLevel( now );
+    if ( !fAdaptive || ( load < 0.0 ) )
+        return;
+
+    // the load less (roughly) our own contribution, plus our rate
+    auto minRate = std::max( 0.05, fRate * 0.05 );
+    auto overloaded = ( ( std::max( 0.0, load - fEffectiveRate ) + fEffectiveRate ) > numCores() ) || ( pressure > kPressureThreshold );
+    if ( overloaded )
+        fEffectiveRate = std::max( minRate, fEffectiveRate * 0.5 );
+    else
+        fEffectiveRate = std::min( fRate, fEffectiveRate * 1.1 );
+}
+
+void CNarcissisticThrottle::recordLevel( const std::chrono::steady_clock::time_point& now )
+{
+    auto&& level = fLevels[ static_cast< int >( fEffectiveRate * 100.0 + 0.5 ) ];
+    level.fSeconds += std::chrono::duration< double >( now - fLastAdapt ).count();
+    level.fCandidates += fIntervalCandidates;
+    fIntervalCandidates = 0;
+    fLastAdapt = now;
+}
+
+// the 1 minute load average, 0 if not available
+double CNarcissisticThrottle::systemLoad()
+{
+    std::ifstream iss( "/proc/loadavg" );
+    double load1 = 0.0;
+    if ( !( iss >> load1 ) )
+        return 0.0;
+    return load1;
+}
+
+// the "some avg10" cpu pressure stall percentage, 0 if PSI is not available
+double CNarcissisticThrottle::cpuPressure()
+{
+    std::ifstream iss( "/proc/pressure/cpu" );
+    std::string line;
+    while ( std::getline( iss, line ) )
+    {
+        if ( line.compare( 0, 5, "some " ) != 0 )
+            continue;
+        auto pos = line.find( "avg10=" );
+        if ( pos != std::string::npos )
+            return atof( line.c_str() + pos + 6 );
+    }
+    return 0.0;
+}
+
+std::string CNarcissisticThrottle::report() const
+{
+    std::unique_lock< std::mutex > lock( fMutex );
+    std::ostringstream oss;
+    for ( auto&& ii : fLevels )
+    {
+        if ( ii.second.fSeconds <= 0.0 )
+            continue;
+        oss << "Throttle " << std::fixed << std::setprecision( 2 ) << ii.first / 100.0 << " cores: "
+            << std::setprecision( 0 ) << ii.second.fCandidates / ii.second.fSeconds << " candidates/s over "
+            << std::setprecision( 1 ) << ii.second.fSeconds << "s\n";
+    }
+    return oss.str();
+}
+
+CNarcissisticThrottle::CIdlePriorityScope::CIdlePriorityScope( bool enabled )
+{
+    if ( !enabled )
+        return;
+#ifdef _WIN32
+    fPrevPriority = GetThreadPriority( GetCurrentThread() );
+    fChanged = SetThreadPriority( GetCurrentThread(), THREAD_PRIORITY_IDLE ) != 0;
+#elif defined( __linux__ )
+    // with a pid of 0 only the calling thread is changed
+    sched_param param;
+    fPrevPolicy = sched_getscheduler( 0 );
+    if ( ( fPrevPolicy < 0 ) || ( sched_getparam( 0, &param ) != 0 ) )
+        return;
+    fPrevPriority = param.sched_priority;
+    param.sched_priority = 0;
+    fChanged = sched_setscheduler( 0, SCHED_IDLE, &param ) == 0;
+#endif
+}
+
+CNarcissisticThrottle::CIdlePriorityScope::~CIdlePriorityScope()
+{
+    if ( !fChanged )
+        return;
+    bool restored = true;
+#ifdef _WIN32
+    restored = SetThreadPriority( GetCurrentThread(), fPrevPriority ) != 0;
+#elif defined( __linux__ )
+    // leaving SCHED_IDLE is only allowed for unprivileged threads within RLIMIT_NICE
+    sched_param param;
+    param.sched_priority = fPrevPriority;
+    restored = sched_setscheduler( 0, fPrevPolicy, &param ) == 0;
+#endif
+    if ( !restored )
+        CNarcissisticThreadPool::setWorkerIdleOnly();
+}
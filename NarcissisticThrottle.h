@@ -0,0 +1,98 @@
+// The MIT License( MIT )
+//
+// Copyright( c ) 2020 Scott Aron Bloom
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sub-license, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#ifndef __NARCISSISTICTHROTTLE_H
+#define __NARCISSISTICTHROTTLE_H
+
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+
+// Caps a job at a rate of core-seconds per second, the job only takes a new partition while
+// the token bucket is not in debt, so the workers are duty cycled between partitions
+// When adaptive, the rate is halved while the rest of the system is overloaded (load average
+// above the number of cores, or the cpu pressure stall above 10%) and recovers slowly after
+class CNarcissisticThrottle
+{
+public:
+    CNarcissisticThrottle();
+
+    void setRate( double coreSecondsPerSecond ); // 0 disables the throttle
+    void setCPUPercent( double percent ); // percentage of all the cores
+    void setAdaptive( bool value ){ fAdaptive = value; }
+    void setIdlePriority( bool value ){ fIdlePriority = value; }
+
+    bool enabled() const { return fRate > 0.0; }
+    bool idlePriority() const { return fIdlePriority; }
+    double currentRate() const;
+
+    void start();
+    void stop(); // records the throughput of the final interval
+    bool mayRun(); // only the cached state, called with the job and pool locks held
+    // called on the worker after a partition, without any locks held, the system load is read here
+    void consumed( const std::chrono::steady_clock::duration& busy, uint64_t numCandidates );
+
+    // candidates per second at each throttle level, for capacity planning
+    std::string report() const;
+
+    // lowers the calling threads scheduling priority (SCHED_IDLE on linux) for its lifetime
+    // if the priority can not be restored (leaving SCHED_IDLE needs RLIMIT_NICE or privileges), a pool
+    // worker is marked so it only runs idle priority jobs from then on
+    class CIdlePriorityScope
+    {
+    public:
+        CIdlePriorityScope( bool enabled );
+        ~CIdlePriorityScope();
+    private:
+        bool fChanged{ false };
+        int fPrevPolicy{ 0 };
+        int fPrevPriority{ 0 };
+    };
+private:
+    void refill( const std::chrono::steady_clock::time_point& now ); // fMutex must be held
+    bool adaptDue( const std::chrono::steady_clock::time_point& now ) const;
+    void adapt( const std::chrono::steady_clock::time_point& now, double load, double pressure ); // fMutex must be held, a negative load was not read
+    void recordLevel( const std::chrono::steady_clock::time_point& now ); // fMutex must be held
+    static double systemLoad();
+    static double cpuPressure();
+
+    mutable std::mutex fMutex;
+    double fRate{ 0.0 };
+    double fEffectiveRate{ 0.0 };
+    double fTokens{ 0.0 }; // core-seconds
+    bool fAdaptive{ false };
+    bool fIdlePriority{ false };
+    std::chrono::steady_clock::time_point fLastRefill;
+    std::chrono::steady_clock::time_point fLastAdapt;
+    uint64_t fIntervalCandidates{ 0 };
+
+    struct SLevel
+    {
+        double fSeconds{ 0.0 };
+        uint64_t fCandidates{ 0 };
+    };
+    std::map< int, SLevel > fLevels; // by the effective rate in hundredths of a core
+};
+#endif
@@ -0,0 +1,182 @@
+// The MIT License( MIT )
+//
+// Copyright( c ) 2020 Scott Aron Bloom
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sub-license, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "NarcissisticTrace.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+namespace
+{
+    thread_local std::shared_ptr< void > sThreadBuffer; // keeps the buffer of an exited thread alive until it is written
+    thread_local std::string sThreadName;
+}
+
+CNarcissisticTrace& CNarcissisticTrace::instance()
+{
+    static CNarcissisticTrace sInstance;
+    return sInstance;
+}
+
+void CNarcissisticTrace::start( size_t eventsPerThread )
+{
+    std::unique_lock< std::mutex > lock( fMutex );
+    fEventsPerThread = std::max< size_t >( 1, eventsPerThread );
+    fStart = std::chrono::steady_clock::now();
+    // buffers of threads that have since exited are dropped, live threads reset theirs on the next record
+    fBuffers.remove_if( []( const std::shared_ptr< SThreadBuffer >& ii ) { return ii.use_count() == 1; } );
+    fGeneration++;
+    fEnabled = true;
+}
+
+void CNarcissisticTrace::stop()
+{
+    fEnabled = false;
+}
+
+void CNarcissisticTrace::setThreadName( const std::string& name )
+{
+    sThreadName = name;
+    if ( auto buffer = std::static_pointer_cast< SThreadBuffer >( sThreadBuffer ) )
+    {
+        std::unique_lock< std::mutex > lock( fMutex );
+        buffer->fName = name;
+    }
+}
+
+CNarcissisticTrace::SThreadBuffer* CNarcissisticTrace::threadBuffer()
+{
+    auto buffer = std::static_pointer_cast< SThreadBuffer >( sThreadBuffer );
+    if ( !buffer )
+    {
+        buffer = std::make_shared< SThreadBuffer >();
+        sThreadBuffer = buffer;
+
+        std::unique_lock< std::mutex > lock( fMutex );
+        buffer->fThreadNum = fBuffers.size() + 1;
+        buffer->fName = sThreadName.empty() ? ( "thread " + std::to_string( buffer->fThreadNum ) ) : sThreadName;
+        fBuffers.push_back( buffer );
+    }
+
+    auto generation = fGeneration.load();
+    if ( buffer->fGeneration != generation )
+    {
+        buffer->fEvents.assign( fEventsPerThread, SEvent() );
+        buffer->fNumRecorded = 0;
+        buffer->fGeneration = generation;
+    }
+    return buffer.get();
+}
+
+void CNarcissisticTrace::record( EKind kind, const char* name, const std::chrono::steady_clock::time_point& start, const std::chrono::steady_clock::time_point& end, uint64_t arg0, uint64_t arg1, uint64_t arg2 )
+{
+    if ( !enabled() )
+        return;
+
+    auto buffer = threadBuffer();
+    auto&& event = buffer->fEvents[ buffer->fNumRecorded % buffer->fEvents.size() ];
+    event.fKind = kind;
+    event.fName = name;
+    event.fStart = static_cast< uint64_t >( std::max< int64_t >( 0, std::chrono::duration_cast< std::chrono::nanoseconds >( start - fStart ).count() ) );
+    event.fDuration = static_cast< uint64_t >( std::max< int64_t >( 0, std::chrono::duration_cast< std::chrono::nanoseconds >( end - start ).count() ) );
+    event.fArgs[ 0 ] = arg0;
+    event.fArgs[ 1 ] = arg1;
+    event.fArgs[ 2 ] = arg2;
+    buffer->fNumRecorded.fetch_add( 1, std::memory_order_release );
+}
+
+std::string CNarcissisticTrace::toJSON() const
+{
+    std::ostringstream oss;
+    oss << std::fixed << std::setprecision( 3 );
+    oss << "{\n\"displayTimeUnit\": \"ns\",\n\"traceEvents\": [\n";
+
+    bool first = true;
+    auto separator = [ &oss, &first ]()
+    {
+        if ( !first )
+            oss << ",\n";
+        first = false;
+    };
+
+    std::unique_lock< std::mutex > lock( fMutex );
+    auto generation = fGeneration.load();
+    for ( auto&& buffer : fBuffers )
+    {
+        if ( buffer->fGeneration != generation )
+            continue;
+
+        separator();
+        oss << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << buffer->fThreadNum << ", \"args\": {\"name\": \"" << buffer->fName << "\"}}";
+
+        // the ring buffer has overwritten the oldest events once it wraps
+        uint64_t numRecorded = buffer->fNumRecorded.load( std::memory_order_acquire );
+        uint64_t size = buffer->fEvents.size();
+        auto firstEvent = ( numRecorded > size ) ? ( numRecorded - size ) : 0;
+        for ( auto ii = firstEvent; ii < numRecorded; ++ii )
+        {
+            auto&& event = buffer->fEvents[ ii % size ];
+            separator();
+            oss
+                << "{\"name\": \"" << event.fName << "\", \"ph\": \"X\", \"pid\": 1, \"tid\": " << buffer->fThreadNum
+                << ", \"ts\": " << event.fStart / 1000.0 << ", \"dur\": " << event.fDuration / 1000.0;
+            switch ( event.fKind )
+            {
+                case EKind::ePartition:
+                    oss << ", \"cat\": \"partition\", \"args\": {\"first\": " << event.fArgs[ 0 ] << ", \"end\": " << event.fArgs[ 1 ] << ", \"candidates\": " << event.fArgs[ 2 ] << "}";
+                    break;
+                case EKind::eWait:
+                    oss << ", \"cat\": \"wait\"";
+                    break;
+                case EKind::eLock:
+                    oss << ", \"cat\": \"lock\", \"args\": {\"wait_ns\": " << event.fArgs[ 0 ] << "}";
+                    break;
+                case EKind::eResult:
+                    oss << ", \"cat\": \"result\", \"args\": {\"value\": " << event.fArgs[ 0 ] << "}";
+                    break;
+            }
+            oss << "}";
+        }
+    }
+    oss << "\n]\n}\n";
+    return oss.str();
+}
+
+bool CNarcissisticTrace::write( const std::string& fileName, std::string& errorMsg ) const
+{
+    std::ofstream ofs( fileName );
+    if ( !ofs )
+    {
+        errorMsg = "Could not open '" + fileName + "' for writing";
+        return false;
+    }
+    ofs << toJSON();
+    if ( !ofs )
+    {
+        errorMsg = "Could not write '" + fileName + "'";
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,161 @@
+// The MIT License( MIT )
+//
+// Copyright( c ) 2020 Scott Aron Bloom
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sub-license, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#ifndef __NARCISSISTICTRACE_H
+#define __NARCISSISTICTRACE_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Optional timeline of the run, written as Chrome trace event JSON (chrome://tracing or ui.perfetto.dev)
+// Every thread records into its own fixed size ring buffer, so tracing never allocates or locks on the
+// hot path, and costs a single atomic load when disabled.  Names must be string literals.
+class CNarcissisticTrace
+{
+public:
+    enum class EKind
+    {
+        ePartition, // arg0 = first value, arg1 = end value (one past the last), arg2 = candidates checked
+        eWait,      // a pool worker waiting for a partition
+        eLock,      // arg0 = nanoseconds waiting for the lock, the span is the time it was held
+        eResult     // arg0 = the value
+    };
+
+    static CNarcissisticTrace& instance();
+
+    void start( size_t eventsPerThread = kDefaultEventsPerThread );
+    void stop();
+    bool enabled() const { return fEnabled.load( std::memory_order_relaxed ); }
+
+    void setThreadName( const std::string& name ); // for the calling thread
+    void record( EKind kind, const char* name, const std::chrono::steady_clock::time_point& start, const std::chrono::steady_clock::time_point& end, uint64_t arg0 = 0, uint64_t arg1 = 0, uint64_t arg2 = 0 );
+
+    bool write( const std::string& fileName, std::string& errorMsg ) const;
+    std::string toJSON() const;
+
+    static const size_t kDefaultEventsPerThread{ 1 << 16 };
+
+    // a span from construction to destruction
+    class CScope
+    {
+    public:
+        CScope( EKind kind, const char* name ) :
+            fKind( kind ),
+            fName( name ),
+            fEnabled( CNarcissisticTrace::instance().enabled() )
+        {
+            if ( fEnabled )
+                fStart = std::chrono::steady_clock::now();
+        }
+        ~CScope()
+        {
+            if ( fEnabled )
+                CNarcissisticTrace::instance().record( fKind, fName, fStart, std::chrono::steady_clock::now(), fArgs[ 0 ], fArgs[ 1 ], fArgs[ 2 ] );
+        }
+        void setArgs( uint64_t arg0, uint64_t arg1 = 0, uint64_t arg2 = 0 ) { fArgs[ 0 ] = arg0; fArgs[ 1 ] = arg1; fArgs[ 2 ] = arg2; }
+    private:
+        EKind fKind;
+        const char* fName;
+        bool fEnabled;
+        std::chrono::steady_clock::time_point fStart;
+        uint64_t fArgs[ 3 ]{ 0, 0, 0 };
+    };
+
+    // a std::unique_lock that records its wait and hold time
+    // the wait is also added to totalWaitNanos (with totalAcquisitions incremented) when they are given
+    template< typename T >
+    class CLock
+    {
+    public:
+        CLock( T& mutex, const char* name, std::atomic< uint64_t >* totalWaitNanos = nullptr, std::atomic< uint64_t >* totalAcquisitions = nullptr ) :
+            fName( name ),
+            fEnabled( CNarcissisticTrace::instance().enabled() )
+        {
+            if ( fEnabled || totalWaitNanos )
+            {
+                auto request = std::chrono::steady_clock::now();
+                fLock = std::unique_lock< T >( mutex );
+                fAcquired = std::chrono::steady_clock::now();
+                fWaitNanos = static_cast< uint64_t >( std::chrono::duration_cast< std::chrono::nanoseconds >( fAcquired - request ).count() );
+                if ( totalWaitNanos )
+                    totalWaitNanos->fetch_add( fWaitNanos, std::memory_order_relaxed );
+                if ( totalAcquisitions )
+                    totalAcquisitions->fetch_add( 1, std::memory_order_relaxed );
+            }
+            else
+                fLock = std::unique_lock< T >( mutex );
+        }
+        ~CLock()
+        {
+            if ( fEnabled && fLock.owns_lock() )
+            {
+                auto released = std::chrono::steady_clock::now();
+                fLock.unlock();
+                CNarcissisticTrace::instance().record( EKind::eLock, fName, fAcquired, released, fWaitNanos );
+            }
+        }
+        std::unique_lock< T >& lock() { return fLock; }
+    private:
+        const char* fName;
+        bool fEnabled;
+        std::unique_lock< T > fLock;
+        std::chrono::steady_clock::time_point fAcquired;
+        uint64_t fWaitNanos{ 0 };
+    };
+private:
+    CNarcissisticTrace() {}
+
+    struct SEvent
+    {
+        EKind fKind;
+        const char* fName;
+        uint64_t fStart; // nanoseconds from start()
+        uint64_t fDuration;
+        uint64_t fArgs[ 3 ];
+    };
+
+    struct SThreadBuffer
+    {
+        size_t fThreadNum{ 0 };
+        std::string fName;
+        uint64_t fGeneration{ 0 }; // the start() the events belong to
+        std::vector< SEvent > fEvents;
+        std::atomic< uint64_t > fNumRecorded{ 0 }; // the next slot is fNumRecorded % fEvents.size()
+    };
+    SThreadBuffer* threadBuffer();
+
+    std::atomic< bool > fEnabled{ false };
+    std::atomic< uint64_t > fGeneration{ 0 };
+    size_t fEventsPerThread{ kDefaultEventsPerThread };
+    std::chrono::steady_clock::time_point fStart;
+
+    mutable std::mutex fMutex; // guards fBuffers, only taken the first time a thread records
+    std::list< std::shared_ptr< SThreadBuffer > > fBuffers;
+};
+#endif
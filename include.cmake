@@ -20,18 +20,72 @@
 # OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 # SOFTWARE.
 
+set(project_SRCS
+    NarcissisticIndex.cpp
+    NarcissisticEngine.cpp
+    NarcissisticThreadPool.cpp
+    NarcissisticThrottle.cpp
+    NarcissisticStats.cpp
+    NarcissisticTrace.cpp
+    NarcissisticMetrics.cpp
+    NarcissisticMetricsServer.cpp
+    NarcissisticOrbits.cpp
+    NarcissisticShard.cpp
+    NarcissisticEnergy.cpp
+)
+
 set(qtproject_SRCS
     main.cpp    
     NarcissisticNumCalculator.cpp
     NarcissisticNumbers.cpp
+    NarcissisticDaemon.cpp
 )
 
 set(qtproject_H
     NarcissisticNumbers.h
+    NarcissisticDaemon.h
 )
 
 set(project_H
     NarcissisticNumCalculator.h
+    NarcissisticIndex.h
+    NarcissisticEngine.h
+    NarcissisticThreadPool.h
+    NarcissisticThrottle.h
+    NarcissisticStats.h
+    NarcissisticTrace.h
+    NarcissisticMetrics.h
+    NarcissisticMetricsServer.h
+    NarcissisticOrbits.h
+    NarcissisticShard.h
+    NarcissisticEnergy.h
+    NarcissisticTable.h
+)
+
+set(perfbench_SRCS
+    NarcissisticPerfBench.cpp
+    NarcissisticPerfCounters.cpp
+)
+
+set(perfbench_H
+    NarcissisticPerfCounters.h
+)
+
+set(bench_SRCS
+    NarcissisticBench.cpp
+)
+
+set(client_SRCS
+    NarcissisticClient.cpp
+)
+
+set(library_SRCS
+    NarcissisticNumCalculator.cpp
+    NarcissisticSearch.cpp
+)
+
+set(library_H
+    NarcissisticSearch.h
 )
 
 set(qtproject_UIS
@@ -22,6 +22,8 @@
 
 #include "NarcissisticNumbers.h"
 #include "NarcissisticNumCalculator.h"
+#include "NarcissisticDaemon.h"
+#include "NarcissisticMetricsServer.h"
 #include "SABUtils/utils.h"
 
 #include <QApplication>
@@ -30,6 +32,7 @@
 #include <iomanip>
 #include <vector>
 #include <cmath>
+#include <cstring>
 
 using TPowerFunc = std::function< uint64_t( uint64_t, uint64_t ) >;
 using TRunTime = std::tuple< TPowerFunc, std::chrono::system_clock::duration, int, std::string, int >;
@@ -89,6 +92,14 @@ void reportTimes( const std::vector<TRunTime>& runTimes )
     reportTimes( runTimes, runTimes.size() - 1 );
 }
 
+void initApplication( QCoreApplication& appl )
+{
+    appl.setOrganizationDomain( "http://towel42.com" );
+    appl.setOrganizationName( "Scott Aron Bloom" );
+    appl.setApplicationName( "Narcissistic Number Calculator" );
+    appl.setApplicationVersion( "1.0.0" );
+}
+
 int main( int argc, char** argv )
 {
     //CNarcissisticNumCalculator values;
@@ -123,11 +134,46 @@ int main( int argc, char** argv )
 
     //reportTimes( runTimes );
 
+    // -daemon [<name>] [-no_table] serves queries on a local socket until killed
+    if ( ( argc > 1 ) && ( strcmp( argv[ 1 ], "-daemon" ) == 0 ) )
+    {
+        QCoreApplication appl( argc, argv );
+        initApplication( appl );
+        auto serverName = CNarcissisticDaemon::defaultServerName();
+        bool useKnownTable = true;
+        for ( int ii = 2; ii < argc; ++ii )
+        {
+            if ( strcmp( argv[ ii ], "-no_table" ) == 0 )
+                useKnownTable = false;
+            else
+                serverName = QString::fromLocal8Bit( argv[ ii ] );
+        }
+        CNarcissisticDaemon daemon( useKnownTable );
+        if ( !daemon.listen( serverName ) )
+        {
+            std::cerr << "Could not listen on '" << serverName.toStdString() << "': " << daemon.errorString().toStdString() << "\n";
+            return 1;
+        }
+        std::cout << "Listening on '" << serverName.toStdString() << "'" << std::endl;
+        return appl.exec();
+    }
+
+    // any command line switches run the calculator without the dialog
+    if ( argc > 1 )
+    {
+        QCoreApplication appl( argc, argv );
+        initApplication( appl );
+        CNarcissisticNumCalculator values( false );
+        if ( !values.parse( argc, argv ) )
+            return 1;
+        CNarcissisticNumCalculator::enableSignalHandling();
+        values.run();
+        CNarcissisticMetricsServer::instance().close(); // its thread and server must go before the application does
+        return values.shardFailed() ? 1 : 0;
+    }
+
     QApplication appl( argc, argv );
-    appl.setOrganizationDomain( "http://towel42.com" );
-    appl.setOrganizationName( "Scott Aron Bloom" );
-    appl.setApplicationName( "Narcissistic Number Calculator" );
-    appl.setApplicationVersion( "1.0.0" );
+    initApplication( appl );
     Q_INIT_RESOURCE( application );
     CNarcissisticNumbers calc;
     return calc.exec();